@@ -60,6 +60,7 @@ public class Parameters extends ParameterComponent {
   public final LiteraryBrailleTableParameter literaryBrailleTable;
   public final MessageLocaleParameter messageLocale;
   public final DriverPropertyValueParameter driverPropertyValue;
+  public final PerformanceStatisticsParameter performanceStatistics;
 
   public Parameters (ConnectionBase connection) {
     super();
@@ -97,6 +98,7 @@ public class Parameters extends ParameterComponent {
     literaryBrailleTable = new LiteraryBrailleTableParameter(connection);
     messageLocale = new MessageLocaleParameter(connection);
     driverPropertyValue = new DriverPropertyValueParameter(connection);
+    performanceStatistics = new PerformanceStatisticsParameter(connection);
   }
 
   private final Parameter[] newParameterArray () {
@@ -590,6 +590,7 @@ typedef struct {
 
   int (*readCommand) (BrailleDisplay *brl);
   int (*writeBraille) (BrailleDisplay *brl, const unsigned char *cells, int start, int count);
+  unsigned char writeOverhead; /* bytes of framing per writeBraille packet */
 } ProtocolOperations;
 static const ProtocolOperations *protocol;
 
@@ -1162,7 +1163,8 @@ static const ProtocolOperations protocol1Operations = {
   .detectModel = detectModel1,
 
   .readCommand = readCommand1,
-  .writeBraille = writeBraille1
+  .writeBraille = writeBraille1,
+  .writeOverhead = 6
 };
 
 static void
@@ -1647,7 +1649,8 @@ static const ProtocolOperations protocol2sOperations = {
   .detectModel = detectModel2s,
 
   .readCommand = readCommand2s,
-  .writeBraille = writeBraille2s
+  .writeBraille = writeBraille2s,
+  .writeOverhead = 4
 };
 
 static BraillePacketVerifierResult
@@ -1840,7 +1843,8 @@ static const ProtocolOperations protocol2uOperations = {
   .detectModel = detectModel2u,
 
   .readCommand = readCommand2u,
-  .writeBraille = writeBraille2u
+  .writeBraille = writeBraille2u,
+  .writeOverhead = 3
 };
 
 static BrailleDisplay *brailleDisplay = NULL;
@@ -1994,10 +1998,16 @@ brl_destruct (BrailleDisplay *brl) {
 
 static int
 brl_writeWindow (BrailleDisplay *brl, const wchar_t *text) {
-  unsigned int from;
-  unsigned int to;
+  CellRange ranges[4];
+  unsigned int rangeCount = getChangedCellRanges(
+    previousText, brl->buffer, brl->textColumns,
+    ranges, ((model->flags & MOD_FLAG_FORCE_FROM_0)? 1: ARRAY_COUNT(ranges)),
+    protocol->writeOverhead, &textRewriteRequired
+  );
 
-  if (cellsHaveChanged(previousText, brl->buffer, brl->textColumns, &from, &to, &textRewriteRequired)) {
+  for (unsigned int index=0; index<rangeCount; index+=1) {
+    unsigned int from = ranges[index].from;
+    unsigned int to = ranges[index].to;
     if (model->flags & MOD_FLAG_FORCE_FROM_0) from = 0;
 
     {
@@ -383,6 +383,7 @@ typedef struct {
 
   int (*writeCells) (BrailleDisplay *brl);
   int (*writeCellRange) (BrailleDisplay *brl, unsigned int start, unsigned int count);
+  unsigned char writeOverhead; /* cells' worth of framing per partial write (0 if none) */
 } ProtocolOperations;
 
 struct BrailleDataStruct {
@@ -518,11 +519,17 @@ clearCellRange (BrailleDisplay *brl, unsigned int start, unsigned int count) {
 
 static int
 putCells (BrailleDisplay *brl, const unsigned char *cells, unsigned int start, unsigned int count) {
-  unsigned int from;
-  unsigned int to;
-
-  if (cellsHaveChanged(&internalCells[start], cells, count, &from, &to, NULL)) {
-    if (!updateCellRange(brl, start+from, to-from)) return 0;
+  unsigned int overhead = brl->data->protocol->writeOverhead;
+  CellRange ranges[4];
+  unsigned int rangeCount = getChangedCellRanges(
+    &internalCells[start], cells, count,
+    ranges, (overhead? ARRAY_COUNT(ranges): 1),
+    overhead, NULL
+  );
+
+  for (unsigned int index=0; index<rangeCount; index+=1) {
+    const CellRange *range = &ranges[index];
+    if (!updateCellRange(brl, start+range->from, range->to-range->from)) return 0;
   }
 
   return 1;
@@ -2888,32 +2895,35 @@ processPowerBraillePackets (BrailleDisplay *brl) {
 
 static int
 writePowerBrailleCells (BrailleDisplay *brl) {
-  unsigned char packet[6 + (brl->textColumns * 2)];
+  return 1;
+}
+
+static int
+writePowerBrailleCellRange (BrailleDisplay *brl, unsigned int start, unsigned int count) {
+  if (start >= brl->textColumns) return 1;
+  if (count > (brl->textColumns - start)) count = brl->textColumns - start;
+
+  unsigned char packet[6 + (count * 2)];
   unsigned char *byte = packet;
 
   *byte++ = PB_REQ_WRITE;
   *byte++ = 0; /* cursor mode: disabled */
   *byte++ = 0; /* cursor position: nowhere */
   *byte++ = 1; /* cursor type: command */
-  *byte++ = brl->textColumns * 2; /* attribute-data pairs */
-  *byte++ = 0; /* start */
+  *byte++ = count * 2; /* attribute-data pairs */
+  *byte++ = start;
 
   {
-    int i;
-    for (i=0; i<brl->textColumns; ++i) {
+    unsigned int i;
+    for (i=0; i<count; ++i) {
       *byte++ = 0; /* attributes */
-      *byte++ = externalCells[i]; /* data */
+      *byte++ = externalCells[start + i]; /* data */
     }
   }
 
   return writePowerBraillePacket(brl, packet, byte-packet);
 }
 
-static int
-writePowerBrailleCellRange (BrailleDisplay *brl, unsigned int start, unsigned int count) {
-  return 1;
-}
-
 static const ProtocolOperations powerBrailleOperations = {
   .name = "PowerBraille",
   .dotsTable = &dotsTable_ISO11548_1,
@@ -2928,7 +2938,8 @@ static const ProtocolOperations powerBrailleOperations = {
   .processPackets = processPowerBraillePackets,
 
   .writeCells = writePowerBrailleCells,
-  .writeCellRange = writePowerBrailleCellRange
+  .writeCellRange = writePowerBrailleCellRange,
+  .writeOverhead = 4 /* 8 framing bytes at 2 bytes per cell */
 };
 
 /* Driver Handlers */
@@ -3008,6 +3019,7 @@ connectResource (BrailleDisplay *brl, const char *identifier) {
       .vendor=0X0483, .product=0XA1D3,
       .configuration=1, .interface=0, .alternative=0,
       .inputEndpoint=1, .outputEndpoint=1,
+      .outputQueueLimit=0X100,
       .data=&baumHid1Operations,
     },
 
@@ -3015,6 +3027,7 @@ connectResource (BrailleDisplay *brl, const char *identifier) {
       .vendor=0X0483, .product=0Xa366,
       .configuration=1, .interface=0, .alternative=0,
       .inputEndpoint=1, .outputEndpoint=1,
+      .outputQueueLimit=0X100,
       .data=&baumHid1Operations,
     },
 
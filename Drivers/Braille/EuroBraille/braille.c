@@ -398,7 +398,7 @@ brl_construct (BrailleDisplay *brl, char **parameters, const char *device) {
       const ProtocolOperations *const *p = protocols;
 
       while (*p) {
-        const ProtocolOperations *protocol = *p++;
+        protocol = *p++;
 
         logMessage(LOG_CATEGORY(BRAILLE_DRIVER),
           "trying protocol: %s",
@@ -408,6 +408,8 @@ brl_construct (BrailleDisplay *brl, char **parameters, const char *device) {
         if (protocol->initializeDevice(brl)) return 1;
 	asyncWait(700);
       }
+
+      protocol = NULL;
     }
 
     disconnectBrailleResource(brl, NULL);
@@ -37,6 +37,9 @@
 #define NAVIGATION_KEY_ENTRY(k,n) KEY_ENTRY(NavigationKeys, NAV, k, n)
 #define INTERACTIVE_KEY_ENTRY(k,n) KEY_ENTRY(InteractiveKeys, INT, k, n)
 
+/* every packet is acknowledged, in order, and carries a sequence number */
+#define MESSAGE_WINDOW_SIZE 2
+
 BEGIN_KEY_NAME_TABLE(braille)
   BRAILLE_KEY_ENTRY(1, "Dot1"),
   BRAILLE_KEY_ENTRY(2, "Dot2"),
@@ -361,6 +364,17 @@ readPacket (BrailleDisplay *brl, void *packet, size_t size) {
             case ASCII_EOT:
               break;
 
+            case ASCII_ACK:
+              acknowledgeBrailleMessage(brl);
+              continue;
+
+            case ASCII_NAK:
+              forceRewrite();
+              acknowledgeBrailleMessage(brl);
+              if (started) logShortPacket(buffer, offset);
+              offset = 0;
+              continue;
+
             default:
               if (needsEscape(byte))
                 {
@@ -442,8 +456,8 @@ readPacket (BrailleDisplay *brl, void *packet, size_t size) {
     }
 }
 
-static ssize_t
-writePacket (BrailleDisplay *brl, const void *packet, size_t size) {
+static int
+writeMessage (BrailleDisplay *brl, unsigned int type, const void *packet, size_t size) {
 #define PUT(byte) \
   if (needsEscape((byte))) *target++ = ASCII_DLE; \
   *target++ = (byte); \
@@ -469,14 +483,15 @@ writePacket (BrailleDisplay *brl, const void *packet, size_t size) {
   PUT(parity);
   *target++ = ASCII_EOT;
 
-  {
-    size_t count = target - buffer;
-    logOutputPacket(buffer, count);
-    return io->writeData(brl, buffer, count);
-  }
+  return writeBrailleMessage(brl, NULL, type, buffer, target-buffer);
 #undef PUT
 }
 
+static ssize_t
+writePacket (BrailleDisplay *brl, const void *packet, size_t size) {
+  return writeMessage(brl, 0, packet, size)? size: -1;
+}
+
 static int
 resetDevice (BrailleDisplay *brl) {
   static const unsigned char packet[] = {'S', 'I'};
@@ -536,7 +551,7 @@ writeWindow (BrailleDisplay *brl) {
     buffer[0] = 'D';
     buffer[1] = 'P';
     translateOutputCells(buffer+2, brl->buffer, size);
-    writePacket(brl, buffer, sizeof(buffer));
+    writeMessage(brl, buffer[1], buffer, sizeof(buffer));
   }
 
   return 1;
@@ -584,7 +599,7 @@ writeVisual (BrailleDisplay *brl, const wchar_t *text) {
         }
       }
 
-      writePacket(brl, buffer, target-buffer);
+      writeMessage(brl, buffer[1], buffer, target-buffer);
     }
   }
 
@@ -695,6 +710,7 @@ initializeDevice (BrailleDisplay *brl) {
           return 0;
         }
 
+        brl->acknowledgements.window = MESSAGE_WINDOW_SIZE;
         brl->textColumns = model->cellCount;
 
         switch (firmwareVersion[2]) {
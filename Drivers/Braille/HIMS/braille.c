@@ -286,69 +286,30 @@ struct BrailleDataStruct {
   } hid;
 };
 
-static BraillePacketVerifierResult
-verifyPacket (
-  BrailleDisplay *brl,
-  unsigned char *bytes, size_t size,
-  size_t *length, void *data
-) {
-  unsigned char byte = bytes[size-1];
-
-  switch (size) {
-    case 1: {
-      switch (byte) {
-        case 0X1C:
-          *length = 4;
-          break;
-
-        case 0XFA:
-          *length = 10;
-          break;
-
-        default:
-          return BRL_PVR_INVALID;
-      }
-
-      break;
-    }
-
-    default:
-      break;
-  }
-
-  if (size == *length) {
-    switch (bytes[0]) {
-      case 0X1C: {
-        if (byte != 0X1F) return BRL_PVR_INVALID;
-        break;
-      }
-
-      case 0XFA: {
-        if (byte != 0XFB) return BRL_PVR_INVALID;
-
-        const InputPacket *packet = (const void *)bytes;
-        int checksum = -packet->data.checksum;
-        for (size_t i=0; i<size; i+=1) checksum += packet->bytes[i];
-
-        if ((checksum & 0XFF) != packet->data.checksum) {
-          logInputProblem("incorrect input checksum", packet->bytes, size);
-          return BRL_PVR_INVALID;
-        }
-
-        break;
-      }
+static const BraillePacketFrame packetFrames[] = {
+  { .header = 0X1C,
+    .length = 4,
+    .hasTrailer = 1,
+    .trailer = 0X1F
+  },
 
-      default:
-        break;
-    }
-  }
+  { .header = 0XFA,
+    .length = 10,
+    .hasTrailer = 1,
+    .trailer = 0XFB,
+    .checksum = BRL_PFC_SUM,
+    .checksumPosition = 2
+  },
+};
 
-  return BRL_PVR_INCLUDE;
-}
+static const BraillePacketFraming packetFraming = {
+  .frames = packetFrames,
+  .frameCount = ARRAY_COUNT(packetFrames)
+};
 
 static size_t
 readPacket (BrailleDisplay *brl, InputPacket *packet) {
-  return readBraillePacket(brl, NULL, packet, sizeof(*packet), verifyPacket, NULL);
+  return readFramedBraillePacket(brl, NULL, packet, sizeof(*packet), &packetFraming, NULL);
 }
 
 static size_t
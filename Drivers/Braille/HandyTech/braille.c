@@ -644,6 +644,9 @@ static const ModelEntry modelEntry_ab_s = {
 #define MAXIMUM_TEXT_CELLS   160
 #define MAXIMUM_STATUS_CELLS 4
 
+/* ACK/NAK confirmations come back in the order the packets were sent */
+#define MESSAGE_WINDOW_SIZE 2
+
 typedef enum {
   BDS_OFF,
   BDS_READY
@@ -1126,6 +1129,7 @@ identifyModel (BrailleDisplay *brl, unsigned char identifier) {
     brl->data->model->statusCells, (brl->data->model->statusCells == 1)? "cell": "cells"
   );
 
+  brl->acknowledgements.window = MESSAGE_WINDOW_SIZE;
   brl->textColumns = brl->data->model->textCells;                       /* initialise size of display */
   brl->textRows = 1;
   brl->statusColumns = brl->data->model->statusCells;
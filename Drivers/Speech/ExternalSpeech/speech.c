@@ -29,16 +29,20 @@
 #include <sys/un.h>
 
 #include "log.h"
+#include "strfmt.h"
+#include "parse.h"
 #include "timing.h"
+#include "histogram.h"
 #include "io_misc.h"
 #include "async_handle.h"
 #include "async_io.h"
 
 typedef enum {
   PARM_SOCKET_PATH,
+  PARM_FRAMED,
 } DriverParameter;
 
-#define SPKPARMS "socket_path"
+#define SPKPARMS "socket_path", "framed"
 #include "spk_driver.h"
 #include "speech.h"
 
@@ -53,9 +57,92 @@ static float pitchMultiplier;
 static unsigned char punctuationLevel;
 
 static uint16_t totalCharacterCount;
+static unsigned char speechStarted;
 #define TRACK_DATA_SIZE 2
 static AsyncHandle trackHandle = NULL;
 
+static unsigned int framedProtocol;
+static uint16_t lastUtterance;
+static uint16_t currentUtterance;
+
+static struct {
+  uint16_t utterance;
+  TimeValue time;
+} pendingCancel;
+
+static struct {
+  unsigned long int unacknowledged;
+  unsigned long int stale;
+  Histogram latency;
+} cancelStatistics;
+
+static void
+logCancelStatistics (void) {
+  char statistics[0X200];
+
+  STR_BEGIN(statistics, sizeof(statistics));
+  STR_PRINTF("cancel latency (milliseconds): unacknowledged=%lu stale=%lu [",
+             cancelStatistics.unacknowledged, cancelStatistics.stale);
+  STR_FORMAT(formatHistogram, &cancelStatistics.latency);
+  STR_PRINTF("]");
+  STR_END;
+
+  logMessage(LOG_CATEGORY(SPEECH_DRIVER), "%s", statistics);
+}
+
+static void
+handleCancelAcknowledgement (uint16_t utterance) {
+  if (pendingCancel.utterance && (utterance == pendingCancel.utterance)) {
+    TimeValue now;
+    long int milliseconds;
+
+    getMonotonicTime(&now);
+    milliseconds = millisecondsBetween(&pendingCancel.time, &now);
+    if (milliseconds < 0) milliseconds = 0;
+
+    addHistogramValue(&cancelStatistics.latency, milliseconds);
+    pendingCancel.utterance = 0;
+  }
+}
+
+static void
+handleSpeechEvent (SpeechSynthesizer *spk, const unsigned char *event) {
+  unsigned char type = event[0];
+  uint16_t utterance = (event[1] << 8) | event[2];
+  uint16_t value = (event[3] << 8) | event[4];
+
+  if (!utterance || (utterance != currentUtterance)) {
+    if (type == XS_EVT_CANCELLED) {
+      handleCancelAcknowledgement(utterance);
+    } else {
+      // the utterance has already been cancelled or superseded
+      cancelStatistics.stale += 1;
+    }
+
+    return;
+  }
+
+  switch (type) {
+    case XS_EVT_STARTED:
+      tellSpeechStarted(spk);
+      break;
+
+    case XS_EVT_LOCATION:
+      tellSpeechLocation(spk, value);
+      break;
+
+    case XS_EVT_FINISHED:
+    case XS_EVT_CANCELLED:
+      currentUtterance = 0;
+      tellSpeechFinished(spk);
+      break;
+
+    default:
+      logMessage(LOG_WARNING, "unknown ExternalSpeech event: %u", type);
+      break;
+  }
+}
+
 ASYNC_INPUT_CALLBACK(xsHandleSpeechTrackingInput) {
   SpeechSynthesizer *spk = parameters->data;
 
@@ -66,10 +153,21 @@ ASYNC_INPUT_CALLBACK(xsHandleSpeechTrackingInput) {
     );
   } else if (parameters->end) {
     logMessage(LOG_WARNING, "speech tracking end-of-file");
+  } else if (framedProtocol) {
+    if (parameters->length >= XS_EVENT_SIZE) {
+      handleSpeechEvent(spk, parameters->buffer);
+      return XS_EVENT_SIZE;
+    }
   } else if (parameters->length >= TRACK_DATA_SIZE) {
     const unsigned char *buffer = parameters->buffer;
     uint16_t location = (buffer[0] << 8) | buffer[1];
 
+    if (!speechStarted) {
+      // the first tracking report is the earliest sign of audio
+      speechStarted = 1;
+      tellSpeechStarted(spk);
+    }
+
     if (location < totalCharacterCount) {
       tellSpeechLocation(spk, location);
     } else {
@@ -98,7 +196,7 @@ connectToServer (SpeechSynthesizer *spk) {
     if (setCloseOnExec(sd, 1)) {
       if (connect(sd, (const struct sockaddr *)&socketAddress, sizeof(socketAddress)) != -1) {
         if (setBlockingIo(sd, 0)) {
-          if (asyncReadSocket(&trackHandle, sd, TRACK_DATA_SIZE, xsHandleSpeechTrackingInput, spk)) {
+          if (asyncReadSocket(&trackHandle, sd, (framedProtocol? XS_EVENT_SIZE: TRACK_DATA_SIZE), xsHandleSpeechTrackingInput, spk)) {
             logMessage(LOG_CATEGORY(SPEECH_DRIVER), "connected to server: fd=%d", sd);
             socketDescriptor = sd;
             sendSettings(spk);
@@ -131,6 +229,10 @@ disconnectFromServer (void) {
     close(socketDescriptor);
     socketDescriptor = -1;
   }
+
+  // no events will arrive for anything that was in progress
+  currentUtterance = 0;
+  pendingCancel.utterance = 0;
 }
 
 static int
@@ -300,22 +402,60 @@ spk_setPunctuation (SpeechSynthesizer *spk, SpeechPunctuation setting) {
   sendPunctuationLevel(spk);
 }
 
+static void
+cancelUtterance (SpeechSynthesizer *spk) {
+  uint16_t utterance = currentUtterance;
+  if (!utterance) return;
+
+  logMessage(LOG_CATEGORY(SPEECH_DRIVER), "cancel: %u", utterance);
+  currentUtterance = 0;
+
+  unsigned char packet[] = {XS_PKT_CANCEL, utterance >> 8, utterance & 0XFF};
+
+  if (sendPacket(spk, packet, sizeof(packet))) {
+    if (pendingCancel.utterance) cancelStatistics.unacknowledged += 1;
+    pendingCancel.utterance = utterance;
+    getMonotonicTime(&pendingCancel.time);
+  }
+}
+
 static void
 spk_mute (SpeechSynthesizer *spk) {
+  if (framedProtocol) {
+    cancelUtterance(spk);
+    return;
+  }
+
   logMessage(LOG_CATEGORY(SPEECH_DRIVER), "mute");
 
   unsigned char packet[] = {1};
   sendPacket(spk, packet, sizeof(packet));
 }
 
+static uint16_t
+newUtteranceIdentifier (void) {
+  if (!++lastUtterance) lastUtterance += 1;
+  return lastUtterance;
+}
+
 static void
 spk_say (SpeechSynthesizer *spk, const unsigned char *text, size_t length, size_t count, const unsigned char *attributes) {
   if (!attributes) count = 0;
 
-  unsigned char packet[5 + length + count];
+  uint16_t utterance = 0;
+  unsigned char packet[7 + length + count];
   unsigned char *p = packet;
 
-  *p++ = 4;
+  if (framedProtocol) {
+    utterance = newUtteranceIdentifier();
+
+    *p++ = XS_PKT_SAY;
+    *p++ = utterance >> 8;
+    *p++ = utterance & 0XFF;
+  } else {
+    *p++ = 4;
+  }
+
   *p++ = length >> 8;
   *p++ = length & 0XFF;
   *p++ = count >> 8;
@@ -325,6 +465,8 @@ spk_say (SpeechSynthesizer *spk, const unsigned char *text, size_t length, size_
 
   if (sendPacket(spk, packet, (p - packet))) {
     totalCharacterCount = count;
+    speechStarted = 0;
+    currentUtterance = utterance;
   }
 }
 
@@ -340,6 +482,23 @@ spk_construct (SpeechSynthesizer *spk, char **parameters) {
   pitchMultiplier = 1.0;
   punctuationLevel = 0;
 
+  framedProtocol = 0;
+  if (parameters[PARM_FRAMED] && *parameters[PARM_FRAMED]) {
+    if (!validateYesNo(&framedProtocol, parameters[PARM_FRAMED])) {
+      logMessage(LOG_WARNING, "%s: %s",
+        "invalid value for the framed parameter",
+        parameters[PARM_FRAMED]);
+    }
+  }
+
+  lastUtterance = 0;
+  currentUtterance = 0;
+  pendingCancel.utterance = 0;
+
+  cancelStatistics.unacknowledged = 0;
+  cancelStatistics.stale = 0;
+  resetHistogram(&cancelStatistics.latency);
+
   socketPath = parameters[PARM_SOCKET_PATH];
   if (!socketPath || !*socketPath) socketPath = XS_DEFAULT_SOCKET_PATH;
 
@@ -354,5 +513,6 @@ spk_construct (SpeechSynthesizer *spk, char **parameters) {
 
 static void
 spk_destruct (SpeechSynthesizer *spk) {
+  if (framedProtocol) logCancelStatistics();
   disconnectFromServer();
 }
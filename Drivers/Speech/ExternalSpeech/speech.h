@@ -27,3 +27,18 @@
 
 /* The maxdimum amount of time that a write to the socket may take. */
 #define XS_WRITE_TIMEOUT 2000
+
+/* The packets, in addition to the original ones, that are sent when the
+   framed protocol is selected. Each is followed by a 16-bit (big-endian)
+   utterance identifier. */
+#define XS_PKT_SAY 7
+#define XS_PKT_CANCEL 8
+
+/* The events that the external program reports when the framed protocol is
+   selected: the type, a 16-bit utterance identifier, and a 16-bit value
+   (a character offset for XS_EVT_LOCATION). */
+#define XS_EVENT_SIZE 5
+#define XS_EVT_STARTED 1
+#define XS_EVT_LOCATION 2
+#define XS_EVT_FINISHED 3
+#define XS_EVT_CANCELLED 4
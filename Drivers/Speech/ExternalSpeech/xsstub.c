@@ -0,0 +1,329 @@
+/*
+ * BRLTTY - A background process providing access to the console screen (when in
+ *          text mode) for a blind person using a refreshable braille display.
+ *
+ * Copyright (C) 1995-2026 by The BRLTTY Developers.
+ *
+ * BRLTTY comes with ABSOLUTELY NO WARRANTY.
+ *
+ * This is free software, placed under the terms of the
+ * GNU Lesser General Public License, as published by the Free Software
+ * Foundation; either version 2.1 of the License, or (at your option) any
+ * later version. Please see the file LICENSE-LGPL for details.
+ *
+ * Web Page: http://brltty.app/
+ *
+ * This software is maintained by Dave Mielke <dave@mielke.cc>.
+ */
+
+
+/* ExternalSpeech/xsstub.c - reference synthesizer for the framed protocol
+ * It doesn't produce any audio. It pretends to speak each utterance at a
+ * fixed number of milliseconds per character, reporting the start of each
+ * word, and logs each packet to standard output so that the driver can be
+ * exercised without a real synthesizer.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <signal.h>
+#include <poll.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include "speech.h"
+
+static unsigned int characterTime = 20;
+static float rateDivisor = 1.0;
+
+static int clientDescriptor = -1;
+static unsigned char inputBuffer[0X10000];
+static size_t inputLength;
+
+static struct {
+  unsigned int identifier;
+  unsigned char *text;
+  size_t length;
+  size_t offset;
+  long long int due;
+} utterance;
+
+static long long int
+getMilliseconds (void) {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return ((long long int)now.tv_sec * 1000) + (now.tv_nsec / 1000000);
+}
+
+static void
+sendEvent (unsigned char type, unsigned int identifier, unsigned int value) {
+  unsigned char event[XS_EVENT_SIZE] = {
+    type,
+    identifier >> 8, identifier & 0XFF,
+    value >> 8, value & 0XFF
+  };
+
+  if (write(clientDescriptor, event, sizeof(event)) == -1) {
+    perror("write");
+  }
+}
+
+static void
+endUtterance (unsigned char type) {
+  if (utterance.identifier) {
+    sendEvent(type, utterance.identifier, utterance.offset);
+    printf("%s: %u\n", ((type == XS_EVT_FINISHED)? "finished": "cancelled"),
+           utterance.identifier);
+
+    free(utterance.text);
+    utterance.text = NULL;
+    utterance.identifier = 0;
+  }
+}
+
+static unsigned int
+getWordTime (void) {
+  size_t offset = utterance.offset;
+
+  while ((offset < utterance.length) && (utterance.text[offset] != ' ')) offset += 1;
+  while ((offset < utterance.length) && (utterance.text[offset] == ' ')) offset += 1;
+
+  return (offset - utterance.offset) * characterTime / rateDivisor;
+}
+
+static void
+continueUtterance (void) {
+  if (utterance.offset == utterance.length) {
+    endUtterance(XS_EVT_FINISHED);
+    return;
+  }
+
+  sendEvent(XS_EVT_LOCATION, utterance.identifier, utterance.offset);
+  utterance.due = getMilliseconds() + getWordTime();
+
+  while ((utterance.offset < utterance.length) && (utterance.text[utterance.offset] != ' ')) utterance.offset += 1;
+  while ((utterance.offset < utterance.length) && (utterance.text[utterance.offset] == ' ')) utterance.offset += 1;
+}
+
+static void
+startUtterance (unsigned int identifier, const unsigned char *text, size_t length) {
+  endUtterance(XS_EVT_CANCELLED);
+  printf("say: %u: %.*s\n", identifier, (int)length, text);
+
+  if ((utterance.text = malloc(length + 1))) {
+    memcpy(utterance.text, text, length);
+    utterance.length = length;
+    utterance.offset = 0;
+    utterance.identifier = identifier;
+
+    sendEvent(XS_EVT_STARTED, identifier, 0);
+    continueUtterance();
+  } else {
+    perror("malloc");
+  }
+}
+
+static void
+cancelUtterance (unsigned int identifier) {
+  printf("cancel: %u\n", identifier);
+
+  if (identifier == utterance.identifier) {
+    endUtterance(XS_EVT_CANCELLED);
+  } else {
+    // it has already ended - acknowledge it anyway
+    sendEvent(XS_EVT_CANCELLED, identifier, 0);
+  }
+}
+
+static float
+getFloat (const unsigned char *bytes) {
+  uint32_t word = ((uint32_t)bytes[0] << 24) | (bytes[1] << 16) | (bytes[2] << 8) | bytes[3];
+  float value;
+
+  memcpy(&value, &word, sizeof(value));
+  return value;
+}
+
+static size_t
+handlePacket (const unsigned char *packet, size_t length) {
+#define NEED(count) if (length < (count)) return 0
+
+  NEED(1);
+
+  switch (packet[0]) {
+    case 1:
+      cancelUtterance(utterance.identifier);
+      return 1;
+
+    case 2:
+      NEED(2);
+      printf("volume: %u\n", packet[1]);
+      return 2;
+
+    case 3:
+      NEED(5);
+      rateDivisor = getFloat(&packet[1]);
+      if (rateDivisor <= 0.0) rateDivisor = 1.0;
+      printf("rate: %f\n", rateDivisor);
+      return 5;
+
+    case 5:
+      NEED(5);
+      printf("pitch: %f\n", getFloat(&packet[1]));
+      return 5;
+
+    case 6:
+      NEED(2);
+      printf("punctuation: %u\n", packet[1]);
+      return 2;
+
+    case 4: {
+      NEED(5);
+      size_t textLength = (packet[1] << 8) | packet[2];
+      size_t attributeCount = (packet[3] << 8) | packet[4];
+      size_t size = 5 + textLength + attributeCount;
+
+      NEED(size);
+      fprintf(stderr, "unframed say packet ignored\n");
+      return size;
+    }
+
+    case XS_PKT_SAY: {
+      NEED(7);
+      unsigned int identifier = (packet[1] << 8) | packet[2];
+      size_t textLength = (packet[3] << 8) | packet[4];
+      size_t attributeCount = (packet[5] << 8) | packet[6];
+      size_t size = 7 + textLength + attributeCount;
+
+      NEED(size);
+      startUtterance(identifier, &packet[7], textLength);
+      return size;
+    }
+
+    case XS_PKT_CANCEL:
+      NEED(3);
+      cancelUtterance((packet[1] << 8) | packet[2]);
+      return 3;
+
+    default:
+      fprintf(stderr, "unknown packet type: %u\n", packet[0]);
+      return 1;
+  }
+
+#undef NEED
+}
+
+static int
+serveClient (void) {
+  inputLength = 0;
+  utterance.identifier = 0;
+
+  while (1) {
+    struct pollfd pfd = {
+      .fd = clientDescriptor,
+      .events = POLLIN
+    };
+
+    int timeout = -1;
+
+    if (utterance.identifier) {
+      long long int delay = utterance.due - getMilliseconds();
+      timeout = (delay > 0)? delay: 0;
+    }
+
+    fflush(stdout);
+    int result = poll(&pfd, 1, timeout);
+
+    if (result == -1) {
+      if (errno == EINTR) continue;
+      perror("poll");
+      return 0;
+    }
+
+    if (result == 0) {
+      continueUtterance();
+      continue;
+    }
+
+    {
+      ssize_t count = read(clientDescriptor, &inputBuffer[inputLength],
+                           sizeof(inputBuffer) - inputLength);
+
+      if (count == -1) {
+        if (errno == EINTR) continue;
+        perror("read");
+        return 0;
+      }
+
+      if (count == 0) return 1;
+      inputLength += count;
+    }
+
+    {
+      size_t offset = 0;
+      size_t size;
+
+      while ((size = handlePacket(&inputBuffer[offset], (inputLength - offset)))) {
+        offset += size;
+      }
+
+      memmove(inputBuffer, &inputBuffer[offset], (inputLength -= offset));
+    }
+  }
+}
+
+int
+main (int argc, char *argv[]) {
+  const char *path = XS_DEFAULT_SOCKET_PATH;
+
+  if (argc > 1) path = argv[1];
+  if (argc > 2) characterTime = atoi(argv[2]);
+  signal(SIGPIPE, SIG_IGN);
+
+  int serverDescriptor = socket(AF_UNIX, SOCK_STREAM, 0);
+
+  if (serverDescriptor == -1) {
+    perror("socket");
+    return 1;
+  }
+
+  struct sockaddr_un address;
+  memset(&address, 0, sizeof(address));
+  address.sun_family = AF_UNIX;
+  strncpy(address.sun_path, path, sizeof(address.sun_path)-1);
+  unlink(path);
+
+  if (bind(serverDescriptor, (struct sockaddr *)&address, sizeof(address)) == -1) {
+    perror("bind");
+    return 1;
+  }
+
+  if (listen(serverDescriptor, 1) == -1) {
+    perror("listen");
+    return 1;
+  }
+
+  while (1) {
+    if ((clientDescriptor = accept(serverDescriptor, NULL, NULL)) == -1) {
+      if (errno == EINTR) continue;
+      perror("accept");
+      return 1;
+    }
+
+    printf("connected\n");
+    serveClient();
+
+    free(utterance.text);
+    utterance.text = NULL;
+    utterance.identifier = 0;
+
+    close(clientDescriptor);
+    clientDescriptor = -1;
+    printf("disconnected\n");
+  }
+}
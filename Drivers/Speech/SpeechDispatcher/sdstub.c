@@ -0,0 +1,422 @@
+/*
+ * BRLTTY - A background process providing access to the console screen (when in
+ *          text mode) for a blind person using a refreshable braille display.
+ *
+ * Copyright (C) 1995-2026 by The BRLTTY Developers.
+ *
+ * BRLTTY comes with ABSOLUTELY NO WARRANTY.
+ *
+ * This is free software, placed under the terms of the
+ * GNU Lesser General Public License, as published by the Free Software
+ * Foundation; either version 2.1 of the License, or (at your option) any
+ * later version. Please see the file LICENSE-LGPL for details.
+ *
+ * Web Page: http://brltty.app/
+ *
+ * This software is maintained by Dave Mielke <dave@mielke.cc>.
+ */
+
+
+/* SpeechDispatcher/sdstub.c - stand-in for Speech Dispatcher's SSIP server
+ * It answers just enough of SSIP for libspeechd, and counts the commands
+ * (each of which is a round trip) that a client sends. It doesn't produce
+ * any audio. It pretends to speak each message at a fixed number of
+ * milliseconds per character, queueing messages as Speech Dispatcher does,
+ * and sends the begin, end, and cancel notifications which have been
+ * turned on. At zero milliseconds per character a message's begin and end
+ * notifications are sent before the reply which gives its identifier.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <stdarg.h>
+#include <errno.h>
+#include <signal.h>
+#include <poll.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#define SD_DEFAULT_SOCKET_PATH "sdstub.sock"
+#define SD_CLIENT_IDENTIFIER 1
+#define SD_MESSAGE_QUEUE_SIZE 0X100
+
+static unsigned int characterTime = 20;
+
+static int clientDescriptor = -1;
+static char inputBuffer[0X10000];
+static size_t inputLength;
+
+static unsigned int nextMessage;
+static size_t speakLength;
+static unsigned char receivingData;
+
+static struct {
+  unsigned char begin;
+  unsigned char end;
+  unsigned char cancel;
+} notifications;
+
+typedef struct {
+  unsigned int identifier;
+  unsigned int duration;
+} QueuedMessage;
+
+static struct {
+  QueuedMessage entries[SD_MESSAGE_QUEUE_SIZE];
+  unsigned int first;
+  unsigned int count;
+  long long int due; /* when the first one ends, 0 if it hasn't begun */
+} messages;
+
+typedef struct {
+  const char *name;
+  unsigned long int count;
+} CommandCounter;
+
+static CommandCounter commandCounters[] = {
+  { .name = "SPEAK" },
+  { .name = "CHAR" },
+  { .name = "KEY" },
+  { .name = "SET" },
+  { .name = "CANCEL" },
+  { .name = "STOP" },
+  { .name = "HISTORY" },
+  { .name = "QUIT" },
+  { .name = NULL }
+};
+
+static unsigned long int totalCommands;
+
+static long long int
+getMilliseconds (void) {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return ((long long int)now.tv_sec * 1000) + (now.tv_nsec / 1000000);
+}
+
+static void
+sendLines (const char *format, ...) {
+  char buffer[0X100];
+  va_list arguments;
+
+  va_start(arguments, format);
+  int length = vsnprintf(buffer, sizeof(buffer), format, arguments);
+  va_end(arguments);
+
+  if (write(clientDescriptor, buffer, length) == -1) {
+    perror("write");
+  }
+}
+
+static void
+sendNotification (unsigned int code, const char *name, unsigned int identifier) {
+  sendLines("%u-%u\r\n%u-%u\r\n%u %s\r\n",
+            code, identifier, code, SD_CLIENT_IDENTIFIER, code, name);
+}
+
+static QueuedMessage *
+getQueuedMessage (unsigned int index) {
+  return &messages.entries[(messages.first + index) % SD_MESSAGE_QUEUE_SIZE];
+}
+
+static void
+beginMessage (void) {
+  QueuedMessage *message = getQueuedMessage(0);
+
+  if (notifications.begin) sendNotification(701, "BEGIN", message->identifier);
+  messages.due = getMilliseconds() + message->duration;
+}
+
+static void
+endMessage (void) {
+  QueuedMessage *message = getQueuedMessage(0);
+
+  if (notifications.end) sendNotification(702, "END", message->identifier);
+  printf("end: %u\n", message->identifier);
+
+  messages.first = (messages.first + 1) % SD_MESSAGE_QUEUE_SIZE;
+  messages.count -= 1;
+  messages.due = 0;
+}
+
+static void
+continueMessages (void) {
+  while (messages.count) {
+    if (!messages.due) beginMessage();
+    if (getMilliseconds() < messages.due) break;
+    endMessage();
+  }
+}
+
+static void
+cancelMessages (void) {
+  while (messages.count) {
+    QueuedMessage *message = getQueuedMessage(0);
+
+    if (notifications.cancel) sendNotification(703, "CANCELED", message->identifier);
+    printf("cancel: %u\n", message->identifier);
+
+    messages.first = (messages.first + 1) % SD_MESSAGE_QUEUE_SIZE;
+    messages.count -= 1;
+  }
+
+  messages.due = 0;
+}
+
+static void
+queueMessage (size_t length) {
+  if (messages.count == SD_MESSAGE_QUEUE_SIZE) {
+    sendLines("301 ERR QUEUE FULL\r\n");
+    return;
+  }
+
+  unsigned int identifier = ++nextMessage;
+
+  {
+    QueuedMessage *message = getQueuedMessage(messages.count++);
+
+    message->identifier = identifier;
+    message->duration = length * characterTime;
+  }
+
+  printf("queued: %u: %zu characters\n", identifier, length);
+  if (!characterTime) continueMessages();
+  sendLines("225-%u\r\n225 OK MESSAGE QUEUED\r\n", identifier);
+}
+
+static void
+setNotification (const char *type, const char *setting) {
+  unsigned char on = strcasecmp(setting, "on") == 0;
+  int all = strcasecmp(type, "all") == 0;
+
+  if (all || (strcasecmp(type, "begin") == 0)) notifications.begin = on;
+  if (all || (strcasecmp(type, "end") == 0)) notifications.end = on;
+  if (all || (strcasecmp(type, "cancel") == 0)) notifications.cancel = on;
+}
+
+static void
+countCommand (const char *name) {
+  CommandCounter *counter = commandCounters;
+
+  totalCommands += 1;
+
+  while (counter->name) {
+    if (strcasecmp(name, counter->name) == 0) {
+      counter->count += 1;
+      return;
+    }
+
+    counter += 1;
+  }
+}
+
+static void
+handleData (const char *line) {
+  if (strcmp(line, ".") == 0) {
+    receivingData = 0;
+    queueMessage(speakLength);
+    return;
+  }
+
+  /* a leading dot has been doubled */
+  if (strncmp(line, "..", 2) == 0) line += 1;
+
+  if (speakLength) speakLength += 1;
+  speakLength += strlen(line);
+}
+
+static int
+handleCommand (char *line) {
+  char *words[4] = {NULL};
+  unsigned int count = 0;
+
+  printf("command: %s\n", line);
+
+  {
+    char *next = line;
+
+    while ((count < 3) && next) {
+      words[count++] = strsep(&next, " ");
+    }
+
+    /* the rest of the line is the last argument */
+    if (next) words[count++] = next;
+  }
+
+  if (!count) return 1;
+  countCommand(words[0]);
+
+  if (strcasecmp(words[0], "SPEAK") == 0) {
+    receivingData = 1;
+    speakLength = 0;
+    sendLines("230 OK RECEIVING DATA\r\n");
+  } else if ((strcasecmp(words[0], "CHAR") == 0) ||
+             (strcasecmp(words[0], "KEY") == 0)) {
+    queueMessage(1);
+  } else if ((strcasecmp(words[0], "CANCEL") == 0) ||
+             (strcasecmp(words[0], "STOP") == 0)) {
+    cancelMessages();
+    sendLines("210 OK CANCELED\r\n");
+  } else if (strcasecmp(words[0], "HISTORY") == 0) {
+    sendLines("245-%u\r\n245 OK CLIENT ID SENT\r\n", SD_CLIENT_IDENTIFIER);
+  } else if (strcasecmp(words[0], "QUIT") == 0) {
+    sendLines("231 HAPPY HACKING\r\n");
+    return 0;
+  } else if (strcasecmp(words[0], "SET") == 0) {
+    if ((count == 4) && (strcasecmp(words[2], "NOTIFICATION") == 0)) {
+      char *type = strsep(&words[3], " ");
+      if (words[3]) setNotification(type, words[3]);
+    }
+
+    sendLines("203 OK SET\r\n");
+  } else {
+    sendLines("200 OK\r\n");
+  }
+
+  return 1;
+}
+
+static void
+showCommandCounters (void) {
+  const CommandCounter *counter = commandCounters;
+
+  printf("commands: %lu", totalCommands);
+
+  while (counter->name) {
+    if (counter->count) printf(" %s=%lu", counter->name, counter->count);
+    counter += 1;
+  }
+
+  printf("\n");
+}
+
+static int
+serveClient (void) {
+  inputLength = 0;
+  receivingData = 0;
+  nextMessage = 0;
+  totalCommands = 0;
+
+  messages.first = 0;
+  messages.count = 0;
+  messages.due = 0;
+
+  memset(&notifications, 0, sizeof(notifications));
+  for (CommandCounter *counter=commandCounters; counter->name; counter+=1) counter->count = 0;
+
+  while (1) {
+    struct pollfd pfd = {
+      .fd = clientDescriptor,
+      .events = POLLIN
+    };
+
+    int timeout = -1;
+
+    if (messages.count) {
+      long long int delay = messages.due - getMilliseconds();
+      timeout = (delay > 0)? delay: 0;
+    }
+
+    fflush(stdout);
+    int result = poll(&pfd, 1, timeout);
+
+    if (result == -1) {
+      if (errno == EINTR) continue;
+      perror("poll");
+      return 0;
+    }
+
+    if (result == 0) {
+      continueMessages();
+      continue;
+    }
+
+    {
+      ssize_t count = read(clientDescriptor, &inputBuffer[inputLength],
+                           sizeof(inputBuffer) - inputLength - 1);
+
+      if (count == -1) {
+        if (errno == EINTR) continue;
+        perror("read");
+        return 0;
+      }
+
+      if (count == 0) return 1;
+      inputLength += count;
+    }
+
+    {
+      char *line = inputBuffer;
+      char *end;
+
+      inputBuffer[inputLength] = 0;
+
+      while ((end = strstr(line, "\r\n"))) {
+        *end = 0;
+
+        if (receivingData) {
+          handleData(line);
+        } else if (!handleCommand(line)) {
+          return 1;
+        }
+
+        line = end + 2;
+      }
+
+      memmove(inputBuffer, line, (inputLength -= (line - inputBuffer)));
+    }
+  }
+}
+
+int
+main (int argc, char *argv[]) {
+  const char *path = SD_DEFAULT_SOCKET_PATH;
+
+  if (argc > 1) path = argv[1];
+  if (argc > 2) characterTime = atoi(argv[2]);
+  signal(SIGPIPE, SIG_IGN);
+
+  int serverDescriptor = socket(AF_UNIX, SOCK_STREAM, 0);
+
+  if (serverDescriptor == -1) {
+    perror("socket");
+    return 1;
+  }
+
+  struct sockaddr_un address;
+  memset(&address, 0, sizeof(address));
+  address.sun_family = AF_UNIX;
+  strncpy(address.sun_path, path, sizeof(address.sun_path)-1);
+  unlink(path);
+
+  if (bind(serverDescriptor, (struct sockaddr *)&address, sizeof(address)) == -1) {
+    perror("bind");
+    return 1;
+  }
+
+  if (listen(serverDescriptor, 1) == -1) {
+    perror("listen");
+    return 1;
+  }
+
+  while (1) {
+    if ((clientDescriptor = accept(serverDescriptor, NULL, NULL)) == -1) {
+      if (errno == EINTR) continue;
+      perror("accept");
+      return 1;
+    }
+
+    printf("connected\n");
+    serveClient();
+    showCommandCounters();
+
+    close(clientDescriptor);
+    clientDescriptor = -1;
+    printf("disconnected\n");
+    fflush(stdout);
+  }
+}
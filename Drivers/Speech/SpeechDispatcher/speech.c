@@ -23,6 +23,7 @@
 
 #include "log.h"
 #include "parse.h"
+#include "lock.h"
 
 typedef enum {
   PARM_ADDRESS,
@@ -38,6 +39,7 @@ typedef enum {
 
 #include <libspeechd.h>
 
+static SpeechSynthesizer *speechSynthesizer = NULL;
 static SPDConnection *connectionHandle = NULL;
 static unsigned int autospawn;
 static const char *moduleName;
@@ -49,6 +51,77 @@ static signed int relativeRate;
 static signed int relativePitch;
 static SPDPunctuation punctuationLevel;
 
+/* what the server has last been told, so that unchanged settings aren't resent */
+typedef struct {
+  unsigned char known;
+  signed int value;
+} SentSetting;
+
+static SentSetting sentVolume;
+static SentSetting sentRate;
+static SentSetting sentPitch;
+static SentSetting sentPunctuation;
+
+/*
+ * The server's end notifications come in on libspeechd's own thread. Message
+ * identifiers only ever increase, so while the identifier of the message
+ * being said isn't known - spd_char doesn't return it, and its end can be
+ * reported before spd_sayf returns - the first end of a message newer than
+ * any which was known when it was sent is taken to be its end.
+ */
+static LockDescriptor *messageLock = NULL;
+
+static struct {
+  size_t current; /* the message being said, 0 if not known (yet) */
+  size_t previous; /* the newest message known when it was sent */
+  size_t newest; /* the newest message which has been reported */
+  size_t ended; /* the message whose end cleared pending */
+  unsigned char pending:1; /* cleared when the message being said ends */
+} speechMessages;
+
+static struct {
+  unsigned long int sent;
+  unsigned long int skipped;
+} commandCounters;
+
+static void
+forgetSentSettings (void) {
+  sentVolume.known = 0;
+  sentRate.known = 0;
+  sentPitch.known = 0;
+  sentPunctuation.known = 0;
+
+  obtainExclusiveLock(messageLock);
+  speechMessages.current = 0;
+  speechMessages.previous = 0;
+  speechMessages.newest = 0;
+  speechMessages.ended = 0;
+  speechMessages.pending = 0;
+  releaseLock(messageLock);
+}
+
+static int
+testSettingChange (const SentSetting *sent, signed int value) {
+  if (sent->known && (sent->value == value)) {
+    commandCounters.skipped += 1;
+    return 0;
+  }
+
+  return 1;
+}
+
+static void
+noteSettingSent (SentSetting *sent, signed int value, int result) {
+  commandCounters.sent += 1;
+
+  if (result == 0) {
+    sent->known = 1;
+    sent->value = value;
+  } else {
+    sent->known = 0;
+  }
+}
+
 static void
 clearSettings (void) {
   autospawn = 1;
@@ -68,6 +141,8 @@ closeConnection (void) {
     spd_close(connectionHandle);
     connectionHandle = NULL;
   }
+
+  forgetSentSettings();
 }
 
 typedef void (*SpeechdAction) (const void *data);
@@ -100,45 +175,63 @@ setVoiceName (const void *data) {
   if (voiceName) spd_set_synthesis_voice(connectionHandle, voiceName);
 }
 
+/*
+ * The volume, rate, pitch, and punctuation setters only record the new
+ * value. They're sent, if they've changed, just before the next text is
+ * said - Speech Dispatcher only applies them to new messages anyway - so
+ * that a burst of setting changes costs at most one exchange per setting.
+ */
+
 static void
 setVolume (const void *data) {
-  spd_set_volume(connectionHandle, relativeVolume);
+  if (testSettingChange(&sentVolume, relativeVolume)) {
+    noteSettingSent(&sentVolume, relativeVolume,
+                    spd_set_volume(connectionHandle, relativeVolume));
+  }
 }
 
 static void
 spk_setVolume (SpeechSynthesizer *spk, unsigned char setting) {
   relativeVolume = getIntegerSpeechVolume(setting, 100) - 100;
-  speechdAction(setVolume, NULL);
   logMessage(LOG_DEBUG, "set volume: %u -> %d", setting, relativeVolume);
 }
 
 static void
 setRate (const void *data) {
-  spd_set_voice_rate(connectionHandle, relativeRate);
+  if (testSettingChange(&sentRate, relativeRate)) {
+    noteSettingSent(&sentRate, relativeRate,
+                    spd_set_voice_rate(connectionHandle, relativeRate));
+  }
 }
 
 static void
 spk_setRate (SpeechSynthesizer *spk, unsigned char setting) {
   relativeRate = getIntegerSpeechRate(setting, 100) - 100;
-  speechdAction(setRate, NULL);
   logMessage(LOG_DEBUG, "set rate: %u -> %d", setting, relativeRate);
 }
 
 static void
 setPitch (const void *data) {
-  spd_set_voice_pitch(connectionHandle, relativePitch);
+  if (testSettingChange(&sentPitch, relativePitch)) {
+    noteSettingSent(&sentPitch, relativePitch,
+                    spd_set_voice_pitch(connectionHandle, relativePitch));
+  }
 }
 
 static void
 spk_setPitch (SpeechSynthesizer *spk, unsigned char setting) {
   relativePitch = getIntegerSpeechPitch(setting, 100) - 100;
-  speechdAction(setPitch, NULL);
   logMessage(LOG_DEBUG, "set pitch: %u -> %d", setting, relativePitch);
 }
 
 static void
 setPunctuation (const void *data) {
-  if (punctuationLevel != -1) spd_set_punctuation(connectionHandle, punctuationLevel);
+  if (punctuationLevel != -1) {
+    if (testSettingChange(&sentPunctuation, punctuationLevel)) {
+      noteSettingSent(&sentPunctuation, punctuationLevel,
+                      spd_set_punctuation(connectionHandle, punctuationLevel));
+    }
+  }
 }
 
 static void
@@ -149,15 +242,79 @@ spk_setPunctuation (SpeechSynthesizer *spk, SpeechPunctuation setting) {
                      (setting == SPK_PUNCTUATION_MOST)? SPD_PUNCT_MOST:
                      -1;
 
-  speechdAction(setPunctuation, NULL);
   logMessage(LOG_DEBUG, "set punctuation: %u -> %d", setting, punctuationLevel);
 }
 
+static void
+sendSettings (const void *data) {
+  static const SpeechdAction actions[] = {
+    setVolume,
+    setRate,
+    setPitch,
+    setPunctuation,
+    NULL
+  };
+
+  const SpeechdAction *action = actions;
+
+  while (*action) {
+    (*action++)(data);
+    if (!connectionHandle->stream) break;
+  }
+}
+
 static void
 cancelSpeech (const void *data) {
+  int pending;
+
+  obtainExclusiveLock(messageLock);
+  pending = speechMessages.pending;
+  speechMessages.pending = 0;
+  releaseLock(messageLock);
+
+  if (!pending) {
+    commandCounters.skipped += 1;
+    return;
+  }
+
+  commandCounters.sent += 1;
   spd_cancel(connectionHandle);
 }
 
+static void
+noteSpeechMessage (size_t message) {
+  if (message > speechMessages.newest) speechMessages.newest = message;
+}
+
+static void
+handleSpeechBegin (size_t message, size_t client, SPDNotificationType type) {
+  obtainExclusiveLock(messageLock);
+  noteSpeechMessage(message);
+  releaseLock(messageLock);
+
+  if (speechSynthesizer) tellSpeechStarted(speechSynthesizer);
+}
+
+static void
+handleSpeechEnd (size_t message, size_t client, SPDNotificationType type) {
+  int finished = 0;
+  obtainExclusiveLock(messageLock);
+
+  if (speechMessages.pending) {
+    if (speechMessages.current? (message == speechMessages.current):
+                                (message > speechMessages.previous)) {
+      speechMessages.pending = 0;
+      speechMessages.ended = message;
+      finished = 1;
+    }
+  }
+
+  noteSpeechMessage(message);
+  releaseLock(messageLock);
+
+  if (finished && speechSynthesizer) tellSpeechFinished(speechSynthesizer);
+}
+
 static int
 openConnection (void) {
   if (!connectionHandle) {
@@ -169,16 +326,21 @@ openConnection (void) {
       return 0;
     }
 
+    forgetSentSettings();
+
+    connectionHandle->callback_begin = handleSpeechBegin;
+    spd_set_notification_on(connectionHandle, SPD_BEGIN);
+
+    connectionHandle->callback_end = handleSpeechEnd;
+    spd_set_notification_on(connectionHandle, SPD_END);
+
     {
       static const SpeechdAction actions[] = {
         setModule,
         setLanguage,
         setVoiceType,
         setVoiceName,
-        setVolume,
-        setRate,
-        setPitch,
-        setPunctuation,
+        sendSettings,
         NULL
       };
       const SpeechdAction *action = actions;
@@ -191,12 +353,18 @@ openConnection (void) {
 
 static int
 spk_construct (SpeechSynthesizer *spk, char **parameters) {
+  speechSynthesizer = spk;
+  if (!(messageLock = newLockDescriptor())) return 0;
+
   spk->setVolume = spk_setVolume;
   spk->setRate = spk_setRate;
   spk->setPitch = spk_setPitch;
   spk->setPunctuation = spk_setPunctuation;
 
   clearSettings();
+  forgetSentSettings();
+  commandCounters.sent = 0;
+  commandCounters.skipped = 0;
 
   if (parameters[PARM_ADDRESS] && *parameters[PARM_ADDRESS]) {
     setenv("SPEECHD_ADDRESS", parameters[PARM_ADDRESS], 0);
@@ -247,13 +415,27 @@ spk_construct (SpeechSynthesizer *spk, char **parameters) {
     voiceName = parameters[PARM_NAME];
   }
 
-  return openConnection();
+  if (openConnection()) return 1;
+
+  freeLockDescriptor(messageLock);
+  messageLock = NULL;
+  return 0;
 }
 
 static void
 spk_destruct (SpeechSynthesizer *spk) {
+  logMessage(LOG_CATEGORY(SPEECH_DRIVER),
+             "SSIP commands: sent=%lu skipped=%lu",
+             commandCounters.sent, commandCounters.skipped);
+
   closeConnection();
   clearSettings();
+  speechSynthesizer = NULL;
+
+  if (messageLock) {
+    freeLockDescriptor(messageLock);
+    messageLock = NULL;
+  }
 }
 
 typedef struct {
@@ -267,13 +449,38 @@ static void
 sayText (const void *data) {
   const SayData *say = data;
 
+  sendSettings(NULL);
+  if (!connectionHandle->stream) return;
+
+  /* set before sending since the end can be reported before the send returns */
+  obtainExclusiveLock(messageLock);
+  speechMessages.current = 0;
+  speechMessages.previous = speechMessages.newest;
+  speechMessages.pending = 1;
+  releaseLock(messageLock);
+
+  commandCounters.sent += 1;
+
   if (say->count == 1) {
     char string[say->length + 1];
     memcpy(string, say->text, say->length);
     string[say->length] = 0;
     spd_char(connectionHandle, say->priority, string);
   } else {
-    spd_sayf(connectionHandle, say->priority, "%.*s", (int)say->length, say->text);
+    int message = spd_sayf(connectionHandle, say->priority, "%.*s", (int)say->length, say->text);
+
+    if (message > 0) {
+      obtainExclusiveLock(messageLock);
+      noteSpeechMessage(message);
+
+      /* an earlier message whose identifier wasn't known may have ended */
+      if (!speechMessages.pending && (speechMessages.ended < message)) {
+        speechMessages.pending = 1;
+      }
+
+      speechMessages.current = message;
+      releaseLock(messageLock);
+    }
   }
 }
 
@@ -24,14 +24,24 @@
 
 #include "log.h"
 #include "parse.h"
+#include "queue.h"
+#include "lock.h"
+#include "timing.h"
+#include "async_handle.h"
+#include "async_alarm.h"
+#include "pcm.h"
+#include "spk_cache.h"
+#include "options.h"
 
 typedef enum {
 	PARM_PATH,
 	PARM_PUNCTLIST,
 	PARM_VOICE,
-	PARM_MAXRATE
+	PARM_MAXRATE,
+	PARM_CACHE,
+	PARM_PREWARM
 } DriverParameter;
-#define SPKPARMS "path", "punctlist", "voice", "maxrate"
+#define SPKPARMS "path", "punctlist", "voice", "maxrate", "cache", "prewarm"
 
 #include "spk_driver.h"
 
@@ -39,29 +49,458 @@ typedef enum {
 
 static int maxrate = espeakRATE_MAXIMUM;
 
+/*
+ * When the cache parameter is set, eSpeak-NG is run in retrieval mode and
+ * the driver plays the samples itself. This lets the rendering of short
+ * utterances (characters, punctuation, key echoes) be kept and replayed
+ * without waiting for the synthesizer.
+ */
+#define CACHE_TEXT_LIMIT 0X10
+#define CACHE_SECONDS_LIMIT 3
+
+/* prewarming waits for settings to stop changing, and then only renders
+ * a few characters at a time while the synthesizer has nothing else to do
+ */
+#define PREWARM_SETTLE_DELAY 500
+#define PREWARM_RETRY_DELAY 100
+#define PREWARM_BATCH_SIZE 4
+
+static SpeechCache *speechCache = NULL;
+static PcmDevice *pcm = NULL;
+static int sampleRate;
+
+static char voiceName[0X40];
+static char *prewarmCharacters = NULL;
+static AsyncHandle prewarmAlarm = NULL;
+
+static struct {
+	int volume;
+	int rate;
+	int pitch;
+	int punctuation;
+} currentSettings;
+
+static LockDescriptor *synthesisLock = NULL;
+static Queue *synthesisQueue = NULL;
+
+typedef struct {
+	SpeechSynthesizer *spk;
+	TimeValue start;
+	char *key;
+	int16_t *samples;
+	size_t count;
+	size_t size;
+	unsigned play:1;
+	unsigned started:1;
+} SynthesisRequest;
+
 static void
-spk_say(SpeechSynthesizer *spk, const unsigned char *buffer, size_t length, size_t count, const unsigned char *attributes)
+deallocateSynthesisRequest(void *item, void *data)
+{
+	SynthesisRequest *request = item;
+
+	if (request->key) free(request->key);
+	if (request->samples) free(request->samples);
+	free(request);
+}
+
+static int
+makeCacheKey(char *buffer, size_t size, const unsigned char *text, size_t length)
+{
+	int result = snprintf(buffer, size, "%s\t%d\t%d\t%d\t%d\t%.*s",
+			voiceName, currentSettings.rate, currentSettings.pitch,
+			currentSettings.volume, currentSettings.punctuation,
+			(int)length, text);
+	return (result >= 0) && (result < size);
+}
+
+static int
+synthesizeText(const unsigned char *buffer, size_t length, void *data)
 {
 	int result;
 
 	/* add 1 to the length in order to pass along the trailing zero */
 	result = espeak_Synth(buffer, length+1, 0, POS_CHARACTER, 0,
-			espeakCHARS_UTF8, NULL, (void *)spk);
-	if (result != EE_OK)
-		logMessage(LOG_ERR, "eSpeak-NG: Synth() returned error %d", result);
+			espeakCHARS_UTF8, NULL, data);
+	if (result == EE_OK) return 1;
+
+	logMessage(LOG_ERR, "eSpeak-NG: Synth() returned error %d", result);
+	return 0;
+}
+
+static void
+startSynthesisRequest(SpeechSynthesizer *spk, const unsigned char *buffer, size_t length, const char *key, int play)
+{
+	SynthesisRequest *request;
+
+	if ((request = malloc(sizeof(*request)))) {
+		memset(request, 0, sizeof(*request));
+		request->spk = spk;
+		request->play = play;
+		getMonotonicTime(&request->start);
+
+		if (!key || (request->key = strdup(key))) {
+			int queued;
+
+			obtainExclusiveLock(synthesisLock);
+			queued = !!enqueueItem(synthesisQueue, request);
+			releaseLock(synthesisLock);
+
+			if (queued) {
+				if (synthesizeText(buffer, length, request)) return;
+
+				obtainExclusiveLock(synthesisLock);
+				deleteItem(synthesisQueue, request);
+				releaseLock(synthesisLock);
+				return;
+			}
+
+			if (request->key) free(request->key);
+		} else {
+			logMallocError();
+		}
+
+		free(request);
+	} else {
+		logMallocError();
+	}
+}
+
+static int
+testPlayingRequest(const void *item, void *data)
+{
+	const SynthesisRequest *request = item;
+	return request->play;
+}
+
+static int
+testPrewarmRequest(const void *item, void *data)
+{
+	const SynthesisRequest *request = item;
+	return !request->play;
+}
+
+static int
+isSynthesisPlaying(void)
+{
+	int playing;
+
+	obtainExclusiveLock(synthesisLock);
+	playing = !!findElement(synthesisQueue, testPlayingRequest, NULL);
+	releaseLock(synthesisLock);
+
+	return playing;
+}
+
+static int
+isSynthesisIdle(void)
+{
+	int idle;
+
+	obtainExclusiveLock(synthesisLock);
+	idle = isEmptyQueue(synthesisQueue);
+	releaseLock(synthesisLock);
+
+	return idle;
+}
+
+static void
+writeSynthesisAudio(const int16_t *samples, size_t count)
+{
+	if (!writePcmData(pcm, (const unsigned char *)samples, count * sizeof(*samples)))
+		logSystemError("eSpeak-NG PCM write");
+}
+
+static void
+captureSynthesisAudio(SynthesisRequest *request, const short *audio, int count)
+{
+	size_t needed = request->count + count;
+
+	if (!request->key) return;
+
+	if (needed > (sampleRate * CACHE_SECONDS_LIMIT)) {
+		free(request->key);
+		request->key = NULL;
+		return;
+	}
+
+	if (needed > request->size) {
+		size_t size = request->size? request->size: 0X1000;
+		int16_t *samples;
+
+		while (size < needed) size <<= 1;
+
+		if (!(samples = realloc(request->samples, size * sizeof(*samples)))) {
+			logMallocError();
+			free(request->key);
+			request->key = NULL;
+			return;
+		}
+
+		request->samples = samples;
+		request->size = size;
+	}
+
+	memcpy(&request->samples[request->count], audio, count * sizeof(*audio));
+	request->count = needed;
+}
+
+static int RetrievalCallback(short *audio, int numsamples, espeak_EVENT *events)
+{
+	SynthesisRequest *request = events->user_data;
+	int finished = 0;
+
+	while (events->type != espeakEVENT_LIST_TERMINATED) {
+		if (events->type == espeakEVENT_WORD && request->play)
+			tellSpeechLocation(request->spk, events->text_position - 1);
+		if (events->type == espeakEVENT_MSG_TERMINATED)
+			finished = 1;
+		events++;
+	}
+
+	if (numsamples > 0) {
+		captureSynthesisAudio(request, audio, numsamples);
+
+		if (request->play) {
+			if (!request->started) {
+				request->started = 1;
+				addSpeechCacheFirstSample(speechCache, 0, &request->start);
+				tellSpeechStarted(request->spk);
+			}
+
+			writeSynthesisAudio(audio, numsamples);
+		}
+	}
+
+	if (finished) {
+		if (request->key)
+			putSpeechCacheAudio(speechCache, request->key, request->samples, request->count);
+		if (request->play)
+			tellSpeechFinished(request->spk);
+
+		obtainExclusiveLock(synthesisLock);
+		deleteItem(synthesisQueue, request);
+		releaseLock(synthesisLock);
+	}
+
+	return 0;
+}
+
+static int
+prewarmSpeechCache(SpeechSynthesizer *spk)
+{
+	const char *character = prewarmCharacters;
+	unsigned int count = 0;
+	int more = 0;
+
+	while (*character) {
+		size_t length = 1;
+		char key[0X100];
+
+		/* keep the continuation bytes of a UTF-8 sequence together */
+		while ((character[length] & 0XC0) == 0X80) length += 1;
+
+		if (makeCacheKey(key, sizeof(key), (const unsigned char *)character, length)) {
+			if (!isSpeechCached(speechCache, key)) {
+				unsigned char text[length + 1];
+
+				if (count == PREWARM_BATCH_SIZE) {
+					more = 1;
+					break;
+				}
+
+				memcpy(text, character, length);
+				text[length] = 0;
+
+				startSynthesisRequest(spk, text, length, key, 0);
+				count += 1;
+			}
+		}
+
+		character += length;
+	}
+
+	if (count) logMessage(LOG_CATEGORY(SPEECH_DRIVER), "eSpeak-NG: prewarming %u cache entries", count);
+	return more;
+}
+
+static void setPrewarmAlarm(SpeechSynthesizer *spk, int delay);
+
+ASYNC_ALARM_CALLBACK(handlePrewarmAlarm)
+{
+	SpeechSynthesizer *spk = parameters->data;
+
+	asyncDiscardHandle(prewarmAlarm);
+	prewarmAlarm = NULL;
+
+	/* never queue a render ahead of live speech */
+	if (!isSynthesisIdle() || prewarmSpeechCache(spk))
+		setPrewarmAlarm(spk, PREWARM_RETRY_DELAY);
+}
+
+static void
+setPrewarmAlarm(SpeechSynthesizer *spk, int delay)
+{
+	if (prewarmAlarm) {
+		asyncResetAlarmIn(prewarmAlarm, delay);
+	} else {
+		asyncNewRelativeAlarm(&prewarmAlarm, delay, handlePrewarmAlarm, spk);
+	}
+}
+
+static void
+schedulePrewarm(SpeechSynthesizer *spk)
+{
+	if (prewarmCharacters) setPrewarmAlarm(spk, PREWARM_SETTLE_DELAY);
+}
+
+static int
+playCachedSpeech(SpeechSynthesizer *spk, const char *key)
+{
+	TimeValue start;
+	int16_t *samples;
+	size_t count;
+
+	getMonotonicTime(&start);
+	if (!getSpeechCacheAudio(speechCache, key, &samples, &count)) return 0;
+
+	addSpeechCacheFirstSample(speechCache, 1, &start);
+	tellSpeechStarted(spk);
+
+	{
+		/* write it a block at a time so that a mute can still cut it short */
+		unsigned int mutes = getSpeechMuteCount(spk);
+		size_t blockSize = getPcmBlockSize(pcm) / sizeof(*samples);
+		const int16_t *from = samples;
+		size_t left = count;
+
+		if (!blockSize) blockSize = left;
+
+		while (left > 0) {
+			size_t size = MIN(left, blockSize);
+
+			writeSynthesisAudio(from, size);
+			from += size;
+			left -= size;
+
+			if (left && (getSpeechMuteCount(spk) != mutes)) {
+				logMessage(LOG_CATEGORY(SPEECH_DRIVER), "eSpeak-NG: cached speech muted");
+				cancelPcmOutput(pcm);
+				break;
+			}
+		}
+	}
+
+	free(samples);
+	tellSpeechFinished(spk);
+	return 1;
+}
+
+static void
+releaseAudioCache(void)
+{
+	if (prewarmAlarm) {
+		asyncCancelRequest(prewarmAlarm);
+		prewarmAlarm = NULL;
+	}
+
+	if (synthesisQueue) {
+		destroyQueue(synthesisQueue);
+		synthesisQueue = NULL;
+	}
+
+	if (synthesisLock) {
+		freeLockDescriptor(synthesisLock);
+		synthesisLock = NULL;
+	}
+
+	if (speechCache) {
+		destroySpeechCache(speechCache);
+		speechCache = NULL;
+	}
+
+	if (prewarmCharacters) {
+		free(prewarmCharacters);
+		prewarmCharacters = NULL;
+	}
+
+	if (pcm) {
+		closePcmDevice(pcm);
+		pcm = NULL;
+	}
+}
+
+static int
+createAudioCache(int size, char **parameters)
+{
+	if ((setPcmChannelCount(pcm, 1) != 1) ||
+	    (setPcmSampleRate(pcm, sampleRate) != sampleRate) ||
+	    (setPcmAmplitudeFormat(pcm, PCM_FMT_S16N) != PCM_FMT_S16N)) {
+		logMessage(LOG_ERR, "eSpeak-NG: unsupported PCM configuration: rate=%d", sampleRate);
+		return 0;
+	}
+
+	if (!(speechCache = newSpeechCache(size * 1024))) return 0;
+	if (!(synthesisLock = newLockDescriptor())) return 0;
+	if (!(synthesisQueue = newQueue(deallocateSynthesisRequest, NULL))) return 0;
+
+	if (parameters[PARM_PREWARM] && *parameters[PARM_PREWARM]) {
+		if (!(prewarmCharacters = strdup(parameters[PARM_PREWARM]))) {
+			logMallocError();
+			return 0;
+		}
+	}
+
+	logMessage(LOG_DEBUG, "eSpeak-NG audio cache: size=%dK rate=%d",
+		   size, sampleRate);
+	return 1;
+}
+
+static void
+spk_say(SpeechSynthesizer *spk, const unsigned char *buffer, size_t length, size_t count, const unsigned char *attributes)
+{
+	if (speechCache) {
+		char key[0X100];
+		int cacheable = (count <= CACHE_TEXT_LIMIT) &&
+				makeCacheKey(key, sizeof(key), buffer, length);
+
+		/* cached audio can only bypass the synthesizer when nothing is ahead of it */
+		if (!cacheable || isSynthesisPlaying() || !playCachedSpeech(spk, key))
+			startSynthesisRequest(spk, buffer, length, (cacheable? key: NULL), 1);
+	} else {
+		synthesizeText(buffer, length, spk);
+	}
 }
 
 static void
 spk_mute(SpeechSynthesizer *spk)
 {
 	espeak_Cancel();
+
+	if (speechCache) {
+		int prewarming;
+
+		obtainExclusiveLock(synthesisLock);
+		prewarming = !!findElement(synthesisQueue, testPrewarmRequest, NULL);
+		deleteElements(synthesisQueue);
+		releaseLock(synthesisLock);
+
+		cancelPcmOutput(pcm);
+		if (prewarming) schedulePrewarm(spk);
+	}
 }
 
 static int SynthCallback(short *audio, int numsamples, espeak_EVENT *events)
 {
+	static unsigned int startedMessage = 0;
 	SpeechSynthesizer *spk = events->user_data;
 
 	while (events->type != espeakEVENT_LIST_TERMINATED) {
+		/* playback events are delivered as the audio reaches them */
+		if (events->unique_identifier != startedMessage) {
+			startedMessage = events->unique_identifier;
+			tellSpeechStarted(spk);
+		}
 		if (events->type == espeakEVENT_WORD)
 			tellSpeechLocation(spk, events->text_position - 1);
 		if (events->type == espeakEVENT_MSG_TERMINATED)
@@ -75,6 +514,16 @@ static void
 spk_drain(SpeechSynthesizer *spk)
 {
 	espeak_Synchronize();
+	if (pcm) awaitPcmOutput(pcm);
+}
+
+static void
+changeSetting(SpeechSynthesizer *spk, int *setting, int value)
+{
+	if (*setting != value) {
+		*setting = value;
+		if (speechCache) schedulePrewarm(spk);
+	}
 }
 
 static void
@@ -82,6 +531,7 @@ spk_setVolume(SpeechSynthesizer *spk, unsigned char setting)
 {
 	int volume = getIntegerSpeechVolume(setting, 50);
 	espeak_SetParameter(espeakVOLUME, volume, 0);
+	changeSetting(spk, &currentSettings.volume, volume);
 }
 
 static void
@@ -90,6 +540,7 @@ spk_setRate(SpeechSynthesizer *spk, unsigned char setting)
 	int h_range = (maxrate - espeakRATE_MINIMUM)/2;
 	int rate = getIntegerSpeechRate(setting, h_range) + espeakRATE_MINIMUM;
 	espeak_SetParameter(espeakRATE, rate, 0);
+	changeSetting(spk, &currentSettings.rate, rate);
 }
 
 static void
@@ -97,6 +548,7 @@ spk_setPitch(SpeechSynthesizer *spk, unsigned char setting)
 {
 	int pitch = getIntegerSpeechPitch(setting, 50);
 	espeak_SetParameter(espeakPITCH, pitch, 0);
+	changeSetting(spk, &currentSettings.pitch, pitch);
 }
 
 static void
@@ -112,12 +564,14 @@ spk_setPunctuation(SpeechSynthesizer *spk, SpeechPunctuation setting)
 		punct = espeakPUNCT_ALL;
 
 	espeak_SetParameter(espeakPUNCTUATION, punct, 0);
+	changeSetting(spk, &currentSettings.punctuation, punct);
 }
 
 static int spk_construct(SpeechSynthesizer *spk, char **parameters)
 {
 	const char *data_path, *voicename, *punctlist;
 	int result;
+	int cacheSize = 0;
 
 	spk->setVolume = spk_setVolume;
 	spk->setRate = spk_setRate;
@@ -130,12 +584,44 @@ static int spk_construct(SpeechSynthesizer *spk, char **parameters)
 	data_path = parameters[PARM_PATH];
 	if (data_path && !*data_path)
 		data_path = NULL;
-	result = espeak_Initialize(AUDIO_OUTPUT_PLAYBACK, 0, data_path, 0);
+
+	if (parameters[PARM_CACHE] && *parameters[PARM_CACHE]) {
+		static const int minimum = 0;
+		if (!validateInteger(&cacheSize, parameters[PARM_CACHE], &minimum, NULL)) {
+			logMessage(LOG_WARNING, "eSpeak-NG: invalid cache size: %s", parameters[PARM_CACHE]);
+			cacheSize = 0;
+		}
+	}
+
+	if (cacheSize) {
+		if (!(pcm = openPcmDevice(LOG_WARNING, opt_pcmDevice))) {
+			logMessage(LOG_ERR, "eSpeak-NG: the audio cache requires a PCM device");
+			return 0;
+		}
+
+		result = espeak_Initialize(AUDIO_OUTPUT_RETRIEVAL, 0, data_path, 0);
+	} else {
+		result = espeak_Initialize(AUDIO_OUTPUT_PLAYBACK, 0, data_path, 0);
+	}
+
 	if (result < 0) {
 		logMessage(LOG_ERR, "eSpeak-NG: initialization failed");
+		releaseAudioCache();
 		return 0;
 	}
 
+	if (cacheSize) {
+		sampleRate = result;
+
+		if (!createAudioCache(cacheSize, parameters)) {
+			espeak_Terminate();
+			releaseAudioCache();
+			return 0;
+		}
+
+		schedulePrewarm(spk);
+	}
+
 	voicename = parameters[PARM_VOICE];
 	if(!voicename || !*voicename)
 		voicename = "en";
@@ -150,6 +636,7 @@ static int spk_construct(SpeechSynthesizer *spk, char **parameters)
 		logMessage(LOG_ERR, "eSpeak-NG: unable to load voice '%s'", voicename);
 		return 0;
 	}
+	snprintf(voiceName, sizeof(voiceName), "%s", voicename);
 
 	punctlist = parameters[PARM_PUNCTLIST];
 	if (punctlist && *punctlist) {
@@ -164,7 +651,7 @@ static int spk_construct(SpeechSynthesizer *spk, char **parameters)
 		if (val > espeakRATE_MINIMUM) maxrate = val;
 	}
 
-	espeak_SetSynthCallback(SynthCallback);
+	espeak_SetSynthCallback(speechCache? RetrievalCallback: SynthCallback);
 
 	return 1;
 }
@@ -173,4 +660,5 @@ static void spk_destruct(SpeechSynthesizer *spk)
 {
 	espeak_Cancel();
 	espeak_Terminate();
+	releaseAudioCache();
 }
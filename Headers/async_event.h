@@ -29,6 +29,12 @@ extern AsyncEvent *asyncNewEvent (AsyncEventCallback *callback, void *data);
 extern void asyncDiscardEvent (AsyncEvent *event);
 extern int asyncSignalEvent (AsyncEvent *event, void *data);
 
+/* Signals which arrive before the callback has started are merged into a
+ * single callback (with no signal data), so the caller is expected to keep
+ * what's been signalled (e.g. in a ring buffer) and to handle all of it.
+ */
+extern AsyncEvent *asyncNewCoalescingEvent (AsyncEventCallback *callback, void *data);
+
 typedef AsyncEvent *AsyncEventCreator (void *data);
 
 extern AsyncEvent *asyncGetProgramEvent (
@@ -115,6 +115,50 @@ extern size_t readBraillePacket (
   BraillePacketVerifier *verifyPacket, void *data
 );
 
+typedef enum {
+  BRL_PFC_NONE,
+  BRL_PFC_SUM,
+  BRL_PFC_XOR
+} BraillePacketFrameChecksum;
+
+typedef struct {
+  unsigned char header;             /* the first byte of the packet */
+
+  unsigned char length;             /* the length of the whole packet if it's fixed */
+  unsigned char lengthOffset;       /* else the offset of its length byte */
+  signed char lengthAdjustment;     /* added to the length byte to get the whole length */
+
+  unsigned char hasTrailer:1;       /* the last byte of the packet must be the trailer */
+  unsigned char hasEndMarker:1;     /* the packet ends with the first unescaped trailer */
+  unsigned char hasEscape:1;        /* the escape byte makes the next one literal */
+  unsigned char trailer;
+  unsigned char escape;
+
+  BraillePacketFrameChecksum checksum;
+  unsigned char checksumPosition;   /* counted back from (and including) the last byte */
+} BraillePacketFrame;
+
+typedef int BraillePacketChecker (
+  BrailleDisplay *brl,
+  const unsigned char *packet, size_t length,
+  void *data
+);
+
+typedef struct {
+  const BraillePacketFrame *frames;
+  unsigned char frameCount;
+
+  const BraillePacketFrame *otherFrame;
+  BraillePacketChecker *checkPacket;
+} BraillePacketFraming;
+
+extern size_t readFramedBraillePacket (
+  BrailleDisplay *brl,
+  GioEndpoint *endpoint,
+  void *packet, size_t size,
+  const BraillePacketFraming *framing, void *data
+);
+
 extern int writeBraillePacket (
   BrailleDisplay *brl, GioEndpoint *endpoint,
   const void *packet, size_t size
@@ -66,6 +66,8 @@ typedef int SetAutorepeatPropertiesMethod (BrailleDisplay *brl, int on, int dela
 typedef int GetDriverPropertyMethod (BrailleDisplay *brl, uint64_t property, uint64_t *value);
 typedef int SetDriverPropertyMethod (BrailleDisplay *brl, uint64_t property, uint64_t value);
 
+typedef int BrailleProbeCancelledTester (void *data);
+
 typedef struct {
   struct {
     ContractionCache cache;
@@ -78,6 +80,15 @@ typedef struct {
   } contracted;
 } BrailleRowDescriptor;
 
+#define BRL_PACKET_BUFFER_SIZE 0X200
+
+typedef struct {
+  GioEndpoint *endpoint;
+  unsigned int from;
+  unsigned int to;
+  unsigned char bytes[BRL_PACKET_BUFFER_SIZE];
+} BraillePacketBuffer;
+
 struct BrailleDisplayStruct {
   BrailleData *data;
 
@@ -103,6 +114,15 @@ struct BrailleDisplayStruct {
 
   GioEndpoint *gioEndpoint;
   unsigned int writeDelay;
+  BraillePacketBuffer packetBuffer;
+
+  struct {
+    BrailleProbeCancelledTester *isCancelled;
+    void *data;
+
+    /* if set, the connection is kept for the next driver to connect to it */
+    const char *keepResource;
+  } probe;
 
   unsigned char *buffer;
   void (*bufferResized) (unsigned int rows, unsigned int columns);
@@ -127,8 +147,12 @@ struct BrailleDisplayStruct {
 
   struct {
     Queue *messages;
+    Queue *unacknowledged;
     AsyncHandle alarm;
 
+    unsigned int window;
+    unsigned int sequence;
+
     struct {
       int timeout;
       unsigned int count;
@@ -38,6 +38,17 @@ extern int cellsHaveChanged (
   unsigned int *from, unsigned int *to, unsigned char *force
 );
 
+typedef struct {
+  unsigned int from;
+  unsigned int to;
+} CellRange;
+
+extern unsigned int getChangedCellRanges (
+  unsigned char *cells, const unsigned char *new, unsigned int count,
+  CellRange *ranges, unsigned int size, unsigned int overhead,
+  unsigned char *force
+);
+
 extern int textHasChanged (
   wchar_t *text, const wchar_t *new, unsigned int count,
   unsigned int *from, unsigned int *to, unsigned char *force
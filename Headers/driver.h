@@ -52,6 +52,8 @@ extern void unsupportedDeviceIdentifier (const char *identifier);
 
 extern void logOutputPacket (const void *packet, size_t size);
 extern void logInputPacket (const void *packet, size_t size);
+extern void logChannelOutputPacket (unsigned char channel, const void *packet, size_t size);
+extern void logChannelInputPacket (unsigned char channel, const void *packet, size_t size);
 extern void logInputProblem (const char *problem, const unsigned char *bytes, size_t count);
 extern void logIgnoredByte (unsigned char byte);
 extern void logDiscardedByte (unsigned char byte);
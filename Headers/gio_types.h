@@ -63,6 +63,7 @@ typedef struct {
   int outputTimeout;
   int requestTimeout;
   unsigned char ignoreWriteTimeouts:1;
+  unsigned char lowLatency:1;
 } GioOptions;
 
 typedef struct {
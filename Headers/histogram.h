@@ -0,0 +1,58 @@
+/*
+ * BRLTTY - A background process providing access to the console screen (when in
+ *          text mode) for a blind person using a refreshable braille display.
+ *
+ * Copyright (C) 1995-2026 by The BRLTTY Developers.
+ *
+ * BRLTTY comes with ABSOLUTELY NO WARRANTY.
+ *
+ * This is free software, placed under the terms of the
+ * GNU Lesser General Public License, as published by the Free Software
+ * Foundation; either version 2.1 of the License, or (at your option) any
+ * later version. Please see the file LICENSE-LGPL for details.
+ *
+ * Web Page: http://brltty.app/
+ *
+ * This software is maintained by Dave Mielke <dave@mielke.cc>.
+ */
+
+#ifndef BRLTTY_INCLUDED_HISTOGRAM
+#define BRLTTY_INCLUDED_HISTOGRAM
+
+#include "strfmt_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/*
+ * A log-linear (HDR-style) histogram: each power of two is divided into
+ * HISTOGRAM_SUB_BUCKETS equal buckets, so a value is always recorded with
+ * a relative error of less than 1/HISTOGRAM_SUB_BUCKETS.
+ */
+
+#define HISTOGRAM_SUB_BUCKET_BITS 3
+#define HISTOGRAM_SUB_BUCKETS (1 << HISTOGRAM_SUB_BUCKET_BITS)
+#define HISTOGRAM_BUCKET_COUNT ((32 - HISTOGRAM_SUB_BUCKET_BITS + 1) * HISTOGRAM_SUB_BUCKETS)
+
+typedef struct {
+  uint32_t buckets[HISTOGRAM_BUCKET_COUNT];
+  uint64_t count;
+  uint64_t sum;
+  uint32_t minimum;
+  uint32_t maximum;
+} Histogram;
+
+extern void resetHistogram (Histogram *histogram);
+extern void addHistogramValue (Histogram *histogram, uint32_t value);
+
+extern uint32_t getHistogramMean (const Histogram *histogram);
+extern uint32_t getHistogramPercentile (const Histogram *histogram, unsigned int percent);
+
+extern STR_DECLARE_FORMATTER(formatHistogram, const Histogram *histogram);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* BRLTTY_INCLUDED_HISTOGRAM */
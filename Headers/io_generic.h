@@ -61,6 +61,7 @@ extern int gioReconfigureResource (
 
 extern unsigned int gioGetBytesPerSecond (GioEndpoint *endpoint);
 extern unsigned int gioGetMillisecondsToTransfer (GioEndpoint *endpoint, size_t bytes);
+extern unsigned int gioGetOutputDelay (GioEndpoint *endpoint);
 
 extern ssize_t gioTellResource (
   GioEndpoint *endpoint,
@@ -80,6 +80,7 @@ extern int serialSetDataBits (SerialDevice *serial, unsigned int bits);
 extern int serialSetStopBits (SerialDevice *serial, SerialStopBits bits);
 extern int serialSetParity (SerialDevice *serial, SerialParity parity);
 extern int serialSetFlowControl (SerialDevice *serial, SerialFlowControl flow);
+extern int serialSetLatency (SerialDevice *serial, SerialLatency latency);
 
 extern unsigned int serialGetCharacterSize (const SerialParameters *parameters);
 extern unsigned int serialGetCharacterBits (SerialDevice *serial);
@@ -238,10 +238,13 @@ extern ssize_t usbWriteData (
   int timeout
 );
 
+extern unsigned int usbGetOutputDelay (UsbDevice *device, unsigned char endpointNumber);
+
 extern int usbAddInputFilter (UsbDevice *device, UsbInputFilter *filter);
 
 extern const UsbSerialOperations *usbGetSerialOperations (UsbDevice *device);
 extern int usbSetSerialParameters (UsbDevice *device, const SerialParameters *parameters);
+extern int usbSetSerialLatency (UsbDevice *device, SerialLatency latency);
 
 extern UsbChannel *usbOpenChannel (const UsbChannelDefinition *definitions, const char *identifier);
 extern void usbCloseChannel (UsbChannel *channel);
@@ -252,6 +255,10 @@ extern const char *const *usbGetDriverCodes (uint16_t vendor, uint16_t product);
 #define USB_DEVICE_QUALIFIER "usb"
 extern int isUsbDeviceIdentifier (const char **identifier);
 
+extern size_t usbFormatInputStatistics (char *buffer, size_t size);
+extern void usbLogInputStatistics (void);
+extern void usbResetInputStatistics (void);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
@@ -81,6 +81,8 @@ typedef enum {
   LOG_CATEGORY_INDEX(SPEECH_DRIVER),
   LOG_CATEGORY_INDEX(SCREEN_DRIVER),
 
+  LOG_CATEGORY_INDEX(PERFORMANCE),
+
   LOG_CATEGORY_COUNT /* must be last */
 } LogCategoryIndex;
 
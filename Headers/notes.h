@@ -20,6 +20,7 @@
 #define BRLTTY_INCLUDED_NOTES
 
 #include "note_types.h"
+#include "tune.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -43,6 +44,9 @@ extern float getRealNoteFrequency (unsigned char note);
 
 typedef struct NoteDeviceStruct NoteDevice;
 
+/* called after each part of a whole tune has been written, returns 0 to stop */
+typedef int NoteTonesProgress (void *data);
+
 typedef struct {
   NoteDevice * (*construct) (int errorLevel);
   void (*destruct) (NoteDevice *device);
@@ -51,6 +55,10 @@ typedef struct {
   int (*note) (NoteDevice *device, unsigned int duration, unsigned char note);
 
   int (*flush) (NoteDevice *device);
+  void (*cancel) (NoteDevice *device); /* optional */
+
+  /* optional - plays a whole tune, returns -1 if it should be played tone by tone */
+  int (*tones) (NoteDevice *device, const ToneElement *tones, NoteTonesProgress *progress, void *data);
 } NoteMethods;
 
 extern const NoteMethods beepNoteMethods;
@@ -58,6 +66,14 @@ extern const NoteMethods pcmNoteMethods;
 extern const NoteMethods midiNoteMethods;
 extern const NoteMethods fmNoteMethods;
 
+typedef struct {
+  size_t bufferSize;        /* bytes */
+  unsigned long renderTime; /* microseconds (0 if it was already rendered) */
+} PcmTuneReport;
+
+/* describes (once) the most recent tune that was played as a single buffer */
+extern int getPcmTuneReport (PcmTuneReport *report);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
@@ -0,0 +1,86 @@
+/*
+ * BRLTTY - A background process providing access to the console screen (when in
+ *          text mode) for a blind person using a refreshable braille display.
+ *
+ * Copyright (C) 1995-2026 by The BRLTTY Developers.
+ *
+ * BRLTTY comes with ABSOLUTELY NO WARRANTY.
+ *
+ * This is free software, placed under the terms of the
+ * GNU Lesser General Public License, as published by the Free Software
+ * Foundation; either version 2.1 of the License, or (at your option) any
+ * later version. Please see the file LICENSE-LGPL for details.
+ *
+ * Web Page: http://brltty.app/
+ *
+ * This software is maintained by Dave Mielke <dave@mielke.cc>.
+ */
+
+#ifndef BRLTTY_INCLUDED_PKT_CAPTURE
+#define BRLTTY_INCLUDED_PKT_CAPTURE
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/*
+ * Capture file layout (all multi-byte integers are little-endian):
+ *
+ * file header:
+ *   magic       8 bytes  "BRLPKTS\n"
+ *   version     1 byte
+ *   reserved    3 bytes
+ *   seconds     8 bytes  wall clock time of the first record
+ *   nanoseconds 4 bytes
+ *
+ * record:
+ *   type        1 byte   PCR_INPUT, PCR_OUTPUT, or PCR_CHANNEL
+ *   channel     1 byte   0 if the endpoint isn't known
+ *   size        2 bytes
+ *   delay       varint   microseconds since the previous record (7 bits per byte, low first)
+ *   data        size bytes (the packet, or the channel's resource identifier)
+ */
+
+#define PKT_CAPTURE_MAGIC "BRLPKTS\n"
+#define PKT_CAPTURE_MAGIC_SIZE 8
+#define PKT_CAPTURE_VERSION 1
+#define PKT_CAPTURE_HEADER_SIZE (PKT_CAPTURE_MAGIC_SIZE + 4 + 8 + 4)
+
+#define PKT_CAPTURE_DEFAULT_FILE_SIZE 0X100000
+#define PKT_CAPTURE_DEFAULT_FILE_COUNT 4
+
+typedef enum {
+  PCR_INPUT   = 'I',
+  PCR_OUTPUT  = 'O',
+  PCR_CHANNEL = 'C',
+} PacketCaptureRecordType;
+
+typedef const char *PacketCaptureIdentifierMaker (const void *object, char *buffer, size_t size);
+
+extern int openPacketCapture (const char *path, size_t fileSize, unsigned int fileCount);
+extern void closePacketCapture (void);
+extern int isCapturingPackets (void);
+
+/* a suspended capture is resumed into a new file (the previous one is rotated)
+ * unless there is only one file, in which case it is appended to
+ */
+extern int suspendPacketCapture (void);
+extern int resumePacketCapture (void);
+
+extern unsigned char getPacketCaptureChannel (
+  const void *object,
+  PacketCaptureIdentifierMaker *makeIdentifier
+);
+
+extern void forgetPacketCaptureChannel (const void *object);
+
+extern void capturePacket (
+  PacketCaptureRecordType type, unsigned char channel,
+  const void *packet, size_t size
+);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* BRLTTY_INCLUDED_PKT_CAPTURE */
@@ -30,6 +30,7 @@ extern "C" {
 
 #undef HAVE_BUILTIN_POPCOUNT
 #undef HAVE_SYNC_SYNCHRONIZE
+#undef HAVE_SYNC_LOCK_TEST_AND_SET
 
 #ifdef __has_builtin
 #if __has_builtin(__builtin_popcount)
@@ -39,6 +40,10 @@ extern "C" {
 #if __has_builtin(__sync_synchronize)
 #define HAVE_SYNC_SYNCHRONIZE
 #endif /* __has_builtin(__sync_synchronize) */
+
+#if __has_builtin(__sync_lock_test_and_set)
+#define HAVE_SYNC_LOCK_TEST_AND_SET
+#endif /* __has_builtin(__sync_lock_test_and_set) */
 #endif /* __has_builtin */
 
 #ifndef HAVE_SYNC_SYNCHRONIZE
@@ -34,6 +34,14 @@ extern void clearScreenCharacters (ScreenCharacter *characters, size_t count);
 extern void setScreenCharacterText (ScreenCharacter *characters, size_t count, wchar_t text);
 extern void setScreenCharacterColor (ScreenCharacter *characters, size_t count, const ScreenColor *color);
 
+/* Set matches[shift] if the text of to[shift...] is the same as that of the
+ * start of from, for every shift within length (this takes linear time).
+ */
+extern void findShiftedMatches (
+  const ScreenCharacter *from, const ScreenCharacter *to,
+  int length, unsigned char *matches
+);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
@@ -55,6 +55,11 @@ typedef enum {
   SERIAL_FLOW_NONE       = 0X00  /* no input or output flow control */
 } SerialFlowControl;
 
+typedef enum {
+  SERIAL_LATENCY_DEFAULT,
+  SERIAL_LATENCY_LOW
+} SerialLatency;
+
 typedef struct {
   unsigned int baud;
   unsigned int dataBits;
@@ -36,6 +36,9 @@ extern int muteSpeech (SpeechSynthesizer *spk, const char *reason);
 extern int canDrainSpeech (SpeechSynthesizer *spk);
 extern int drainSpeech (SpeechSynthesizer *spk);
 
+/* waits until the driver has handled all of the requests before this one */
+extern int synchronizeSpeech (SpeechSynthesizer *spk);
+
 extern int sayUtf8Characters (
   SpeechSynthesizer *spk,
   const char *text, const unsigned char *attributes,
@@ -70,6 +73,21 @@ extern int canSetSpeechPunctuation (SpeechSynthesizer *spk);
 extern int setSpeechPunctuation (SpeechSynthesizer *spk, SpeechPunctuation setting, int say);
 extern const char *getSpeechPunctuation (unsigned char level);
 
+/* estimated milliseconds to speak what's queued, or -1 if not yet known */
+extern int getSpeechBacklog (SpeechSynthesizer *spk);
+
+extern size_t formatSpeechQueueStatistics (char *buffer, size_t size);
+extern void logSpeechQueueStatistics (void);
+extern void resetSpeechQueueStatistics (void);
+
+extern size_t formatSpeechLatencyStatistics (char *buffer, size_t size);
+extern void logSpeechLatencyStatistics (void);
+extern void resetSpeechLatencyStatistics (void);
+
+extern size_t formatSpeechHandoffStatistics (char *buffer, size_t size);
+extern void logSpeechHandoffStatistics (void);
+extern void resetSpeechHandoffStatistics (void);
+
 extern int haveSpeechDriver (const char *code);
 extern const char *getDefaultSpeechDriver (void);
 extern const SpeechDriver *loadSpeechDriver (const char *code, void **driverObject, const char *driverDirectory);
@@ -25,9 +25,13 @@
 extern "C" {
 #endif /* __cplusplus */
 
+extern int tellSpeechStarted (SpeechSynthesizer *spk);
 extern int tellSpeechFinished (SpeechSynthesizer *spk);
 extern int tellSpeechLocation (SpeechSynthesizer *spk, int index);
 
+/* changes whenever speech is muted - a driver which is busy can poll it */
+extern unsigned int getSpeechMuteCount (SpeechSynthesizer *spk);
+
 extern unsigned int getIntegerSpeechVolume (unsigned char setting, unsigned int normal);
 extern unsigned int getIntegerSpeechRate (unsigned char setting, unsigned int normal);
 extern unsigned int getIntegerSpeechPitch (unsigned char setting, unsigned int normal);
@@ -0,0 +1,63 @@
+/*
+ * BRLTTY - A background process providing access to the console screen (when in
+ *          text mode) for a blind person using a refreshable braille display.
+ *
+ * Copyright (C) 1995-2026 by The BRLTTY Developers.
+ *
+ * BRLTTY comes with ABSOLUTELY NO WARRANTY.
+ *
+ * This is free software, placed under the terms of the
+ * GNU Lesser General Public License, as published by the Free Software
+ * Foundation; either version 2.1 of the License, or (at your option) any
+ * later version. Please see the file LICENSE-LGPL for details.
+ *
+ * Web Page: http://brltty.app/
+ *
+ * This software is maintained by Dave Mielke <dave@mielke.cc>.
+ */
+
+
+#ifndef BRLTTY_INCLUDED_SPK_CACHE
+#define BRLTTY_INCLUDED_SPK_CACHE
+
+#include "timing_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/*
+ * A bounded, least-recently-used cache of rendered audio for short
+ * utterances (characters, punctuation names, key echoes). It's meant for
+ * speech drivers which render the samples themselves and play them through
+ * the PCM interface. The key must capture everything which affects the
+ * rendering - typically the voice, rate, pitch, volume, and the text.
+ */
+
+typedef struct SpeechCacheStruct SpeechCache;
+
+extern SpeechCache *newSpeechCache (size_t maximumSize);
+extern void destroySpeechCache (SpeechCache *cache);
+
+extern int getSpeechCacheAudio (
+  SpeechCache *cache, const char *key,
+  int16_t **samples, size_t *count
+);
+
+extern int putSpeechCacheAudio (
+  SpeechCache *cache, const char *key,
+  const int16_t *samples, size_t count
+);
+
+extern int isSpeechCached (SpeechCache *cache, const char *key);
+extern void addSpeechCacheFirstSample (SpeechCache *cache, int cached, const TimeValue *start);
+
+extern size_t formatSpeechCacheStatistics (SpeechCache *cache, char *buffer, size_t size);
+extern void logSpeechCacheStatistics (SpeechCache *cache);
+extern void logAllSpeechCacheStatistics (void);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* BRLTTY_INCLUDED_SPK_CACHE */
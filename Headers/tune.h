@@ -49,6 +49,7 @@ extern void suppressTuneDeviceOpenErrors (void);
 
 typedef enum {
   TPO_FREE = 0X01,
+  TPO_SUPERSEDE = 0X02, /* may be cut short by a newer superseding tune */
 } TunePlayOptions;
 
 extern int tuneSetDevice (TuneDevice device);
@@ -57,6 +58,10 @@ extern void tunePlayTones (const ToneElement *tune, TunePlayOptions options);
 extern void tuneWait (int time);
 extern void tuneSynchronize (void);
 
+extern size_t formatTuneLatencyStatistics (char *buffer, size_t size);
+extern void logTuneLatencyStatistics (void);
+extern void resetTuneLatencyStatistics (void);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
@@ -43,6 +43,7 @@ extern void destroyTuneBuilder (TuneBuilder *tb);
 
 extern TuneStatus getTuneStatus (TuneBuilder *tb);
 extern void setTuneSourceName (TuneBuilder *tb, const char *name);
+extern const char *getTuneSourceName (TuneBuilder *tb);
 extern void setTuneSourceIndex (TuneBuilder *tb, unsigned int index);
 extern void incrementTuneSourceIndex (TuneBuilder *tb);
 
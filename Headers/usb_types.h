@@ -289,6 +289,9 @@ typedef struct {
   unsigned char inputEndpoint;
   unsigned char outputEndpoint;
 
+  uint16_t outputQueueLimit;
+  unsigned char unorderedOutput:1;
+
   unsigned char disableAutosuspend:1;
   unsigned char disableEndpointReset:1;
   unsigned char verifyInterface:1;
@@ -331,6 +334,7 @@ typedef struct {
   int (*setBaud) (UsbDevice *device, unsigned int baud);
   int (*setDataFormat) (UsbDevice *device, unsigned int dataBits, SerialStopBits stopBits, SerialParity parity);
   int (*setFlowControl) (UsbDevice *device, SerialFlowControl flow);
+  int (*setLatency) (UsbDevice *device, SerialLatency latency);
 
   int (*setDtrState) (UsbDevice *device, int state);
   int (*setRtsState) (UsbDevice *device, int state);
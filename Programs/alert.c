@@ -302,7 +302,7 @@ alert (AlertIdentifier identifier) {
         if (!*tune) *tune = emptyTune;
       }
 
-      tunePlayTones(*tune, 0);
+      tunePlayTones(*tune, TPO_SUPERSEDE);
     } else if (prefs.alertMessages && alert->message) {
       message("alert", gettext(alert->message), 0);
     } else if (prefs.alertDots && alert->tactile.pattern) {
@@ -20,6 +20,10 @@
 
 #include <string.h>
 
+#ifdef HAVE_SYS_EVENTFD_H
+#include <sys/eventfd.h>
+#endif /* HAVE_SYS_EVENTFD_H */
+
 #include "log.h"
 #include "async_io.h"
 #include "async_event.h"
@@ -37,18 +41,43 @@ struct AsyncEventStruct {
   FileDescriptor monitorDescriptor;
   AsyncHandle monitorHandle;
 
+  unsigned coalesce:1;
+  unsigned isEventDescriptor:1;
+  volatile int signalPending;
+
 #ifdef __MINGW32__
   CRITICAL_SECTION criticalSection;
   unsigned int pendingCount;
 #endif /* __MINGW32__ */
 };
 
+static int
+readEventSignal (AsyncEvent *event, void **data) {
+#ifdef HAVE_SYS_EVENTFD_H
+  if (event->isEventDescriptor) {
+    eventfd_t count;
+    *data = NULL;
+    return eventfd_read(event->pipeOutput, &count) != -1;
+  }
+#endif /* HAVE_SYS_EVENTFD_H */
+
+  const size_t size = sizeof(*data);
+  return readFileDescriptor(event->pipeOutput, data, size) == size;
+}
+
 ASYNC_MONITOR_CALLBACK(asyncMonitorEventPipe) {
   AsyncEvent *event = parameters->data;
   void *data;
-  const size_t size = sizeof(data);
 
-  if (readFileDescriptor(event->pipeOutput, &data, size) == size) {
+  if (readEventSignal(event, &data)) {
+    if (event->coalesce) {
+      /* Any signal from now on needs another callback. The full barrier
+       * ensures that what was signalled before it is seen by this one.
+       */
+      event->signalPending = 0;
+      __sync_synchronize();
+    }
+
 #ifdef __MINGW32__
     EnterCriticalSection(&event->criticalSection);
     if (!--event->pendingCount) ResetEvent(event->monitorDescriptor);
@@ -75,6 +104,28 @@ ASYNC_MONITOR_CALLBACK(asyncMonitorEventPipe) {
 
 int
 asyncSignalEvent (AsyncEvent *event, void *data) {
+  if (event->coalesce) {
+    data = NULL;
+
+    /* make what's being signalled visible before testing for a pending signal */
+    __sync_synchronize();
+
+#ifdef HAVE_SYNC_LOCK_TEST_AND_SET
+    if (__sync_lock_test_and_set(&event->signalPending, 1)) return 1;
+#endif /* HAVE_SYNC_LOCK_TEST_AND_SET */
+
+#ifdef HAVE_SYS_EVENTFD_H
+    if (event->isEventDescriptor) {
+      if (eventfd_write(event->pipeInput, 1) != -1) return 1;
+      logSystemError("eventfd_write");
+
+      /* nothing was signalled so the next signal mustn't be coalesced */
+      event->signalPending = 0;
+      return 0;
+    }
+#endif /* HAVE_SYS_EVENTFD_H */
+  }
+
   const size_t size = sizeof(data);
   ssize_t result = writeFileDescriptor(event->pipeInput, &data, size);
 
@@ -94,27 +145,57 @@ asyncSignalEvent (AsyncEvent *event, void *data) {
     logMessage(LOG_ERR, "short write"); 
   }
 
+  if (event->coalesce) event->signalPending = 0;
   return 0;
 }
 
-AsyncEvent *
-asyncNewEvent (AsyncEventCallback *callback, void *data) {
+static int
+createEventDescriptors (AsyncEvent *event) {
+#ifdef HAVE_SYS_EVENTFD_H
+  if (event->coalesce) {
+    int descriptor = eventfd(0, EFD_CLOEXEC);
+
+    if (descriptor != -1) {
+      event->pipeInput = event->pipeOutput = descriptor;
+      event->isEventDescriptor = 1;
+      return 1;
+    }
+
+    logSystemError("eventfd");
+  }
+#endif /* HAVE_SYS_EVENTFD_H */
+
+  return createAnonymousPipe(&event->pipeInput, &event->pipeOutput);
+}
+
+static void
+closeEventDescriptors (AsyncEvent *event) {
+  closeFileDescriptor(event->pipeInput);
+  if (!event->isEventDescriptor) closeFileDescriptor(event->pipeOutput);
+}
+
+static AsyncEvent *
+newEvent (AsyncEventCallback *callback, void *data, int coalesce) {
   AsyncEvent *event;
 
   if ((event = malloc(sizeof(*event)))) {
     memset(event, 0, sizeof(*event));
     event->callback = callback;
     event->data = data;
+    event->coalesce = !!coalesce;
 
-    if (createAnonymousPipe(&event->pipeInput, &event->pipeOutput)) {
+    if (createEventDescriptors(event)) {
 #ifdef __MINGW32__
       if (!(event->monitorDescriptor = CreateEvent(NULL, TRUE, FALSE, NULL))) {
         logWindowsSystemError("CreateEvent");
         event->monitorDescriptor = INVALID_FILE_DESCRIPTOR;
       }
 #else /* __MINGW32__ */
-      setCloseOnExec(event->pipeInput, 1);
-      setCloseOnExec(event->pipeOutput, 1);
+      if (!event->isEventDescriptor) {
+        setCloseOnExec(event->pipeInput, 1);
+        setCloseOnExec(event->pipeOutput, 1);
+      }
+
       event->monitorDescriptor = event->pipeOutput;
 #endif /* __MINGW32__ */
 
@@ -130,11 +211,12 @@ asyncNewEvent (AsyncEventCallback *callback, void *data) {
           return event;
         }
 
+#ifdef __MINGW32__
         closeFileDescriptor(event->monitorDescriptor);
+#endif /* __MINGW32__ */
       }
 
-      closeFileDescriptor(event->pipeInput);
-      closeFileDescriptor(event->pipeOutput);
+      closeEventDescriptors(event);
     }
 
     free(event);
@@ -145,12 +227,20 @@ asyncNewEvent (AsyncEventCallback *callback, void *data) {
   return NULL;
 }
 
+AsyncEvent *
+asyncNewEvent (AsyncEventCallback *callback, void *data) {
+  return newEvent(callback, data, 0);
+}
+
+AsyncEvent *
+asyncNewCoalescingEvent (AsyncEventCallback *callback, void *data) {
+  return newEvent(callback, data, 1);
+}
+
 void
 asyncDiscardEvent (AsyncEvent *event) {
   asyncCancelRequest(event->monitorHandle);
-
-  closeFileDescriptor(event->pipeInput);
-  closeFileDescriptor(event->pipeOutput);
+  closeEventDescriptors(event);
 
 #ifdef __MINGW32__
   CloseHandle(event->monitorDescriptor);
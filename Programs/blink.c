@@ -210,6 +210,35 @@ requireBlinkDescriptor (BlinkDescriptor *blink) {
   blink->isRequired = 1;
 }
 
+unsigned int
+getVisibleBlinkDescriptors (void) {
+  unsigned int mask = 0;
+
+  for (unsigned int index=0; blinkDescriptors[index]; index+=1) {
+    if (isBlinkVisible(blinkDescriptors[index])) mask |= 1 << index;
+  }
+
+  return mask;
+}
+
+unsigned int
+getRequiredBlinkDescriptors (void) {
+  unsigned int mask = 0;
+
+  for (unsigned int index=0; blinkDescriptors[index]; index+=1) {
+    if (blinkDescriptors[index]->isRequired) mask |= 1 << index;
+  }
+
+  return mask;
+}
+
+void
+requireBlinkDescriptors (unsigned int mask) {
+  for (unsigned int index=0; blinkDescriptors[index]; index+=1) {
+    if (mask & (1 << index)) requireBlinkDescriptor(blinkDescriptors[index]);
+  }
+}
+
 static void
 stopBlinkDescriptor (BlinkDescriptor *blink) {
   if (blink->alarmHandle) {
@@ -52,6 +52,10 @@ extern void setBlinkState (BlinkDescriptor *blink, int visible);
 extern void unrequireAllBlinkDescriptors (void);
 extern void requireBlinkDescriptor (BlinkDescriptor *blink);
 
+extern unsigned int getVisibleBlinkDescriptors (void);
+extern unsigned int getRequiredBlinkDescriptors (void);
+extern void requireBlinkDescriptors (unsigned int mask);
+
 extern void resetAllBlinkDescriptors (void);
 extern void stopAllBlinkDescriptors (void);
 
@@ -60,6 +60,14 @@ constructBrailleDisplay (BrailleDisplay *brl) {
   brl->gioEndpoint = NULL;
   brl->writeDelay = 0;
 
+  brl->packetBuffer.endpoint = NULL;
+  brl->packetBuffer.from = 0;
+  brl->packetBuffer.to = 0;
+
+  brl->probe.isCancelled = NULL;
+  brl->probe.data = NULL;
+  brl->probe.keepResource = NULL;
+
   brl->buffer = NULL;
   brl->bufferResized = NULL;
 
@@ -78,7 +86,10 @@ constructBrailleDisplay (BrailleDisplay *brl) {
   brl->hideCursor = 0;
 
   brl->acknowledgements.messages = NULL;
+  brl->acknowledgements.unacknowledged = NULL;
   brl->acknowledgements.alarm = NULL;
+  brl->acknowledgements.window = BRAILLE_MESSAGE_WINDOW_SIZE;
+  brl->acknowledgements.sequence = 0;
   brl->acknowledgements.missing.timeout = BRAILLE_MESSAGE_ACKNOWLEDGEMENT_TIMEOUT;
   brl->acknowledgements.missing.count = 0;
   brl->acknowledgements.missing.limit = BRAILLE_MESSAGE_UNACKNOWLEDGEED_LIMIT;
@@ -120,6 +131,11 @@ destructBrailleDisplay (BrailleDisplay *brl) {
     brl->acknowledgements.messages = NULL;
   }
 
+  if (brl->acknowledgements.unacknowledged) {
+    destroyQueue(brl->acknowledgements.unacknowledged);
+    brl->acknowledgements.unacknowledged = NULL;
+  }
+
   if (brl->keyTable) {
     destroyKeyTable(brl->keyTable);
     brl->keyTable = NULL;
@@ -31,6 +31,7 @@ extern "C" {
 extern void constructBrailleDisplay (BrailleDisplay *brl);
 extern int ensureBrailleBuffer (BrailleDisplay *brl, int infoLevel);
 extern void destructBrailleDisplay (BrailleDisplay *brl);
+extern void discardKeptBrailleResource (void);
 
 extern void fillTextRegion (
   wchar_t *text, unsigned char *dots,
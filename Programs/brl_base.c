@@ -21,12 +21,15 @@
 #include <string.h>
 #include <errno.h>
 
+#include "parameters.h"
 #include "log.h"
 #include "report.h"
 #include "api_control.h"
 #include "queue.h"
 #include "async_handle.h"
 #include "async_alarm.h"
+#include "timing.h"
+#include "brl.h"
 #include "brl_base.h"
 #include "brl_utils.h"
 #include "brl_dots.h"
@@ -34,6 +37,8 @@
 #include "io_generic.h"
 #include "cmd_queue.h"
 #include "ktb.h"
+#include "pkt_capture.h"
+#include "brl_latency.h"
 
 const DotsTable dotsTable_ISO11548_1 = {
   BRL_DOT_1, BRL_DOT_2, BRL_DOT_3, BRL_DOT_4,
@@ -140,9 +145,104 @@ translateInputCell (unsigned char cell) {
   return translateCell(inputTable, cell);
 }
 
+static inline int
+haveBufferedBrailleInput (BrailleDisplay *brl, GioEndpoint *endpoint) {
+  const BraillePacketBuffer *pb = &brl->packetBuffer;
+  return (pb->endpoint == endpoint) && (pb->from < pb->to);
+}
+
+#ifndef ECANCELED
+#define ECANCELED EINTR
+#endif /* ECANCELED */
+
+static int
+isBrailleProbeCancelled (BrailleDisplay *brl) {
+  BrailleProbeCancelledTester *isCancelled = brl->probe.isCancelled;
+  if (!isCancelled) return 0;
+  if (!isCancelled(brl->probe.data)) return 0;
+
+  logMessage(LOG_CATEGORY(BRAILLE_DRIVER), "probe cancelled");
+  errno = ECANCELED;
+  return 1;
+}
+
+static int
+awaitEndpointInput (BrailleDisplay *brl, GioEndpoint *endpoint, int timeout) {
+  if (!brl->probe.isCancelled) return gioAwaitInput(endpoint, timeout);
+
+  /* a probe which may be cancelled waits in slices so that it notices */
+  TimeValue start;
+  getMonotonicTime(&start);
+  int left = timeout;
+
+  while (1) {
+    if (isBrailleProbeCancelled(brl)) return 0;
+    if (gioAwaitInput(endpoint, MIN(left, BRAILLE_PROBE_CANCEL_CHECK_INTERVAL))) return 1;
+    if (errno != EAGAIN) return 0;
+
+    if ((left = timeout - getMonotonicElapsed(&start)) <= 0) {
+      errno = EAGAIN;
+      return 0;
+    }
+  }
+}
+
 int
 awaitBrailleInput (BrailleDisplay *brl, int timeout) {
-  return gioAwaitInput(brl->gioEndpoint, timeout);
+  if (haveBufferedBrailleInput(brl, brl->gioEndpoint)) return 1;
+  return awaitEndpointInput(brl, brl->gioEndpoint, timeout);
+}
+
+/* The winning probe of a concurrent autodetection keeps its connection here,
+ * and the driver then constructed on the main thread picks it up. The probe
+ * threads have all been joined by then.
+ */
+static struct {
+  GioEndpoint *endpoint;
+  char *identifier;
+} keptBrailleResource = {
+  .endpoint = NULL,
+  .identifier = NULL
+};
+
+static void
+keepBrailleResource (const char *identifier, GioEndpoint *endpoint) {
+  discardKeptBrailleResource();
+
+  if ((keptBrailleResource.identifier = strdup(identifier))) {
+    keptBrailleResource.endpoint = endpoint;
+    logMessage(LOG_CATEGORY(BRAILLE_DRIVER), "connection kept: %s", identifier);
+  } else {
+    logMallocError();
+    gioDisconnectResource(endpoint);
+  }
+}
+
+static GioEndpoint *
+takeKeptBrailleResource (const char *identifier) {
+  GioEndpoint *endpoint = keptBrailleResource.endpoint;
+  if (!endpoint) return NULL;
+  if (strcmp(identifier, keptBrailleResource.identifier) != 0) return NULL;
+
+  free(keptBrailleResource.identifier);
+  keptBrailleResource.identifier = NULL;
+  keptBrailleResource.endpoint = NULL;
+
+  logMessage(LOG_CATEGORY(BRAILLE_DRIVER), "connection reused: %s", identifier);
+  return endpoint;
+}
+
+void
+discardKeptBrailleResource (void) {
+  if (keptBrailleResource.endpoint) {
+    gioDisconnectResource(keptBrailleResource.endpoint);
+    keptBrailleResource.endpoint = NULL;
+  }
+
+  if (keptBrailleResource.identifier) {
+    free(keptBrailleResource.identifier);
+    keptBrailleResource.identifier = NULL;
+  }
 }
 
 int
@@ -152,7 +252,8 @@ connectBrailleResource (
   const GioDescriptor *descriptor,
   BrailleSessionInitializer *initializeSession
 ) {
-  if ((brl->gioEndpoint = gioConnectResource(identifier, descriptor))) {
+  if ((brl->gioEndpoint = takeKeptBrailleResource(identifier)) ||
+      (brl->gioEndpoint = gioConnectResource(identifier, descriptor))) {
     if (!initializeSession || initializeSession(brl)) {
       if (gioDiscardInput(brl->gioEndpoint)) {
         return 1;
@@ -166,17 +267,51 @@ connectBrailleResource (
   return 0;
 }
 
+static const char *
+makeEndpointIdentifier (const void *object, char *buffer, size_t size) {
+  GioEndpoint *endpoint = (GioEndpoint *)object;
+  return gioMakeResourceIdentifier(endpoint, buffer, size);
+}
+
+static inline unsigned char
+getEndpointCaptureChannel (GioEndpoint *endpoint) {
+  if (!isCapturingPackets()) return 0;
+  return getPacketCaptureChannel(endpoint, makeEndpointIdentifier);
+}
+
 void
 disconnectBrailleResource (
   BrailleDisplay *brl,
   BrailleSessionEnder *endSession
 ) {
   if (brl->gioEndpoint) {
-    if (endSession) endSession(brl);
-    drainBrailleOutput(brl, 0);
-    gioDisconnectResource(brl->gioEndpoint);
+    if (brl->probe.keepResource) {
+      /* the session stays open for the driver which is about to take it over */
+      drainBrailleOutput(brl, 0);
+      forgetPacketCaptureChannel(brl->gioEndpoint);
+      keepBrailleResource(brl->probe.keepResource, brl->gioEndpoint);
+    } else {
+      if (endSession) endSession(brl);
+      drainBrailleOutput(brl, 0);
+      forgetPacketCaptureChannel(brl->gioEndpoint);
+      gioDisconnectResource(brl->gioEndpoint);
+    }
+
     brl->gioEndpoint = NULL;
   }
+
+  brl->packetBuffer.endpoint = NULL;
+  brl->packetBuffer.from = brl->packetBuffer.to = 0;
+}
+
+static int
+readBrailleByte (BrailleDisplay *brl, GioEndpoint *endpoint, unsigned char *byte, int wait) {
+  if (haveBufferedBrailleInput(brl, endpoint)) {
+    *byte = brl->packetBuffer.bytes[brl->packetBuffer.from++];
+    return 1;
+  }
+
+  return gioReadByte(endpoint, byte, wait);
 }
 
 size_t
@@ -196,7 +331,7 @@ readBraillePacket (
   while (1) {
     unsigned char byte;
 
-    if (!gioReadByte(endpoint, &byte, started)) {
+    if (!readBrailleByte(brl, endpoint, &byte, started)) {
       if (count > 0) logPartialPacket(bytes, count);
       return 0;
     }
@@ -236,7 +371,7 @@ readBraillePacket (
       }
 
       if (count >= length) {
-        logInputPacket(bytes, length);
+        logChannelInputPacket(getEndpointCaptureChannel(endpoint), bytes, length);
         return length;
       }
     } else {
@@ -246,17 +381,214 @@ readBraillePacket (
   }
 }
 
+static int
+fillBraillePacketBuffer (BrailleDisplay *brl, GioEndpoint *endpoint, int wait) {
+  BraillePacketBuffer *pb = &brl->packetBuffer;
+
+  if (pb->endpoint != endpoint) {
+    if (pb->from < pb->to) logDiscardedBytes(&pb->bytes[pb->from], pb->to - pb->from);
+    pb->endpoint = endpoint;
+    pb->from = pb->to = 0;
+  } else if (pb->from > 0) {
+    memmove(pb->bytes, &pb->bytes[pb->from], (pb->to -= pb->from));
+    pb->from = 0;
+  }
+
+  if (pb->to == sizeof(pb->bytes)) return 1;
+  ssize_t count = gioReadData(endpoint, &pb->bytes[pb->to], sizeof(pb->bytes) - pb->to, wait);
+
+  if (count > 0) {
+    pb->to += count;
+    return 1;
+  }
+
+  return 0;
+}
+
+static const BraillePacketFrame *
+getBraillePacketFrame (const BraillePacketFraming *framing, unsigned char header) {
+  const BraillePacketFrame *frame = framing->frames;
+  const BraillePacketFrame *end = frame + framing->frameCount;
+
+  while (frame < end) {
+    if (frame->header == header) return frame;
+    frame += 1;
+  }
+
+  return framing->otherFrame;
+}
+
+static int
+getBraillePacketLength (
+  const BraillePacketFrame *frame,
+  const unsigned char *bytes, size_t count,
+  size_t *length
+) {
+  if (frame->hasEndMarker) {
+    int escaped = 0;
+
+    for (size_t index=1; index<count; index+=1) {
+      unsigned char byte = bytes[index];
+
+      if (escaped) {
+        escaped = 0;
+      } else if (frame->hasEscape && (byte == frame->escape)) {
+        escaped = 1;
+      } else if (byte == frame->trailer) {
+        *length = index + 1;
+        return 1;
+      }
+    }
+
+    return 0;
+  }
+
+  if (frame->length) {
+    *length = frame->length;
+    return 1;
+  }
+
+  if (frame->lengthOffset < count) {
+    int value = bytes[frame->lengthOffset] + frame->lengthAdjustment;
+    *length = MAX(value, frame->lengthOffset+1);
+    return 1;
+  }
+
+  return 0;
+}
+
+static int
+verifyBraillePacketFrame (
+  const BraillePacketFrame *frame,
+  const unsigned char *bytes, size_t length
+) {
+  if (frame->hasTrailer || frame->hasEndMarker) {
+    if (bytes[length-1] != frame->trailer) {
+      logInputProblem("incorrect input trailer", bytes, length);
+      return 0;
+    }
+  }
+
+  if (frame->checksum != BRL_PFC_NONE) {
+    if (frame->checksumPosition > length) {
+      logInputProblem("input packet too short for checksum", bytes, length);
+      return 0;
+    }
+
+    size_t position = length - frame->checksumPosition;
+    unsigned char checksum = 0;
+
+    for (size_t index=0; index<length; index+=1) {
+      if (index == position) continue;
+
+      switch (frame->checksum) {
+        case BRL_PFC_SUM:
+          checksum += bytes[index];
+          break;
+
+        case BRL_PFC_XOR:
+          checksum ^= bytes[index];
+          break;
+
+        default:
+          break;
+      }
+    }
+
+    if (checksum != bytes[position]) {
+      logInputProblem("incorrect input checksum", bytes, length);
+      return 0;
+    }
+  }
+
+  return 1;
+}
+
+size_t
+readFramedBraillePacket (
+  BrailleDisplay *brl,
+  GioEndpoint *endpoint,
+  void *packet, size_t size,
+  const BraillePacketFraming *framing, void *data
+) {
+  if (!endpoint) endpoint = brl->gioEndpoint;
+  BraillePacketBuffer *pb = &brl->packetBuffer;
+
+  if (pb->endpoint != endpoint) {
+    if (!fillBraillePacketBuffer(brl, endpoint, 0)) return 0;
+  }
+
+  while (1) {
+    if (pb->from == pb->to) {
+      if (!fillBraillePacketBuffer(brl, endpoint, 0)) return 0;
+    }
+
+    const unsigned char *bytes = &pb->bytes[pb->from];
+    size_t count = pb->to - pb->from;
+    const BraillePacketFrame *frame = getBraillePacketFrame(framing, bytes[0]);
+
+    if (!frame) {
+      logIgnoredByte(bytes[0]);
+      pb->from += 1;
+      continue;
+    }
+
+    size_t length;
+
+    if (!getBraillePacketLength(frame, bytes, count, &length) || (count < length)) {
+      if (count == sizeof(pb->bytes)) {
+        logInputProblem("input packet too long", bytes, count);
+        pb->from += 1;
+        continue;
+      }
+
+      if (!fillBraillePacketBuffer(brl, endpoint, 1)) {
+        logPartialPacket(&pb->bytes[pb->from], pb->to - pb->from);
+        pb->from = pb->to;
+        return 0;
+      }
+
+      continue;
+    }
+
+    if (!verifyBraillePacketFrame(frame, bytes, length) ||
+        (framing->checkPacket && !framing->checkPacket(brl, bytes, length, data))) {
+      pb->from += 1;
+      continue;
+    }
+
+    pb->from += length;
+    logChannelInputPacket(getEndpointCaptureChannel(endpoint), bytes, length);
+
+    if (length > size) {
+      logTruncatedPacket(bytes, size);
+      continue;
+    }
+
+    memcpy(packet, bytes, length);
+    return length;
+  }
+}
+
 int
 writeBraillePacket (
   BrailleDisplay *brl, GioEndpoint *endpoint,
   const void *packet, size_t size
 ) {
   if (!endpoint) endpoint = brl->gioEndpoint;
-  logOutputPacket(packet, size);
+  if (isBrailleProbeCancelled(brl)) return 0;
+
+  logChannelOutputPacket(getEndpointCaptureChannel(endpoint), packet, size);
   if (gioWriteData(endpoint, packet, size) == -1) return 0;
 
   if (endpoint == brl->gioEndpoint) {
     brl->writeDelay += gioGetMillisecondsToTransfer(endpoint, size);
+
+    {
+      /* Queued (asynchronous) output which hasn't been sent yet. */
+      unsigned int delay = gioGetOutputDelay(endpoint);
+      if (delay > brl->writeDelay) brl->writeDelay = delay;
+    }
   }
 
   return 1;
@@ -265,13 +597,15 @@ writeBraillePacket (
 typedef struct {
   GioEndpoint *endpoint;
   unsigned int type;
+  unsigned int sequence;
+  TimeValue time;
   size_t size;
   unsigned char packet[];
 } BrailleMessage;
 
 static void
 logBrailleMessage (BrailleMessage *msg, const char *action) {
-  logBytes(LOG_CATEGORY(OUTPUT_PACKETS), "%s", msg->packet, msg->size, action);
+  logBytes(LOG_CATEGORY(OUTPUT_PACKETS), "%s #%u", msg->packet, msg->size, action, msg->sequence);
 }
 
 static void
@@ -279,6 +613,25 @@ deallocateBrailleMessage (BrailleMessage *msg) {
   free(msg);
 }
 
+static void
+deallocateBrailleMessageItem (void *item, void *data) {
+  BrailleMessage *msg = item;
+
+  deallocateBrailleMessage(msg);
+}
+
+static Queue *
+getBrailleMessageQueue (Queue **queue) {
+  if (!*queue) *queue = newQueue(deallocateBrailleMessageItem, NULL);
+  return *queue;
+}
+
+static unsigned int
+getUnacknowledgedBrailleMessageCount (BrailleDisplay *brl) {
+  Queue *queue = brl->acknowledgements.unacknowledged;
+  return queue? getQueueSize(queue): 0;
+}
+
 static void
 cancelBrailleMessageAlarm (BrailleDisplay *brl) {
   if (brl->acknowledgements.alarm) {
@@ -287,67 +640,83 @@ cancelBrailleMessageAlarm (BrailleDisplay *brl) {
   }
 }
 
-static void setBrailleMessageAlarm (BrailleDisplay *brl);
+ASYNC_ALARM_CALLBACK(handleBrailleMessageTimeout);
+
+static void
+setBrailleMessageAlarm (BrailleDisplay *brl) {
+  Queue *queue = brl->acknowledgements.unacknowledged;
+  Element *element = queue? getQueueHead(queue): NULL;
+
+  if (element) {
+    /* one alarm for the whole window: it expires with the oldest message */
+    const BrailleMessage *msg = getElementItem(element);
+    TimeValue time = msg->time;
+    adjustTimeValue(&time, brl->acknowledgements.missing.timeout);
+
+    if (brl->acknowledgements.alarm) {
+      asyncResetAlarmTo(brl->acknowledgements.alarm, &time);
+    } else {
+      asyncNewAbsoluteAlarm(&brl->acknowledgements.alarm, &time,
+                            handleBrailleMessageTimeout, brl);
+    }
+  } else {
+    cancelBrailleMessageAlarm(brl);
+  }
+}
 
 static int
-writeNextBrailleMessage (BrailleDisplay *brl) {
-  int ok = 1;
+sendBrailleMessage (BrailleDisplay *brl, BrailleMessage *msg) {
+  Queue *queue = getBrailleMessageQueue(&brl->acknowledgements.unacknowledged);
 
-  if (brl->acknowledgements.messages) {
-    BrailleMessage *msg = dequeueItem(brl->acknowledgements.messages);
+  if (queue) {
+    if (writeBraillePacket(brl, msg->endpoint, msg->packet, msg->size)) {
+      getMonotonicTime(&msg->time);
+      if (enqueueItem(queue, msg)) return 1;
+    }
+  }
 
-    if (msg) {
-      int written;
+  logBrailleMessage(msg, "discarded");
+  deallocateBrailleMessage(msg);
+  return 0;
+}
 
-      logBrailleMessage(msg, "dequeued");
-      written = writeBraillePacket(brl, msg->endpoint, msg->packet, msg->size);
+static int
+writeNextBrailleMessages (BrailleDisplay *brl) {
+  int ok = 1;
+  Queue *queue = brl->acknowledgements.messages;
 
-      deallocateBrailleMessage(msg);
-      msg = NULL;
+  if (queue) {
+    while (getUnacknowledgedBrailleMessageCount(brl) < brl->acknowledgements.window) {
+      BrailleMessage *msg = dequeueItem(queue);
+      if (!msg) break;
 
-      if (written) {
-        setBrailleMessageAlarm(brl);
-        return 1;
-      }
+      logBrailleMessage(msg, "dequeued");
 
-      ok = 0;
+      if (!sendBrailleMessage(brl, msg)) {
+        ok = 0;
+        break;
+      }
     }
   }
 
-  cancelBrailleMessageAlarm(brl);
+  setBrailleMessageAlarm(brl);
   return ok;
 }
 
 int
 acknowledgeBrailleMessage (BrailleDisplay *brl) {
-  logMessage(LOG_CATEGORY(OUTPUT_PACKETS), "acknowledged");
-  brl->acknowledgements.missing.count = 0;
-  return writeNextBrailleMessage(brl);
-}
-
-ASYNC_ALARM_CALLBACK(handleBrailleMessageTimeout) {
-  BrailleDisplay *brl = parameters->data;
+  Queue *queue = brl->acknowledgements.unacknowledged;
+  BrailleMessage *msg = queue? dequeueItem(queue): NULL;
 
-  asyncDiscardHandle(brl->acknowledgements.alarm);
-  brl->acknowledgements.alarm = NULL;
-
-  if ((brl->acknowledgements.missing.count += 1) < brl->acknowledgements.missing.limit) {
-    logMessage(LOG_WARNING, "missing braille message acknowledgement");
-    writeNextBrailleMessage(brl);
+  if (msg) {
+    logMessage(LOG_CATEGORY(OUTPUT_PACKETS), "acknowledged #%u", msg->sequence);
+    deallocateBrailleMessage(msg);
   } else {
-    logMessage(LOG_WARNING, "too many missing braille message acknowledgements");
-    brl->hasFailed = 1;
+    logMessage(LOG_CATEGORY(OUTPUT_PACKETS), "acknowledged");
   }
-}
 
-static void
-setBrailleMessageAlarm (BrailleDisplay *brl) {
-  if (brl->acknowledgements.alarm) {
-    asyncResetAlarmIn(brl->acknowledgements.alarm, brl->acknowledgements.missing.timeout);
-  } else {
-    asyncNewRelativeAlarm(&brl->acknowledgements.alarm, brl->acknowledgements.missing.timeout,
-                          handleBrailleMessageTimeout, brl);
-  }
+  brl->acknowledgements.missing.count = 0;
+  return writeNextBrailleMessages(brl);
 }
 
 static int
@@ -358,11 +727,43 @@ findOldBrailleMessage (const void *item, void *data) {
   return old->type == new->type;
 }
 
-static void
-deallocateBrailleMessageItem (void *item, void *data) {
-  BrailleMessage *msg = item;
+ASYNC_ALARM_CALLBACK(handleBrailleMessageTimeout) {
+  BrailleDisplay *brl = parameters->data;
 
-  deallocateBrailleMessage(msg);
+  asyncDiscardHandle(brl->acknowledgements.alarm);
+  brl->acknowledgements.alarm = NULL;
+
+  BrailleMessage *msg = dequeueItem(brl->acknowledgements.unacknowledged);
+  if (!msg) return;
+
+  if ((brl->acknowledgements.missing.count += 1) < brl->acknowledgements.missing.limit) {
+    logMessage(LOG_WARNING, "missing braille message acknowledgement: #%u", msg->sequence);
+
+    /* Within a window, typed messages carry state that a later one may not
+     * replace, so resend them unless a newer one of the same type is already
+     * waiting or in flight. Otherwise they're dropped, as they always were.
+     */
+    Queue *queue = NULL;
+
+    if ((brl->acknowledgements.window > 1) && msg->type) {
+      if (!findElement(brl->acknowledgements.unacknowledged, findOldBrailleMessage, msg)) {
+        queue = getBrailleMessageQueue(&brl->acknowledgements.messages);
+      }
+    }
+
+    if (queue && !findElement(queue, findOldBrailleMessage, msg) && prequeueItem(queue, msg)) {
+      logBrailleMessage(msg, "requeued");
+    } else {
+      logBrailleMessage(msg, "abandoned");
+      deallocateBrailleMessage(msg);
+    }
+
+    writeNextBrailleMessages(brl);
+  } else {
+    logMessage(LOG_WARNING, "too many missing braille message acknowledgements");
+    deallocateBrailleMessage(msg);
+    brl->hasFailed = 1;
+  }
 }
 
 int
@@ -371,46 +772,51 @@ writeBrailleMessage (
   unsigned int type,
   const void *packet, size_t size
 ) {
-  if (brl->acknowledgements.alarm) {
-    BrailleMessage *msg;
+  BrailleMessage *msg;
 
-    if (!brl->acknowledgements.messages) {
-      if (!(brl->acknowledgements.messages = newQueue(deallocateBrailleMessageItem, NULL))) {
-        return 0;
-      }
+  if (!(msg = malloc(sizeof(*msg) + size))) {
+    logMallocError();
+    return 0;
+  }
+
+  memset(msg, 0, sizeof(*msg));
+  msg->endpoint = endpoint;
+  msg->type = type;
+  msg->sequence = ++brl->acknowledgements.sequence;
+  msg->size = size;
+  memcpy(msg->packet, packet, size);
+
+  {
+    Queue *queue = brl->acknowledgements.messages;
+
+    if ((!queue || isEmptyQueue(queue)) &&
+        (getUnacknowledgedBrailleMessageCount(brl) < brl->acknowledgements.window)) {
+      if (!sendBrailleMessage(brl, msg)) return 0;
+      setBrailleMessageAlarm(brl);
+      return 1;
     }
+  }
 
-    if ((msg = malloc(sizeof(*msg) + size))) {
-      memset(msg, 0, sizeof(*msg));
-      msg->endpoint = endpoint;
-      msg->type = type;
-      msg->size = size;
-      memcpy(msg->packet, packet, size);
+  {
+    Queue *queue = getBrailleMessageQueue(&brl->acknowledgements.messages);
 
-      {
-        Element *element = findElement(brl->acknowledgements.messages, findOldBrailleMessage, msg);
+    if (queue) {
+      Element *element = findElement(queue, findOldBrailleMessage, msg);
 
-        if (element) {
-          logBrailleMessage(getElementItem(element), "unqueued");
-          deleteElement(element);
-        }
+      if (element) {
+        logBrailleMessage(getElementItem(element), "unqueued");
+        deleteElement(element);
       }
 
-      if (enqueueItem(brl->acknowledgements.messages, msg)) {
+      if (enqueueItem(queue, msg)) {
         logBrailleMessage(msg, "enqueued");
         return 1;
       }
-
-      logBrailleMessage(msg, "discarded");
-      free(msg);
-    } else {
-      logMallocError();
     }
-  } else if (writeBraillePacket(brl, endpoint, packet, size)) {
-    setBrailleMessageAlarm(brl);
-    return 1;
   }
 
+  logBrailleMessage(msg, "discarded");
+  deallocateBrailleMessage(msg);
   return 0;
 }
 
@@ -422,6 +828,11 @@ endBrailleMessages (BrailleDisplay *brl) {
     destroyQueue(brl->acknowledgements.messages);
     brl->acknowledgements.messages = NULL;
   }
+
+  if (brl->acknowledgements.unacknowledged) {
+    destroyQueue(brl->acknowledgements.unacknowledged);
+    brl->acknowledgements.unacknowledged = NULL;
+  }
 }
 
 int
@@ -459,10 +870,14 @@ probeBrailleDisplay (
 
   if (!endpoint) endpoint = brl->gioEndpoint;
 
-  while (writeRequest(brl)) {
+  while (1) {
+    TimeValue started;
+    getMonotonicTime(&started);
+
+    if (!writeRequest(brl)) break;
     drainBrailleOutput(brl, 0);
 
-    while (gioAwaitInput(endpoint, inputTimeout)) {
+    while (awaitEndpointInput(brl, endpoint, inputTimeout)) {
       size_t size = readPacket(brl, responsePacket, responseSize);
       if (!size) break;
 
@@ -470,8 +885,15 @@ probeBrailleDisplay (
         BrailleResponseResult result = handleResponse(brl, responsePacket, size);
 
         switch (result) {
-          case BRL_RSP_DONE:
+          case BRL_RSP_DONE: {
+            TimeValue now;
+            getMonotonicTime(&now);
+
+            logMessage(LOG_CATEGORY(BRAILLE_DRIVER),
+                       "probe round trip: %ldms",
+                       millisecondsBetween(&started, &now));
             return 1;
+          }
 
           case BRL_RSP_UNEXPECTED:
             logUnexpectedPacket(responsePacket, size);
@@ -653,6 +1075,7 @@ enqueueKeyEvent (
   BrailleDisplay *brl,
   KeyGroup group, KeyNumber number, int press
 ) {
+  markBrailleLatencyStage(BLS_KEY_EVENT);
   report(REPORT_BRAILLE_KEY_EVENT, NULL);
   if (api.handleKeyEvent(group, number, press)) return 1;
 
@@ -0,0 +1,188 @@
+/*
+ * BRLTTY - A background process providing access to the console screen (when in
+ *          text mode) for a blind person using a refreshable braille display.
+ *
+ * Copyright (C) 1995-2026 by The BRLTTY Developers.
+ *
+ * BRLTTY comes with ABSOLUTELY NO WARRANTY.
+ *
+ * This is free software, placed under the terms of the
+ * GNU Lesser General Public License, as published by the Free Software
+ * Foundation; either version 2.1 of the License, or (at your option) any
+ * later version. Please see the file LICENSE-LGPL for details.
+ *
+ * Web Page: http://brltty.app/
+ *
+ * This software is maintained by Dave Mielke <dave@mielke.cc>.
+ */
+
+
+#include "prologue.h"
+
+#include "log.h"
+#include "brl_latency.h"
+#include "histogram.h"
+#include "strfmt.h"
+#include "timing.h"
+
+#define BRAILLE_LATENCY_SUMMARY_INTERVAL (5 * SECS_PER_MIN * MSECS_PER_SEC)
+
+typedef enum {
+  BLI_TRANSLATE,
+  BLI_QUEUE,
+  BLI_EXECUTE,
+  BLI_OUTPUT,
+  BLI_TOTAL,
+  BLI_COUNT /* must be last */
+} BrailleLatencyInterval;
+
+typedef struct {
+  const char *name;
+  BrailleLatencyStage from;
+  BrailleLatencyStage to;
+} BrailleLatencyIntervalEntry;
+
+static const BrailleLatencyIntervalEntry brailleLatencyIntervalTable[BLI_COUNT] = {
+  [BLI_TRANSLATE] = {
+    .name = "translate",
+    .from = BLS_KEY_EVENT,
+    .to = BLS_COMMAND_ENQUEUED
+  },
+
+  [BLI_QUEUE] = {
+    .name = "queue",
+    .from = BLS_COMMAND_ENQUEUED,
+    .to = BLS_COMMAND_STARTED
+  },
+
+  [BLI_EXECUTE] = {
+    .name = "execute",
+    .from = BLS_COMMAND_STARTED,
+    .to = BLS_COMMAND_FINISHED
+  },
+
+  [BLI_OUTPUT] = {
+    .name = "output",
+    .from = BLS_COMMAND_FINISHED,
+    .to = BLS_WINDOW_WRITTEN
+  },
+
+  [BLI_TOTAL] = {
+    .name = "total",
+    .from = BLS_KEY_EVENT,
+    .to = BLS_WINDOW_WRITTEN
+  },
+};
+
+static struct {
+  unsigned char active:1;
+  BrailleLatencyStage stage;
+  TimeValue times[BLS_WINDOW_WRITTEN + 1];
+
+  Histogram histograms[BLI_COUNT];
+  unsigned long int noOutput;
+
+  unsigned char summaryStarted:1;
+  TimeValue summaryTime;
+} bls;
+
+static uint32_t
+getMicroseconds (const TimeValue *from, const TimeValue *to) {
+  int64_t microseconds = microsecondsBetween(from, to);
+
+  if (microseconds < 0) return 0;
+  if (microseconds > UINT32_MAX) return UINT32_MAX;
+  return microseconds;
+}
+
+static void
+addBrailleLatencyIntervals (void) {
+  for (unsigned int interval=0; interval<BLI_COUNT; interval+=1) {
+    const BrailleLatencyIntervalEntry *bli = &brailleLatencyIntervalTable[interval];
+
+    addHistogramValue(
+      &bls.histograms[interval],
+      getMicroseconds(&bls.times[bli->from], &bls.times[bli->to])
+    );
+  }
+}
+
+void
+recordBrailleLatencyStage (BrailleLatencyStage stage) {
+  if (stage == BLS_KEY_EVENT) {
+    if (bls.active) {
+      switch (bls.stage) {
+        case BLS_COMMAND_ENQUEUED:
+        case BLS_COMMAND_STARTED:
+          return;
+
+        case BLS_COMMAND_FINISHED:
+          bls.noOutput += 1;
+          break;
+
+        default:
+          break;
+      }
+    }
+
+    bls.active = 1;
+  } else if (!bls.active || (stage != (bls.stage + 1))) {
+    return;
+  }
+
+  TimeValue *now = &bls.times[stage];
+  getMonotonicTime(now);
+  bls.stage = stage;
+
+  if (stage == BLS_WINDOW_WRITTEN) {
+    bls.active = 0;
+    addBrailleLatencyIntervals();
+
+    if (!bls.summaryStarted) {
+      bls.summaryTime = *now;
+      bls.summaryStarted = 1;
+    } else if (millisecondsBetween(&bls.summaryTime, now) >= BRAILLE_LATENCY_SUMMARY_INTERVAL) {
+      logBrailleLatencyStatistics();
+      resetBrailleLatencyStatistics();
+    }
+  }
+}
+
+size_t
+formatBrailleLatencyStatistics (char *buffer, size_t size) {
+  size_t length;
+
+  STR_BEGIN(buffer, size);
+  STR_PRINTF("braille latency (microseconds):");
+
+  for (unsigned int interval=0; interval<BLI_COUNT; interval+=1) {
+    STR_PRINTF(" %s[", brailleLatencyIntervalTable[interval].name);
+    STR_FORMAT(formatHistogram, &bls.histograms[interval]);
+    STR_PRINTF("]");
+  }
+
+  STR_PRINTF(" no-output=%lu", bls.noOutput);
+
+  length = STR_LENGTH;
+  STR_END;
+
+  return length;
+}
+
+void
+logBrailleLatencyStatistics (void) {
+  char statistics[0X400];
+  formatBrailleLatencyStatistics(statistics, sizeof(statistics));
+  logMessage(LOG_CATEGORY(PERFORMANCE), "%s", statistics);
+}
+
+void
+resetBrailleLatencyStatistics (void) {
+  for (unsigned int interval=0; interval<BLI_COUNT; interval+=1) {
+    resetHistogram(&bls.histograms[interval]);
+  }
+
+  /* the next summary covers what's measured from now on */
+  bls.noOutput = 0;
+  bls.summaryStarted = 0;
+}
@@ -0,0 +1,52 @@
+/*
+ * BRLTTY - A background process providing access to the console screen (when in
+ *          text mode) for a blind person using a refreshable braille display.
+ *
+ * Copyright (C) 1995-2026 by The BRLTTY Developers.
+ *
+ * BRLTTY comes with ABSOLUTELY NO WARRANTY.
+ *
+ * This is free software, placed under the terms of the
+ * GNU Lesser General Public License, as published by the Free Software
+ * Foundation; either version 2.1 of the License, or (at your option) any
+ * later version. Please see the file LICENSE-LGPL for details.
+ *
+ * Web Page: http://brltty.app/
+ *
+ * This software is maintained by Dave Mielke <dave@mielke.cc>.
+ */
+
+
+#ifndef BRLTTY_INCLUDED_BRL_LATENCY
+#define BRLTTY_INCLUDED_BRL_LATENCY
+
+#include "log.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+typedef enum {
+  BLS_KEY_EVENT,
+  BLS_COMMAND_ENQUEUED,
+  BLS_COMMAND_STARTED,
+  BLS_COMMAND_FINISHED,
+  BLS_WINDOW_WRITTEN,
+} BrailleLatencyStage;
+
+extern void recordBrailleLatencyStage (BrailleLatencyStage stage);
+
+static inline void
+markBrailleLatencyStage (BrailleLatencyStage stage) {
+  if (LOG_CATEGORY_FLAG(PERFORMANCE)) recordBrailleLatencyStage(stage);
+}
+
+extern size_t formatBrailleLatencyStatistics (char *buffer, size_t size);
+extern void logBrailleLatencyStatistics (void);
+extern void resetBrailleLatencyStatistics (void);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* BRLTTY_INCLUDED_BRL_LATENCY */
@@ -110,6 +110,90 @@ cellsHaveChanged (
   return 1;
 }
 
+static int
+mergeNarrowestCellRangeGap (CellRange *ranges, unsigned int *count, unsigned int from) {
+  unsigned int narrowest = *count;
+  unsigned int gap = from - ranges[narrowest-1].to;
+
+  for (unsigned int index=1; index<*count; index+=1) {
+    unsigned int width = ranges[index].from - ranges[index-1].to;
+
+    if (width < gap) {
+      narrowest = index;
+      gap = width;
+    }
+  }
+
+  if (narrowest == *count) return 0;
+  ranges[narrowest-1].to = ranges[narrowest].to;
+  *count -= 1;
+
+  memmove(&ranges[narrowest], &ranges[narrowest+1],
+          (*count - narrowest) * sizeof(ranges[0]));
+
+  return 1;
+}
+
+unsigned int
+getChangedCellRanges (
+  unsigned char *cells, const unsigned char *new, unsigned int count,
+  CellRange *ranges, unsigned int size, unsigned int overhead,
+  unsigned char *force
+) {
+  unsigned int rangeCount = 0;
+
+  if (!size) return 0;
+
+  if (force && *force) {
+    *force = 0;
+
+    ranges[rangeCount++] = (CellRange){
+      .from = 0,
+      .to = count
+    };
+  } else {
+    unsigned int index = 0;
+
+    while (index < count) {
+      if (cells[index] == new[index]) {
+        index += 1;
+        continue;
+      }
+
+      unsigned int from = index;
+      while ((++index < count) && (cells[index] != new[index]));
+
+      /* resending a short unchanged gap is cheaper than starting another packet */
+      if (rangeCount && ((from - ranges[rangeCount-1].to) <= overhead)) {
+        ranges[rangeCount-1].to = index;
+        continue;
+      }
+
+      if (rangeCount == size) {
+        if (!mergeNarrowestCellRangeGap(ranges, &rangeCount, from)) {
+          ranges[rangeCount-1].to = index;
+          continue;
+        }
+      }
+
+      ranges[rangeCount++] = (CellRange){
+        .from = from,
+        .to = index
+      };
+    }
+
+    if (!rangeCount) return 0;
+  }
+
+  {
+    unsigned int from = ranges[0].from;
+    unsigned int to = ranges[rangeCount-1].to;
+    memcpy(cells+from, new+from, to-from);
+  }
+
+  return rangeCount;
+}
+
 int
 textHasChanged (
   wchar_t *text, const wchar_t *new, unsigned int count,
@@ -839,6 +839,13 @@ static const brlapi_param_properties_t brlapi_param_properties[BRLAPI_PARAM_COUN
     .canWatch = 1,
     .hasSubparam = 1,
   },
+
+//Diagnostic Parameters
+  [BRLAPI_PARAM_PERFORMANCE_STATISTICS] = {
+    .type = BRLAPI_PARAM_TYPE_STRING,
+    .canRead = 1,
+    .hasSubparam = 1,
+  },
 };
 
 const brlapi_param_properties_t *brlapi_getParameterProperties(brlapi_param_t parameter) {
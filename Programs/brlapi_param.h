@@ -102,9 +102,14 @@ typedef enum {
 //Driver-speciic Parameters
   BRLAPI_PARAM_DRIVER_PROPERTY_VALUE = 32,      /**< Value of a driver-specific property: uint32_t */
 
+//Diagnostic Parameters
+  BRLAPI_PARAM_PERFORMANCE_STATISTICS = 33,	/**< Performance statistics
+						  * (for the group specified via the subparam argument):
+						  * string */
+
  /* TODO: help strings */
 
-  BRLAPI_PARAM_COUNT = 33 /** Number of parameters */
+  BRLAPI_PARAM_COUNT = 34 /** Number of parameters */
 } brlapi_param_t;
 
 /* brlapi_param_subparam_t */
@@ -262,6 +267,19 @@ typedef char *brlapi_param_messageLocale_t;
 /** Type to be used for BRLAPI_PARAM_DRIVER_PROPERTY_VALUE */
 typedef uint64_t brlapi_param_driverPropertyValue_t;
 
+/* brlapi_param_performanceStatistics_t */
+/** Type to be used for BRLAPI_PARAM_PERFORMANCE_STATISTICS */
+typedef char *brlapi_param_performanceStatistics_t;
+
+/* brlapi_param_statisticsGroup_t */
+/** Statistics groups (subparam values) for BRLAPI_PARAM_PERFORMANCE_STATISTICS */
+typedef enum {
+  BRLAPI_PARAM_STATISTICS_BRAILLE_LATENCY = 0,	/**< Braille key event to braille window output latencies */
+  BRLAPI_PARAM_STATISTICS_UPDATE_PROFILE = 1,	/**< Per-phase timings of the screen/braille update cycle */
+  BRLAPI_PARAM_STATISTICS_USB_INPUT = 2,	/**< USB input request completion to dispatch latencies */
+  BRLAPI_PARAM_STATISTICS_SPEECH_LATENCY = 3,	/**< Speech request to first audio and to completion latencies */
+} brlapi_param_statisticsGroup_t;
+
 /** Deprecated in BRLTTY-6.2 - use BRLAPI_PARAM_BOUND_COMMAND_KEYCODES */
 #define BRLAPI_PARAM_BOUND_COMMAND_CODES BRLAPI_PARAM_BOUND_COMMAND_KEYCODES
 /** Deprecated in BRLTTY-6.2 - use brlapi_param_commandKeycode_t */
@@ -96,6 +96,9 @@ Samuel Thibault <samuel.thibault@ens-lyon.org>"
 #include "blink.h"
 #include "options.h"
 #include "core.h"
+#include "brl_latency.h"
+#include "update_profile.h"
+#include "io_usb.h"
 
 #ifdef __MINGW32__
 #define LogSocketError(msg) logWindowsSocketError(msg)
@@ -2166,6 +2169,60 @@ PARAM_WRITER(driverPropertyValue)
   return NULL;
 }
 
+typedef size_t StatisticsFormatter (char *buffer, size_t size);
+
+typedef struct {
+  StatisticsFormatter *format;
+  char *buffer;
+  size_t size;
+} CoreTaskData_formatStatistics;
+
+CORE_TASK_CALLBACK(apiCoreTask_formatStatistics) {
+  CoreTaskData_formatStatistics *fs = data;
+  fs->format(fs->buffer, fs->size);
+}
+
+/* BRLAPI_PARAM_PERFORMANCE_STATISTICS */
+PARAM_READER(performanceStatistics)
+{
+  StatisticsFormatter *format;
+
+  switch (subparam) {
+    case BRLAPI_PARAM_STATISTICS_BRAILLE_LATENCY:
+      format = formatBrailleLatencyStatistics;
+      break;
+
+    case BRLAPI_PARAM_STATISTICS_UPDATE_PROFILE:
+      format = formatUpdateProfile;
+      break;
+
+    case BRLAPI_PARAM_STATISTICS_USB_INPUT:
+      format = usbFormatInputStatistics;
+      break;
+
+#ifdef ENABLE_SPEECH_SUPPORT
+    case BRLAPI_PARAM_STATISTICS_SPEECH_LATENCY:
+      format = formatSpeechLatencyStatistics;
+      break;
+#endif /* ENABLE_SPEECH_SUPPORT */
+
+    default:
+      return "unknown statistics group";
+  }
+
+  char buffer[0X800];
+
+  CoreTaskData_formatStatistics fs = {
+    .format = format,
+    .buffer = buffer,
+    .size = sizeof(buffer)
+  };
+
+  runCoreTask(apiCoreTask_formatStatistics, &fs, 1);
+  param_readString(buffer, data, size);
+  return NULL;
+}
+
 typedef struct {
   unsigned local:1;
   unsigned global:1;
@@ -2368,6 +2425,12 @@ static const ParamDispatch paramDispatch[BRLAPI_PARAM_COUNT] = {
     .read = param_driverPropertyValue_read,
     .write = param_driverPropertyValue_write,
   },
+
+//Diagnostic Parameters
+  [BRLAPI_PARAM_PERFORMANCE_STATISTICS] = {
+    .global = 1,
+    .read = param_performanceStatistics_read,
+  },
 };
 
 static inline const ParamDispatch *param_getDispatch(brlapi_param_t parameter)
@@ -0,0 +1,1096 @@
+/*
+ * BRLTTY - A background process providing access to the console screen (when in
+ *          text mode) for a blind person using a refreshable braille display.
+ *
+ * Copyright (C) 1995-2026 by The BRLTTY Developers.
+ *
+ * BRLTTY comes with ABSOLUTELY NO WARRANTY.
+ *
+ * This is free software, placed under the terms of the
+ * GNU Lesser General Public License, as published by the Free Software
+ * Foundation; either version 2.1 of the License, or (at your option) any
+ * later version. Please see the file LICENSE-LGPL for details.
+ *
+ * Web Page: http://brltty.app/
+ *
+ * This software is maintained by Dave Mielke <dave@mielke.cc>.
+ */
+
+
+#include "prologue.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <termios.h>
+#include <sys/wait.h>
+
+#include "log.h"
+#include "cmdline.h"
+#include "parse.h"
+#include "timing.h"
+#include "histogram.h"
+#include "async_wait.h"
+#include "ascii.h"
+
+static char *opt_deviceModel;
+static char *opt_keyRate;
+static char *opt_duration;
+static char *opt_acknowledgementDelay;
+static char *opt_scriptFile;
+
+BEGIN_COMMAND_LINE_OPTIONS(programOptions)
+  { .word = "model",
+    .letter = 'm',
+    .argument = strtext("protocol"),
+    .setting.string = &opt_deviceModel,
+    .internal.setting = "baum",
+    .description = strtext("The device protocol to simulate (baum, handytech, or eurobraille).")
+  },
+
+  { .word = "key-rate",
+    .letter = 'k',
+    .argument = strtext("count"),
+    .setting.string = &opt_keyRate,
+    .internal.setting = "5",
+    .description = strtext("The number of key presses to generate per second.")
+  },
+
+  { .word = "duration",
+    .letter = 't',
+    .argument = strtext("seconds"),
+    .setting.string = &opt_duration,
+    .internal.setting = "10",
+    .description = strtext("How long to run the simulation.")
+  },
+
+  { .word = "acknowledgement-delay",
+    .letter = 'a',
+    .argument = strtext("milliseconds"),
+    .setting.string = &opt_acknowledgementDelay,
+    .internal.setting = "0",
+    .description = strtext("How long the device takes to acknowledge a braille write.")
+  },
+
+  { .word = "script",
+    .letter = 's',
+    .argument = strtext("file"),
+    .setting.string = &opt_scriptFile,
+    .description = strtext("A file of key events to play repeatedly instead of pressing a key at a fixed rate.")
+  },
+END_COMMAND_LINE_OPTIONS(programOptions)
+
+BEGIN_COMMAND_LINE_PARAMETERS(programParameters)
+END_COMMAND_LINE_PARAMETERS(programParameters)
+
+BEGIN_COMMAND_LINE_NOTES(programNotes)
+  "The command is run with %p in its arguments replaced by the path to the pty slave.",
+  "For example: brlsim -m handytech brltty -n -e -b ht -d serial:%p -x no",
+  "If no command is specified then the path is written to standard output.",
+  "",
+  "Each line of a script is one of:",
+  "  key            press and release the keys bound to INFO",
+  "  route cell     press and release the routing key over a cell (1-40)",
+  "  wait msecs     wait before going on to the next line",
+  "Blank lines and lines beginning with # are ignored.",
+  "",
+  "Latency is measured from sending a key press to brltty dispatching the command it maps to,",
+  "and to receiving the next braille write.",
+  "Dispatches are found in the command's standard error, so run brltty with -e -l debug.",
+END_COMMAND_LINE_NOTES
+
+BEGIN_COMMAND_LINE_DESCRIPTOR(programDescriptor)
+  .name = "brlsim",
+  .purpose = strtext("Simulate a braille device on a pty in order to measure a braille driver."),
+
+  .options = &programOptions,
+  .parameters = &programParameters,
+  .notes = COMMAND_LINE_NOTES(programNotes),
+
+  .extraParameters = {
+    .name = "command",
+    .description = "the command, followed by its arguments, to run",
+  },
+END_COMMAND_LINE_DESCRIPTOR
+
+#define BRLSIM_CELL_COUNT 40
+#define BRLSIM_IDLE_TIMEOUT 5
+#define BRLSIM_LATENCY_LIMIT 1000
+#define BRLSIM_ACKNOWLEDGEMENT_LIMIT 0X20
+#define BRLSIM_COMMAND_LIMIT 0X20
+#define BRLSIM_TERMINATE_TIMEOUT 2000
+#define BRLSIM_WAIT_LIMIT 60000
+
+typedef struct {
+  const char *name;
+  unsigned char completeWhenIdle:1;
+
+  int (*getLength) (const unsigned char *bytes, size_t count, size_t *length);
+  int (*handlePacket) (const unsigned char *packet, size_t size);
+  void (*writeKey) (int press);
+  void (*writeRoutingKey) (unsigned int cell);
+  void (*writeAcknowledgement) (void);
+} DeviceModel;
+
+static int masterDescriptor;
+static int logDescriptor = -1;
+static const DeviceModel *deviceModel;
+static int acknowledgementDelay;
+
+static struct {
+  unsigned long int inputPackets;
+  unsigned long int inputBytes;
+  unsigned long int outputPackets;
+  unsigned long int outputBytes;
+
+  unsigned long int brailleWrites;
+  unsigned long int commands;
+  unsigned long int keyPresses;
+  unsigned long int routingKeys;
+  unsigned long int unansweredKeys;
+
+  Histogram commandLatency;
+  Histogram writeLatency;
+} statistics;
+
+static struct {
+  unsigned char isPending:1;
+  TimeValue time;
+} keyPress;
+
+/* Commands are matched to key presses in order, so a command that is
+ * dispatched late is charged to the press that caused it.
+ */
+static struct {
+  TimeValue times[BRLSIM_COMMAND_LIMIT];
+  unsigned int first;
+  unsigned int count;
+} commandsAwaited;
+
+typedef enum {
+  STEP_KEY,
+  STEP_ROUTE,
+  STEP_WAIT
+} ScriptStepType;
+
+typedef struct {
+  ScriptStepType type;
+  int value;
+} ScriptStep;
+
+static struct {
+  ScriptStep *steps;
+  unsigned int size;
+  unsigned int count;
+  unsigned int next;
+} script;
+
+static struct {
+  TimeValue times[BRLSIM_ACKNOWLEDGEMENT_LIMIT];
+  unsigned int first;
+  unsigned int count;
+} acknowledgements;
+
+static void
+writeDevicePacket (const unsigned char *packet, size_t size) {
+  const unsigned char *byte = packet;
+
+  while (size > 0) {
+    ssize_t count = write(masterDescriptor, byte, size);
+
+    if (count == -1) {
+      if (errno == EINTR) continue;
+      if (errno == EAGAIN) continue;
+      logSystemError("pty write");
+      return;
+    }
+
+    byte += count;
+    size -= count;
+  }
+
+  statistics.outputPackets += 1;
+  statistics.outputBytes += byte - packet;
+}
+
+static const TimeValue *
+getAwaitedCommandTime (void) {
+  if (!commandsAwaited.count) return NULL;
+  return &commandsAwaited.times[commandsAwaited.first];
+}
+
+static void
+removeAwaitedCommand (void) {
+  commandsAwaited.first = (commandsAwaited.first + 1) % ARRAY_COUNT(commandsAwaited.times);
+  commandsAwaited.count -= 1;
+}
+
+static void
+expireAwaitedCommands (const TimeValue *now) {
+  const TimeValue *time;
+
+  while ((time = getAwaitedCommandTime())) {
+    if (millisecondsBetween(time, now) < BRLSIM_LATENCY_LIMIT) break;
+    removeAwaitedCommand();
+    statistics.unansweredKeys += 1;
+  }
+}
+
+static void
+beginKeyPress (void) {
+  getMonotonicTime(&keyPress.time);
+  keyPress.isPending = 1;
+  statistics.keyPresses += 1;
+
+  if (commandsAwaited.count == ARRAY_COUNT(commandsAwaited.times)) {
+    removeAwaitedCommand();
+    statistics.unansweredKeys += 1;
+  }
+
+  {
+    unsigned int index = (commandsAwaited.first + commandsAwaited.count++) % ARRAY_COUNT(commandsAwaited.times);
+    commandsAwaited.times[index] = keyPress.time;
+  }
+}
+
+static void
+writeDeviceKey (int press) {
+  if (press) beginKeyPress();
+  deviceModel->writeKey(press);
+}
+
+static void
+writeDeviceRoutingKey (unsigned int cell) {
+  beginKeyPress();
+  statistics.routingKeys += 1;
+  deviceModel->writeRoutingKey(cell);
+}
+
+static void
+addKeyLatency (Histogram *histogram, const TimeValue *time) {
+  TimeValue now;
+  getMonotonicTime(&now);
+
+  int64_t microseconds = microsecondsBetween(time, &now);
+  addHistogramValue(histogram, MIN(microseconds, UINT32_MAX));
+}
+
+static void
+handleCommandDispatch (void) {
+  const TimeValue *time = getAwaitedCommandTime();
+  statistics.commands += 1;
+
+  if (time) {
+    addKeyLatency(&statistics.commandLatency, time);
+    removeAwaitedCommand();
+  }
+}
+
+static void
+handleBrailleWrite (void) {
+  statistics.brailleWrites += 1;
+
+  if (keyPress.isPending) {
+    keyPress.isPending = 0;
+    addKeyLatency(&statistics.writeLatency, &keyPress.time);
+  }
+
+  if (deviceModel->writeAcknowledgement) {
+    if (!acknowledgementDelay) {
+      deviceModel->writeAcknowledgement();
+    } else if (acknowledgements.count < ARRAY_COUNT(acknowledgements.times)) {
+      unsigned int index = (acknowledgements.first + acknowledgements.count++) % ARRAY_COUNT(acknowledgements.times);
+      TimeValue *time = &acknowledgements.times[index];
+
+      getMonotonicTime(time);
+      adjustTimeValue(time, acknowledgementDelay);
+    }
+  }
+}
+
+static void
+writeDueAcknowledgements (const TimeValue *now) {
+  while (acknowledgements.count > 0) {
+    const TimeValue *time = &acknowledgements.times[acknowledgements.first];
+    if (compareTimeValues(time, now) > 0) break;
+
+    deviceModel->writeAcknowledgement();
+    acknowledgements.first = (acknowledgements.first + 1) % ARRAY_COUNT(acknowledgements.times);
+    acknowledgements.count -= 1;
+  }
+}
+
+/* Baum (escape protocol): each packet begins with an unescaped ESC. */
+
+#define BAUM_DISPLAY_DATA 0X01
+#define BAUM_ROUTING_KEYS 0X22
+#define BAUM_DISPLAY_KEYS 0X24
+
+static void
+writeBaumPacket (const unsigned char *packet, size_t size) {
+  unsigned char buffer[1 + (size * 2)];
+  unsigned char *byte = buffer;
+
+  *byte++ = ASCII_ESC;
+
+  for (size_t index=0; index<size; index+=1) {
+    if ((*byte++ = packet[index]) == ASCII_ESC) *byte++ = ASCII_ESC;
+  }
+
+  writeDevicePacket(buffer, byte-buffer);
+}
+
+static int
+getBaumLength (const unsigned char *bytes, size_t count, size_t *length) {
+  if (bytes[0] != ASCII_ESC) {
+    *length = 1;
+    return 1;
+  }
+
+  size_t index = 1;
+
+  while (index < count) {
+    if (bytes[index] == ASCII_ESC) {
+      if (++index == count) return 0;
+      if (bytes[index] != ASCII_ESC) {
+        *length = index - 1;
+        return 1;
+      }
+    }
+
+    index += 1;
+  }
+
+  return 0;
+}
+
+static int
+handleBaumPacket (const unsigned char *packet, size_t size) {
+  unsigned char bytes[size];
+  size_t count = 0;
+
+  if (packet[0] != ASCII_ESC) return 0;
+
+  for (size_t index=1; index<size; index+=1) {
+    unsigned char byte = packet[index];
+    if ((byte == ASCII_ESC) && (index+1 < size)) index += 1;
+    bytes[count++] = byte;
+  }
+
+  if (!count) return 0;
+  if (bytes[0] != BAUM_DISPLAY_DATA) return 0;
+
+  if ((count == 2) && !bytes[1]) {
+    const unsigned char response[] = {BAUM_DISPLAY_DATA, BRLSIM_CELL_COUNT};
+    writeBaumPacket(response, sizeof(response));
+    return 0;
+  }
+
+  handleBrailleWrite();
+  return 1;
+}
+
+static void
+writeBaumKey (int press) {
+  /* Display2+Display5: INFO, which toggles the display */
+  const unsigned char packet[] = {BAUM_DISPLAY_KEYS, (press? 0X12: 0X00)};
+  writeBaumPacket(packet, sizeof(packet));
+}
+
+static void
+writeBaumRoutingKey (unsigned int cell) {
+  /* one bit per cell: the pressed key, and then none */
+  unsigned char packet[1 + ((BRLSIM_CELL_COUNT + 7) / 8)];
+
+  memset(packet, 0, sizeof(packet));
+  packet[0] = BAUM_ROUTING_KEYS;
+  packet[1 + (cell / 8)] |= 1 << (cell % 8);
+  writeBaumPacket(packet, sizeof(packet));
+
+  memset(&packet[1], 0, sizeof(packet)-1);
+  writeBaumPacket(packet, sizeof(packet));
+}
+
+static const DeviceModel baumModel = {
+  .name = "Baum",
+  .completeWhenIdle = 1,
+  .getLength = getBaumLength,
+  .handlePacket = handleBaumPacket,
+  .writeKey = writeBaumKey,
+  .writeRoutingKey = writeBaumRoutingKey
+};
+
+/* HandyTech: a Braille Wave (40 cells) which acknowledges each write. */
+
+#define HT_RESET 0XFF
+#define HT_OK 0XFE
+#define HT_ACK 0X7E
+#define HT_BRAILLE 0X01
+#define HT_EXTENDED 0X79
+#define HT_MODEL_BRAILLE_WAVE 0X05
+#define HT_KEY_ESCAPE 0X0C
+#define HT_KEY_SPACE 0X10
+#define HT_KEY_RETURN 0X14
+#define HT_KEY_ROUTING 0X20
+#define HT_KEY_RELEASE 0X80
+
+static int
+getHandyTechLength (const unsigned char *bytes, size_t count, size_t *length) {
+  switch (bytes[0]) {
+    case HT_BRAILLE:
+      *length = 1 + BRLSIM_CELL_COUNT;
+      return 1;
+
+    case HT_EXTENDED:
+      if (count < 3) return 0;
+      *length = bytes[2] + 4;
+      return 1;
+
+    default:
+      *length = 1;
+      return 1;
+  }
+}
+
+static int
+handleHandyTechPacket (const unsigned char *packet, size_t size) {
+  switch (packet[0]) {
+    case HT_RESET: {
+      const unsigned char response[] = {HT_OK, HT_MODEL_BRAILLE_WAVE};
+      writeDevicePacket(response, sizeof(response));
+      return 0;
+    }
+
+    case HT_BRAILLE:
+      handleBrailleWrite();
+      return 1;
+
+    default:
+      return 0;
+  }
+}
+
+static void
+writeHandyTechKey (int press) {
+  /* Escape+Space+Return: INFO, which toggles the display */
+  static const unsigned char keys[] = {HT_KEY_ESCAPE, HT_KEY_SPACE, HT_KEY_RETURN};
+  unsigned char release = press? 0: HT_KEY_RELEASE;
+
+  for (unsigned int index=0; index<ARRAY_COUNT(keys); index+=1) {
+    const unsigned char packet[] = {keys[index] | release};
+    writeDevicePacket(packet, sizeof(packet));
+  }
+}
+
+static void
+writeHandyTechRoutingKey (unsigned int cell) {
+  const unsigned char press[] = {HT_KEY_ROUTING + cell};
+  const unsigned char release[] = {(HT_KEY_ROUTING + cell) | HT_KEY_RELEASE};
+
+  writeDevicePacket(press, sizeof(press));
+  writeDevicePacket(release, sizeof(release));
+}
+
+static void
+writeHandyTechAcknowledgement (void) {
+  const unsigned char packet[] = {HT_ACK};
+  writeDevicePacket(packet, sizeof(packet));
+}
+
+static const DeviceModel handyTechModel = {
+  .name = "HandyTech",
+  .getLength = getHandyTechLength,
+  .handlePacket = handleHandyTechPacket,
+  .writeKey = writeHandyTechKey,
+  .writeRoutingKey = writeHandyTechRoutingKey,
+  .writeAcknowledgement = writeHandyTechAcknowledgement
+};
+
+/* EuroBraille (Esys/Iris protocol): an Iris 40. */
+
+#define EU_SYSTEM 'S'
+#define EU_SYSTEM_IDENTITY 'I'
+#define EU_SYSTEM_DISPLAY_LENGTH 'G'
+#define EU_SYSTEM_TYPE 'T'
+#define EU_BRAILLE 'B'
+#define EU_KEY 'K'
+#define EU_KEY_COMMAND 'C'
+#define EU_KEY_INTERACTIVE 'I'
+#define EU_INTERACTIVE_SINGLE_CLICK 0X01
+#define EU_MODEL_IRIS_40 0X02
+
+static void
+writeEuroBraillePacket (const unsigned char *data, size_t size) {
+  unsigned char packet[size + 4];
+  unsigned char *byte = packet;
+
+  *byte++ = ASCII_STX;
+  *byte++ = ((size + 2) >> 8) & 0XFF;
+  *byte++ = (size + 2) & 0XFF;
+  byte = mempcpy(byte, data, size);
+  *byte++ = ASCII_ETX;
+
+  writeDevicePacket(packet, byte-packet);
+}
+
+static int
+getEuroBrailleLength (const unsigned char *bytes, size_t count, size_t *length) {
+  if (bytes[0] != ASCII_STX) {
+    *length = 1;
+    return 1;
+  }
+
+  if (count < 3) return 0;
+  *length = ((bytes[1] << 8) | bytes[2]) + 2;
+  return 1;
+}
+
+static int
+handleEuroBraillePacket (const unsigned char *packet, size_t size) {
+  if (size < 6) return 0;
+
+  switch (packet[3]) {
+    case EU_SYSTEM:
+      if (packet[4] == EU_SYSTEM_IDENTITY) {
+        const unsigned char length[] = {EU_SYSTEM, EU_SYSTEM_DISPLAY_LENGTH, BRLSIM_CELL_COUNT};
+        const unsigned char type[] = {EU_SYSTEM, EU_SYSTEM_TYPE, EU_MODEL_IRIS_40};
+        const unsigned char end[] = {EU_SYSTEM, EU_SYSTEM_IDENTITY};
+
+        writeEuroBraillePacket(length, sizeof(length));
+        writeEuroBraillePacket(type, sizeof(type));
+        writeEuroBraillePacket(end, sizeof(end));
+      }
+
+      return 0;
+
+    case EU_BRAILLE:
+      handleBrailleWrite();
+      return 1;
+
+    default:
+      return 0;
+  }
+}
+
+static void
+writeEuroBrailleKey (int press) {
+  /* Iris command keys are reported once, as a combined press and release.
+   * L5: INFO, which toggles the display
+   */
+  if (press) {
+    const unsigned char packet[] = {EU_KEY, EU_KEY_COMMAND, 0X00, 0X10};
+    writeEuroBraillePacket(packet, sizeof(packet));
+  }
+}
+
+static void
+writeEuroBrailleRoutingKey (unsigned int cell) {
+  /* interactive keys are also reported as a single click, and are numbered from 1 */
+  const unsigned char packet[] = {EU_KEY, EU_KEY_INTERACTIVE, EU_INTERACTIVE_SINGLE_CLICK, cell+1};
+  writeEuroBraillePacket(packet, sizeof(packet));
+}
+
+static const DeviceModel euroBrailleModel = {
+  .name = "EuroBraille",
+  .getLength = getEuroBrailleLength,
+  .handlePacket = handleEuroBraillePacket,
+  .writeKey = writeEuroBrailleKey,
+  .writeRoutingKey = writeEuroBrailleRoutingKey
+};
+
+static struct {
+  unsigned char bytes[0X1000];
+  size_t count;
+} input;
+
+static void
+processInput (int idle) {
+  size_t offset = 0;
+
+  while (offset < input.count) {
+    const unsigned char *bytes = &input.bytes[offset];
+    size_t count = input.count - offset;
+    size_t length;
+
+    if (!deviceModel->getLength(bytes, count, &length)) {
+      if (!(idle && deviceModel->completeWhenIdle)) break;
+      length = count;
+    } else if (length > count) {
+      if (count < sizeof(input.bytes)) break;
+      length = count;
+    }
+
+    statistics.inputPackets += 1;
+    statistics.inputBytes += length;
+    deviceModel->handlePacket(bytes, length);
+    offset += length;
+  }
+
+  memmove(input.bytes, &input.bytes[offset], (input.count -= offset));
+}
+
+static int
+readInput (void) {
+  ssize_t count = read(masterDescriptor, &input.bytes[input.count], sizeof(input.bytes) - input.count);
+
+  if (count == -1) {
+    if (errno == EINTR) return 1;
+    if (errno == EAGAIN) return 1;
+    if (errno == EIO) return 1;
+    logSystemError("pty read");
+    return 0;
+  }
+
+  input.count += count;
+  processInput(0);
+  return 1;
+}
+
+static struct {
+  char text[0X400];
+  size_t length;
+} logLine;
+
+static int
+isCommandLogLine (const char *line) {
+  static const char marker[] = "command: ";
+
+  if (strncmp(line, marker, strlen(marker)) == 0) return 1;
+  return !!strstr(line, ": command: ");
+}
+
+static int
+readCommandLog (void) {
+  char buffer[0X200];
+  ssize_t count = read(logDescriptor, buffer, sizeof(buffer));
+
+  if (count == -1) {
+    if (errno == EINTR) return 1;
+    if (errno == EAGAIN) return 1;
+    logSystemError("log read");
+  }
+
+  if (count <= 0) {
+    close(logDescriptor);
+    logDescriptor = -1;
+    return 0;
+  }
+
+  for (const char *byte=buffer; byte<&buffer[count]; byte+=1) {
+    if (*byte == '\n') {
+      logLine.text[logLine.length] = 0;
+      if (isCommandLogLine(logLine.text)) handleCommandDispatch();
+      logLine.length = 0;
+    } else if (logLine.length < (sizeof(logLine.text) - 1)) {
+      logLine.text[logLine.length++] = *byte;
+    }
+  }
+
+  return 1;
+}
+
+static int
+openPty (char **path) {
+  if ((masterDescriptor = posix_openpt(O_RDWR | O_NOCTTY)) != -1) {
+    if ((grantpt(masterDescriptor) != -1) && (unlockpt(masterDescriptor) != -1)) {
+      const char *name = ptsname(masterDescriptor);
+
+      if (name) {
+        if ((*path = strdup(name))) return 1;
+        logMallocError();
+      } else {
+        logSystemError("ptsname");
+      }
+    } else {
+      logSystemError("pty unlock");
+    }
+
+    close(masterDescriptor);
+  } else {
+    logSystemError("posix_openpt");
+  }
+
+  return 0;
+}
+
+static char **
+makeCommand (char **arguments, int count, const char *path) {
+  char **command = calloc(count+1, sizeof(*command));
+
+  if (command) {
+    for (int index=0; index<count; index+=1) {
+      const char *argument = arguments[index];
+      const char *placeholder = strstr(argument, "%p");
+
+      if (placeholder) {
+        size_t prefix = placeholder - argument;
+        char buffer[strlen(argument) + strlen(path) + 1];
+
+        snprintf(buffer, sizeof(buffer), "%.*s%s%s", (int)prefix, argument, path, placeholder+2);
+        if (!(command[index] = strdup(buffer))) logMallocError();
+      } else {
+        command[index] = arguments[index];
+      }
+    }
+  } else {
+    logMallocError();
+  }
+
+  return command;
+}
+
+static pid_t
+startCommand (char **arguments, int count, const char *path) {
+  char **command = makeCommand(arguments, count, path);
+  if (!command) return -1;
+
+  /* the command's standard error is read for its command log */
+  int descriptors[2];
+
+  if (pipe(descriptors) == -1) {
+    logSystemError("pipe");
+    return -1;
+  }
+
+  pid_t child = fork();
+
+  if (child == 0) {
+    close(masterDescriptor);
+    close(descriptors[0]);
+
+    if (dup2(descriptors[1], STDERR_FILENO) == -1) _exit(PROG_EXIT_FATAL);
+    close(descriptors[1]);
+
+    execvp(command[0], command);
+    logSystemError("execvp");
+    _exit(PROG_EXIT_FATAL);
+  }
+
+  close(descriptors[1]);
+
+  if (child == -1) {
+    logSystemError("fork");
+    close(descriptors[0]);
+  } else {
+    logDescriptor = descriptors[0];
+    fcntl(logDescriptor, F_SETFL, fcntl(logDescriptor, F_GETFL) | O_NONBLOCK);
+  }
+
+  return child;
+}
+
+static void
+showStatistics (double seconds) {
+  printf("model: %s\n", deviceModel->name);
+  printf("duration: %.1f seconds\n", seconds);
+
+  printf("from driver: %lu packets (%.1f/s), %lu bytes (%.1f/s), %lu braille writes\n",
+         statistics.inputPackets, statistics.inputPackets/seconds,
+         statistics.inputBytes, statistics.inputBytes/seconds,
+         statistics.brailleWrites);
+
+  printf("to driver: %lu packets (%.1f/s), %lu bytes (%.1f/s), %lu key presses (%lu routing)\n",
+         statistics.outputPackets, statistics.outputPackets/seconds,
+         statistics.outputBytes, statistics.outputBytes/seconds,
+         statistics.keyPresses, statistics.routingKeys);
+
+  printf("commands dispatched: %lu\n", statistics.commands);
+
+  {
+    char latency[0X200];
+
+    formatHistogram(latency, sizeof(latency), &statistics.commandLatency);
+    printf("key to command dispatch (microseconds): %s\n", latency);
+
+    formatHistogram(latency, sizeof(latency), &statistics.writeLatency);
+    printf("key to braille write (microseconds): %s\n", latency);
+  }
+
+  printf("key presses without a command: %lu\n",
+         statistics.unansweredKeys + commandsAwaited.count);
+}
+
+static int
+getNumber (int *value, const char *string, const char *name, int minimum, int maximum) {
+  if (validateInteger(value, string, &minimum, &maximum)) return 1;
+  logMessage(LOG_ERR, "invalid %s: %s", name, string);
+  return 0;
+}
+
+static int
+addScriptStep (ScriptStepType type, int value) {
+  if (script.count == script.size) {
+    unsigned int size = script.size? script.size << 1: 0X10;
+    ScriptStep *steps = realloc(script.steps, ARRAY_SIZE(steps, size));
+
+    if (!steps) {
+      logMallocError();
+      return 0;
+    }
+
+    script.steps = steps;
+    script.size = size;
+  }
+
+  ScriptStep *step = &script.steps[script.count++];
+  step->type = type;
+  step->value = value;
+  return 1;
+}
+
+static int
+parseScriptLine (char *line, const char *file, unsigned int number) {
+  static const char delimiters[] = " \t\r\n";
+  char *last;
+
+  const char *operation = strtok_r(line, delimiters, &last);
+  if (!operation || (*operation == '#')) return 1;
+
+  const char *operand = strtok_r(NULL, delimiters, &last);
+  char name[0X40];
+
+  if (strcmp(operation, "key") == 0) {
+    if (!operand) return addScriptStep(STEP_KEY, 0);
+  } else if (strcmp(operation, "route") == 0) {
+    snprintf(name, sizeof(name), "cell number: %s[%u]", file, number);
+    int cell;
+
+    if (operand && getNumber(&cell, operand, name, 1, BRLSIM_CELL_COUNT)) {
+      return addScriptStep(STEP_ROUTE, cell-1);
+    }
+
+    if (operand) return 0;
+  } else if (strcmp(operation, "wait") == 0) {
+    snprintf(name, sizeof(name), "wait time: %s[%u]", file, number);
+    int time;
+
+    if (operand && getNumber(&time, operand, name, 0, BRLSIM_WAIT_LIMIT)) {
+      return addScriptStep(STEP_WAIT, time);
+    }
+
+    if (operand) return 0;
+  } else {
+    logMessage(LOG_ERR, "unknown script operation: %s[%u]: %s", file, number, operation);
+    return 0;
+  }
+
+  logMessage(LOG_ERR, "malformed script line: %s[%u]: %s", file, number, operation);
+  return 0;
+}
+
+static int
+loadScript (const char *file) {
+  FILE *stream = fopen(file, "r");
+
+  if (!stream) {
+    logMessage(LOG_ERR, "script open error: %s: %s", file, strerror(errno));
+    return 0;
+  }
+
+  int ok = 1;
+  unsigned int number = 0;
+  char line[0X100];
+
+  while (fgets(line, sizeof(line), stream)) {
+    if (!parseScriptLine(line, file, ++number)) {
+      ok = 0;
+      break;
+    }
+  }
+
+  fclose(stream);
+  return ok;
+}
+
+static void
+playScript (TimeValue *next, const TimeValue *now) {
+  /* at most one pass per call so that a script without waits can't starve input */
+  unsigned int count = script.count;
+
+  while (count-- && (compareTimeValues(next, now) <= 0)) {
+    const ScriptStep *step = &script.steps[script.next];
+    script.next = (script.next + 1) % script.count;
+
+    switch (step->type) {
+      case STEP_KEY:
+        writeDeviceKey(1);
+        writeDeviceKey(0);
+        break;
+
+      case STEP_ROUTE:
+        writeDeviceRoutingKey(step->value);
+        break;
+
+      case STEP_WAIT:
+        adjustTimeValue(next, step->value);
+        break;
+    }
+  }
+}
+
+int
+main (int argc, char *argv[]) {
+  PROCESS_COMMAND_LINE(programDescriptor, argc, argv);
+
+  {
+    static const char *const choices[] = {"baum", "handytech", "eurobraille", NULL};
+    static const DeviceModel *const models[] = {&baumModel, &handyTechModel, &euroBrailleModel};
+    unsigned int choice;
+
+    if (!validateChoice(&choice, opt_deviceModel, choices)) {
+      logMessage(LOG_ERR, "unknown device model: %s", opt_deviceModel);
+      return PROG_EXIT_SYNTAX;
+    }
+
+    deviceModel = models[choice];
+  }
+
+  int keyRate;
+  int duration;
+
+  if (!getNumber(&keyRate, opt_keyRate, "key rate", 0, 1000)) return PROG_EXIT_SYNTAX;
+  if (!getNumber(&duration, opt_duration, "duration", 1, 3600)) return PROG_EXIT_SYNTAX;
+  if (!getNumber(&acknowledgementDelay, opt_acknowledgementDelay, "acknowledgement delay", 0, 10000)) return PROG_EXIT_SYNTAX;
+
+  if (*opt_scriptFile) {
+    if (!loadScript(opt_scriptFile)) return PROG_EXIT_SYNTAX;
+  } else if (keyRate) {
+    if (!addScriptStep(STEP_KEY, 0)) return PROG_EXIT_FATAL;
+    if (!addScriptStep(STEP_WAIT, (MSECS_PER_SEC / keyRate))) return PROG_EXIT_FATAL;
+  }
+
+  char *path;
+  if (!openPty(&path)) return PROG_EXIT_FATAL;
+
+  /* keep the slave open (and raw) so that the master doesn't see EIO between driver sessions */
+  int slaveDescriptor = open(path, O_RDWR | O_NOCTTY);
+
+  if (slaveDescriptor == -1) {
+    logMessage(LOG_ERR, "pty slave open error: %s: %s", path, strerror(errno));
+    return PROG_EXIT_FATAL;
+  }
+
+  {
+    struct termios attributes;
+
+    if (tcgetattr(slaveDescriptor, &attributes) != -1) {
+      cfmakeraw(&attributes);
+      tcsetattr(slaveDescriptor, TCSANOW, &attributes);
+    }
+  }
+
+  resetHistogram(&statistics.commandLatency);
+  resetHistogram(&statistics.writeLatency);
+  pid_t child = -1;
+
+  if (argc > 0) {
+    if ((child = startCommand(argv, argc, path)) == -1) return PROG_EXIT_FATAL;
+  } else {
+    printf("%s\n", path);
+    fflush(stdout);
+  }
+
+  TimeValue start;
+  getMonotonicTime(&start);
+
+  TimeValue nextStep = start;
+
+  while (1) {
+    TimeValue now;
+    getMonotonicTime(&now);
+
+    long int elapsed = millisecondsBetween(&start, &now);
+    if (elapsed >= (duration * MSECS_PER_SEC)) break;
+
+    writeDueAcknowledgements(&now);
+
+    expireAwaitedCommands(&now);
+
+    if (keyPress.isPending && (millisecondsBetween(&keyPress.time, &now) >= BRLSIM_LATENCY_LIMIT)) {
+      keyPress.isPending = 0;
+    }
+
+    /* start pressing keys once the driver has written to the display */
+    if (!statistics.brailleWrites) {
+      nextStep = now;
+    } else if (script.count) {
+      playScript(&nextStep, &now);
+    }
+
+    {
+      struct pollfd descriptors[] = {
+        { .fd = masterDescriptor,
+          .events = POLLIN
+        },
+
+        { .fd = logDescriptor,
+          .events = POLLIN
+        },
+      };
+
+      switch (poll(descriptors, ARRAY_COUNT(descriptors), BRLSIM_IDLE_TIMEOUT)) {
+        case -1:
+          if (errno == EINTR) continue;
+          logSystemError("poll");
+          goto done;
+
+        case 0:
+          processInput(1);
+          break;
+
+        default:
+          if (descriptors[1].revents) readCommandLog();
+          if (descriptors[0].revents && !readInput()) goto done;
+          break;
+      }
+    }
+
+    if (child != -1) {
+      int status;
+
+      if (waitpid(child, &status, WNOHANG) == child) {
+        logMessage(LOG_WARNING, "command ended before the simulation");
+        child = -1;
+        break;
+      }
+    }
+  }
+
+done:
+  {
+    TimeValue now;
+    getMonotonicTime(&now);
+    showStatistics(millisecondsBetween(&start, &now) / (double)MSECS_PER_SEC);
+  }
+
+  if (child != -1) {
+    kill(child, SIGTERM);
+
+    for (unsigned int count=0; count<BRLSIM_TERMINATE_TIMEOUT; count+=BRLSIM_IDLE_TIMEOUT) {
+      if (waitpid(child, NULL, WNOHANG) == child) {
+        child = -1;
+        break;
+      }
+
+      /* keep draining its standard error so that it can't block while exiting */
+      if (logDescriptor != -1) readCommandLog();
+      asyncWait(BRLSIM_IDLE_TIMEOUT);
+    }
+
+    if (child != -1) {
+      logMessage(LOG_WARNING, "command not terminated - killing it");
+      kill(child, SIGKILL);
+      waitpid(child, NULL, 0);
+    }
+  }
+
+  if (logDescriptor != -1) close(logDescriptor);
+  close(slaveDescriptor);
+  close(masterDescriptor);
+  if (script.steps) free(script.steps);
+  free(path);
+  return PROG_EXIT_SUCCESS;
+}
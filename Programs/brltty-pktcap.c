@@ -0,0 +1,294 @@
+/*
+ * BRLTTY - A background process providing access to the console screen (when in
+ *          text mode) for a blind person using a refreshable braille display.
+ *
+ * Copyright (C) 1995-2026 by The BRLTTY Developers.
+ *
+ * BRLTTY comes with ABSOLUTELY NO WARRANTY.
+ *
+ * This is free software, placed under the terms of the
+ * GNU Lesser General Public License, as published by the Free Software
+ * Foundation; either version 2.1 of the License, or (at your option) any
+ * later version. Please see the file LICENSE-LGPL for details.
+ *
+ * Web Page: http://brltty.app/
+ *
+ * This software is maintained by Dave Mielke <dave@mielke.cc>.
+ */
+
+#include "prologue.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+
+#include "log.h"
+#include "cmdline.h"
+#include "pkt_capture.h"
+#include "timing.h"
+
+static int opt_pcapFormat;
+static char *opt_outputFile;
+
+BEGIN_COMMAND_LINE_OPTIONS(programOptions)
+  { .word = "pcap",
+    .letter = 'p',
+    .setting.flag = &opt_pcapFormat,
+    .description = strtext("Write pcap (rather than text) output.")
+  },
+
+  { .word = "output-file",
+    .letter = 'o',
+    .argument = strtext("file"),
+    .setting.string = &opt_outputFile,
+    .description = strtext("Path to the output file (standard output if not specified).")
+  },
+END_COMMAND_LINE_OPTIONS(programOptions)
+
+static const char *firstFile;
+
+BEGIN_COMMAND_LINE_PARAMETERS(programParameters)
+  { .name = "file",
+    .description = "the path to a packet capture file",
+    .setting = &firstFile,
+  },
+END_COMMAND_LINE_PARAMETERS(programParameters)
+
+BEGIN_COMMAND_LINE_NOTES(programNotes)
+  "Packet capture files are written by brltty when its --packet-capture option is specified.",
+  "Rotated files should be specified from oldest to newest (e.g. file.2 file.1 file).",
+  "",
+  "The pcap output uses link type USER0 (147).",
+  "Each frame begins with a two-byte pseudo-header:",
+  "the record type (I=input, O=output, C=channel) and the channel number.",
+END_COMMAND_LINE_NOTES
+
+BEGIN_COMMAND_LINE_DESCRIPTOR(programDescriptor)
+  .name = "brltty-pktcap",
+  .purpose = strtext("Decode a braille device packet capture file."),
+
+  .options = &programOptions,
+  .parameters = &programParameters,
+  .notes = COMMAND_LINE_NOTES(programNotes),
+
+  .extraParameters = {
+    .name = "more",
+    .description = "additional packet capture files",
+  },
+END_COMMAND_LINE_DESCRIPTOR
+
+#define PCAP_MAGIC 0XA1B2C3D4
+#define PCAP_LINKTYPE_USER0 147
+
+static FILE *outputStream;
+static char *channelIdentifiers[0X100];
+
+static uint64_t
+getInteger (const unsigned char *bytes, size_t size) {
+  uint64_t value = 0;
+
+  while (size--) {
+    value <<= 8;
+    value |= bytes[size];
+  }
+
+  return value;
+}
+
+static int
+getVarint (FILE *stream, uint64_t *value) {
+  unsigned int shift = 0;
+  *value = 0;
+
+  while (1) {
+    int byte = fgetc(stream);
+    if (byte == EOF) return 0;
+
+    *value |= (uint64_t)(byte & 0X7F) << shift;
+    if (!(byte & 0X80)) return 1;
+    if ((shift += 7) >= 64) return 0;
+  }
+}
+
+static void
+putInteger (uint64_t value, size_t size) {
+  while (size--) {
+    fputc(value & UINT8_MAX, outputStream);
+    value >>= 8;
+  }
+}
+
+static void
+writePcapHeader (void) {
+  putInteger(PCAP_MAGIC, 4);
+  putInteger(2, 2);
+  putInteger(4, 2);
+  putInteger(0, 4);
+  putInteger(0, 4);
+  putInteger(UINT16_MAX + 2, 4);
+  putInteger(PCAP_LINKTYPE_USER0, 4);
+}
+
+static void
+writePcapRecord (
+  const TimeValue *time, unsigned char type, unsigned char channel,
+  const unsigned char *data, size_t size
+) {
+  putInteger(time->seconds, 4);
+  putInteger(time->nanoseconds / NSECS_PER_USEC, 4);
+  putInteger(size + 2, 4);
+  putInteger(size + 2, 4);
+
+  fputc(type, outputStream);
+  fputc(channel, outputStream);
+  fwrite(data, 1, size, outputStream);
+}
+
+static void
+writeTextRecord (
+  const TimeValue *time, unsigned char type, unsigned char channel,
+  const unsigned char *data, size_t size
+) {
+  {
+    char buffer[0X20];
+    size_t length = formatSeconds(buffer, sizeof(buffer), "%Y-%m-%d@%H:%M:%S", time->seconds);
+    unsigned int milliseconds = time->nanoseconds / NSECS_PER_MSEC;
+
+    fprintf(outputStream, "%.*s.%03u ", (int)length, buffer, milliseconds);
+  }
+
+  if (type == PCR_CHANNEL) {
+    fprintf(outputStream, "packet channel %u: %.*s\n", channel, (int)size, data);
+    return;
+  }
+
+  if (channel && channelIdentifiers[channel]) {
+    fprintf(outputStream, "[%s] ", channelIdentifiers[channel]);
+  }
+
+  if (type == PCR_OUTPUT) {
+    fputs("output packet: sent:", outputStream);
+  } else {
+    fputs("input packet:", outputStream);
+  }
+
+  for (size_t index=0; index<size; index+=1) {
+    fprintf(outputStream, " %2.2X", data[index]);
+  }
+
+  fputc('\n', outputStream);
+}
+
+static void
+setChannelIdentifier (unsigned char channel, const unsigned char *data, size_t size) {
+  char **identifier = &channelIdentifiers[channel];
+
+  if (*identifier) free(*identifier);
+
+  if ((*identifier = malloc(size + 1))) {
+    memcpy(*identifier, data, size);
+    (*identifier)[size] = 0;
+  } else {
+    logMallocError();
+  }
+}
+
+static int
+processFile (const char *path) {
+  int ok = 0;
+  FILE *stream = fopen(path, "rb");
+
+  if (stream) {
+    unsigned char header[PKT_CAPTURE_HEADER_SIZE];
+
+    if ((fread(header, 1, sizeof(header), stream) == sizeof(header)) &&
+        (memcmp(header, PKT_CAPTURE_MAGIC, PKT_CAPTURE_MAGIC_SIZE) == 0)) {
+      const unsigned char *byte = header + PKT_CAPTURE_MAGIC_SIZE;
+      unsigned char version = *byte;
+      byte += 4;
+
+      if (version == PKT_CAPTURE_VERSION) {
+        TimeValue time = {
+          .seconds = getInteger(byte, 8),
+          .nanoseconds = getInteger(byte+8, 4)
+        };
+
+        ok = 1;
+
+        while (1) {
+          unsigned char prefix[4];
+          size_t count = fread(prefix, 1, sizeof(prefix), stream);
+          if (!count) break;
+
+          uint64_t delay;
+          size_t size = getInteger(&prefix[2], 2);
+          unsigned char data[size + 1];
+
+          if ((count < sizeof(prefix)) ||
+              !getVarint(stream, &delay) ||
+              (fread(data, 1, size, stream) < size)) {
+            logMessage(LOG_WARNING, "truncated packet capture record: %s", path);
+            break;
+          }
+
+          {
+            int64_t nanoseconds = time.nanoseconds + ((delay % USECS_PER_SEC) * NSECS_PER_USEC);
+
+            time.seconds += delay / USECS_PER_SEC;
+            time.seconds += nanoseconds / NSECS_PER_SEC;
+            time.nanoseconds = nanoseconds % NSECS_PER_SEC;
+          }
+
+          unsigned char type = prefix[0];
+          unsigned char channel = prefix[1];
+          if (type == PCR_CHANNEL) setChannelIdentifier(channel, data, size);
+
+          if (opt_pcapFormat) {
+            writePcapRecord(&time, type, channel, data, size);
+          } else {
+            writeTextRecord(&time, type, channel, data, size);
+          }
+        }
+      } else {
+        logMessage(LOG_ERR, "unsupported packet capture version: %s: %u", path, version);
+      }
+    } else {
+      logMessage(LOG_ERR, "not a packet capture file: %s", path);
+    }
+
+    fclose(stream);
+  } else {
+    logMessage(LOG_ERR, "packet capture file open error: %s: %s", path, strerror(errno));
+  }
+
+  return ok;
+}
+
+int
+main (int argc, char *argv[]) {
+  PROCESS_COMMAND_LINE(programDescriptor, argc, argv);
+
+  if (*opt_outputFile) {
+    if (!(outputStream = fopen(opt_outputFile, (opt_pcapFormat? "wb": "w")))) {
+      logMessage(LOG_ERR, "output file open error: %s: %s", opt_outputFile, strerror(errno));
+      return PROG_EXIT_FATAL;
+    }
+  } else {
+    outputStream = stdout;
+  }
+
+  if (opt_pcapFormat) writePcapHeader();
+  int ok = processFile(firstFile);
+
+  while (argc > 0) {
+    if (!processFile(*argv++)) ok = 0;
+    argc -= 1;
+  }
+
+  if (fclose(outputStream) == EOF) {
+    logSystemError("output file close");
+    return PROG_EXIT_FATAL;
+  }
+
+  return ok? PROG_EXIT_SUCCESS: PROG_EXIT_SEMANTIC;
+}
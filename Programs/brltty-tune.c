@@ -34,6 +34,10 @@ static int opt_fromFiles;
 static char *opt_outputVolume;
 static char *opt_tuneDevice;
 
+#ifdef HAVE_PCM_SUPPORT
+static int opt_reportRendering;
+#endif /* HAVE_PCM_SUPPORT */
+
 #ifdef HAVE_MIDI_SUPPORT
 static char *opt_midiInstrument;
 #endif /* HAVE_MIDI_SUPPORT */
@@ -66,6 +70,12 @@ BEGIN_COMMAND_LINE_OPTIONS(programOptions)
     .setting.string = &opt_pcmDevice,
     .description = "Device specifier for soundcard digital audio."
   },
+
+  { .word = "report",
+    .letter = 'r',
+    .setting.flag = &opt_reportRendering,
+    .description = "Report the render time and buffer size of each PCM tune."
+  },
 #endif /* HAVE_PCM_SUPPORT */
 
 #ifdef HAVE_MIDI_SUPPORT
@@ -128,6 +138,23 @@ playTune (TuneBuilder *tb) {
     tunePlayTones(tune, 0);
     tuneSynchronize();
     free(tune);
+
+#ifdef HAVE_PCM_SUPPORT
+    if (opt_reportRendering) {
+      const char *name = getTuneSourceName(tb);
+      PcmTuneReport report;
+
+      if (!getPcmTuneReport(&report)) {
+        printf("%s: not rendered\n", name);
+      } else if (report.renderTime) {
+        printf("%s: %zu bytes rendered in %luus\n",
+               name, report.bufferSize, report.renderTime);
+      } else {
+        printf("%s: %zu bytes (already rendered)\n",
+               name, report.bufferSize);
+      }
+    }
+#endif /* HAVE_PCM_SUPPORT */
   }
 }
 
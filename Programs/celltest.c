@@ -0,0 +1,304 @@
+/*
+ * BRLTTY - A background process providing access to the console screen (when in
+ *          text mode) for a blind person using a refreshable braille display.
+ *
+ * Copyright (C) 1995-2026 by The BRLTTY Developers.
+ *
+ * BRLTTY comes with ABSOLUTELY NO WARRANTY.
+ *
+ * This is free software, placed under the terms of the
+ * GNU Lesser General Public License, as published by the Free Software
+ * Foundation; either version 2.1 of the License, or (at your option) any
+ * later version. Please see the file LICENSE-LGPL for details.
+ *
+ * Web Page: http://brltty.app/
+ *
+ * This software is maintained by Dave Mielke <dave@mielke.cc>.
+ */
+
+#include "prologue.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "log.h"
+#include "cmdline.h"
+#include "cmdput.h"
+#include "parse.h"
+#include "io_generic.h"
+#include "gio_internal.h"
+#include "brl.h"
+#include "brl_utils.h"
+
+BrailleDisplay brl;
+char *opt_driversDirectory;
+
+static char *opt_baudRate;
+static char *opt_cellCount;
+static char *opt_writeOverhead;
+static char *opt_cellSize;
+static char *opt_updateCount;
+static char *opt_changeCount;
+static char *opt_seed;
+static int opt_changeEnds;
+
+BEGIN_COMMAND_LINE_OPTIONS(programOptions)
+  { .word = "baud",
+    .letter = 'b',
+    .argument = "integer",
+    .setting.string = &opt_baudRate,
+    .internal.setting = "9600",
+    .description = "serial baud rate (8N1)"
+  },
+
+  { .word = "cells",
+    .letter = 'c',
+    .argument = "integer",
+    .setting.string = &opt_cellCount,
+    .internal.setting = "40",
+    .description = "number of cells on the line"
+  },
+
+  { .word = "overhead",
+    .letter = 'o',
+    .argument = "integer",
+    .setting.string = &opt_writeOverhead,
+    .internal.setting = "6",
+    .description = "framing bytes per write packet"
+  },
+
+  { .word = "cell-size",
+    .letter = 'w',
+    .argument = "integer",
+    .setting.string = &opt_cellSize,
+    .internal.setting = "1",
+    .description = "bytes written per cell"
+  },
+
+  { .word = "updates",
+    .letter = 'u',
+    .argument = "integer",
+    .setting.string = &opt_updateCount,
+    .internal.setting = "10000",
+    .description = "number of updates to model"
+  },
+
+  { .word = "changes",
+    .letter = 'm',
+    .argument = "integer",
+    .setting.string = &opt_changeCount,
+    .internal.setting = "3",
+    .description = "maximum number of random cells changed per update"
+  },
+
+  { .word = "seed",
+    .letter = 's',
+    .argument = "integer",
+    .setting.string = &opt_seed,
+    .internal.setting = "1",
+    .description = "seed for the random changes"
+  },
+
+  { .word = "ends",
+    .letter = 'e',
+    .setting.flag = &opt_changeEnds,
+    .description = "change the first and last cells of every update instead"
+  },
+END_COMMAND_LINE_OPTIONS(programOptions)
+
+BEGIN_COMMAND_LINE_PARAMETERS(programParameters)
+END_COMMAND_LINE_PARAMETERS(programParameters)
+
+BEGIN_COMMAND_LINE_NOTES(programNotes)
+  "Each update is written both as the single span reported by cellsHaveChanged",
+  "and as the ranges reported by getChangedCellRanges (at most four, as drivers use it).",
+  "Every write packet is charged its framing overhead, and its transfer time is",
+  "taken from gioGetMillisecondsToTransfer for the given baud rate.",
+  "",
+  "The defaults model the Alva protocol 1 write packet.",
+  "The Baum driver's PowerBraille protocol is -o 8 -w 2.",
+END_COMMAND_LINE_NOTES
+
+BEGIN_COMMAND_LINE_DESCRIPTOR(programDescriptor)
+  .name = "celltest",
+  .purpose = strtext("Model the serial transfer time of single-span versus multi-range braille cell updates."),
+
+  .options = &programOptions,
+  .parameters = &programParameters,
+  .notes = COMMAND_LINE_NOTES(programNotes),
+END_COMMAND_LINE_DESCRIPTOR
+
+typedef struct {
+  const char *name;
+  unsigned char *cells;
+
+  unsigned long int packets;
+  unsigned long int bytes;
+  unsigned long int milliseconds;
+} UpdateModel;
+
+static GioEndpoint *endpoint;
+static unsigned int writeOverhead;
+static unsigned int cellSize;
+
+static void
+addPacket (UpdateModel *model, unsigned int count) {
+  size_t bytes = writeOverhead + (count * cellSize);
+
+  model->packets += 1;
+  model->bytes += bytes;
+  model->milliseconds += gioGetMillisecondsToTransfer(endpoint, bytes);
+}
+
+static void
+putResults (const UpdateModel *model, unsigned int updates) {
+  putf("%s: %.2f packets, %.1f bytes, %.1fms per update\n",
+       model->name,
+       (double)model->packets / updates,
+       (double)model->bytes / updates,
+       (double)model->milliseconds / updates);
+}
+
+static int
+getIntegerOption (int *value, const char *string, int minimum, const char *name) {
+  if (validateInteger(value, string, &minimum, NULL)) return 1;
+  logMessage(LOG_ERR, "invalid %s: %s", name, string);
+  return 0;
+}
+
+int
+main (int argc, char *argv[]) {
+  PROCESS_COMMAND_LINE(programDescriptor, argc, argv);
+
+  int baud;
+  int cellCount;
+  int overhead;
+  int size;
+  int updateCount;
+  int changeCount;
+  int seed;
+
+  if (!getIntegerOption(&baud, opt_baudRate, 1, "baud rate")) return PROG_EXIT_SYNTAX;
+  if (!getIntegerOption(&cellCount, opt_cellCount, 2, "cell count")) return PROG_EXIT_SYNTAX;
+  if (!getIntegerOption(&overhead, opt_writeOverhead, 0, "write overhead")) return PROG_EXIT_SYNTAX;
+  if (!getIntegerOption(&size, opt_cellSize, 1, "cell size")) return PROG_EXIT_SYNTAX;
+  if (!getIntegerOption(&updateCount, opt_updateCount, 1, "update count")) return PROG_EXIT_SYNTAX;
+  if (!getIntegerOption(&changeCount, opt_changeCount, 1, "change count")) return PROG_EXIT_SYNTAX;
+  if (!getIntegerOption(&seed, opt_seed, 0, "seed")) return PROG_EXIT_SYNTAX;
+
+  writeOverhead = overhead;
+  cellSize = size;
+
+  {
+    GioDescriptor descriptor;
+    gioInitializeDescriptor(&descriptor);
+
+    if (!(endpoint = gioConnectResource("null:", &descriptor))) return PROG_EXIT_FATAL;
+  }
+
+  {
+    SerialParameters parameters;
+    gioInitializeSerialParameters(&parameters);
+    parameters.baud = baud;
+    gioSetBytesPerSecond(endpoint, &parameters);
+  }
+
+  unsigned char spanCells[cellCount];
+  unsigned char rangeCells[cellCount];
+  unsigned char newCells[cellCount];
+
+  memset(spanCells, 0, cellCount);
+  memset(rangeCells, 0, cellCount);
+  memset(newCells, 0, cellCount);
+
+  UpdateModel span = {
+    .name = "single span",
+    .cells = spanCells
+  };
+
+  UpdateModel ranges = {
+    .name = "ranges",
+    .cells = rangeCells
+  };
+
+  /* the gap, in cells, that costs as much as starting another packet */
+  unsigned int gapOverhead = writeOverhead / cellSize;
+
+  srand(seed);
+
+  for (int update=0; update<updateCount; update+=1) {
+    if (opt_changeEnds) {
+      newCells[0] += 1;
+      newCells[cellCount-1] += 1;
+    } else {
+      int count = 1 + (rand() % changeCount);
+
+      while (count-- > 0) {
+        newCells[rand() % cellCount] += 1 + (rand() % 0XFE);
+      }
+    }
+
+    {
+      unsigned int from;
+      unsigned int to;
+
+      if (cellsHaveChanged(span.cells, newCells, cellCount, &from, &to, NULL)) {
+        addPacket(&span, to-from);
+      }
+    }
+
+    {
+      CellRange list[4];
+      unsigned int count = getChangedCellRanges(
+        ranges.cells, newCells, cellCount,
+        list, ARRAY_COUNT(list), gapOverhead, NULL
+      );
+
+      for (unsigned int index=0; index<count; index+=1) {
+        addPacket(&ranges, list[index].to-list[index].from);
+      }
+    }
+  }
+
+  putf("%d updates of %d cells at %d baud, %u framing bytes and %u bytes per cell\n",
+       updateCount, cellCount, baud, writeOverhead, cellSize);
+  putResults(&span, updateCount);
+  putResults(&ranges, updateCount);
+
+  gioDisconnectResource(endpoint);
+  return PROG_EXIT_SUCCESS;
+}
+
+#include "message.h"
+
+int
+message (const char *mode, const char *text, MessageOptions options) {
+  return 1;
+}
+
+int
+sayMessage (const char *text) {
+  return 1;
+}
+
+#include "scr.h"
+
+KeyTableCommandContext
+getScreenCommandContext (void) {
+  return KTB_CTX_DEFAULT;
+}
+
+#include "alert.h"
+
+void
+alert (AlertIdentifier identifier) {
+}
+
+void
+speakAlertText (const wchar_t *text) {
+}
+
+#include "api_control.h"
+
+const ApiMethods api;
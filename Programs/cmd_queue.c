@@ -34,6 +34,7 @@
 #include "ktb_types.h"
 #include "scr.h"
 #include "core.h"
+#include "brl_latency.h"
 
 #define LOG_LEVEL LOG_DEBUG
 
@@ -151,6 +152,7 @@ ASYNC_ALARM_CALLBACK(handleCommandAlarm) {
       CommandEnvironment *env = commandEnvironmentStack;
       env->handlingCommand = 1;
 
+      markBrailleLatencyStage(BLS_COMMAND_STARTED);
       void *pre = env->preprocessCommand? env->preprocessCommand(): NULL;
       int handled = handleCommand(command);
 
@@ -158,6 +160,8 @@ ASYNC_ALARM_CALLBACK(handleCommandAlarm) {
         env->postprocessCommand(pre, command, cmd, handled);
       }
 
+      markBrailleLatencyStage(BLS_COMMAND_FINISHED);
+
       env->handlingCommand = 0;
     }
   }
@@ -202,6 +206,7 @@ enqueueCommand (int command) {
         item->command = command;
 
         if (enqueueItem(queue, item)) {
+          if (command != BRL_CMD_NOOP) markBrailleLatencyStage(BLS_COMMAND_ENQUEUED);
           setCommandAlarm(NULL);
           return 1;
         }
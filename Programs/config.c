@@ -29,6 +29,7 @@
 #include "parameters.h"
 #include "embed.h"
 #include "log.h"
+#include "pkt_capture.h"
 #include "report.h"
 #include "strfmt.h"
 #include "pgmprivs.h"
@@ -77,6 +78,9 @@
 #include "api_control.h"
 #include "prefs.h"
 #include "utf8.h"
+#include "thread.h"
+#include "timing.h"
+#include "device_cache.h"
 
 #include "io_generic.h"
 #include "io_usb.h"
@@ -254,6 +258,7 @@ int opt_noDaemon;
 int opt_logToStandardError;
 static char *opt_logLevel;
 char *opt_logFile;
+char *opt_packetCapture;
 int opt_environmentVariables;
 int opt_bootParameters = 1;
 static char *opt_messageTime;
@@ -279,6 +284,7 @@ char *opt_brailleDevice;
 static char **brailleDevices = NULL;
 static const char *brailleDevice = NULL;
 int opt_releaseDevice;
+static int opt_concurrentProbing;
 
 char *opt_brailleDriver;
 static char **brailleDrivers = NULL;
@@ -362,6 +368,31 @@ setAutospeakThreshold (void) {
     "autospeakThreshold", "Autospeak Threshold"
   );
 }
+
+static char *opt_autospeakBacklog;
+unsigned int autospeakMaximumBacklog;
+
+static void
+setAutospeakBacklog (void) {
+  const char *string = opt_autospeakBacklog;
+  int value = 0;
+
+  if (*string) {
+    static const int minimum = 0;
+
+    if (!validateInteger(&value, string, &minimum, NULL)) {
+      logMessage(LOG_ERR, "%s: %s",
+        gettext("invalid autospeak backlog"),
+        string
+      );
+
+      value = 0;
+    }
+  }
+
+  autospeakMaximumBacklog = value;
+  if (value) logProperty(string, "autospeakBacklog", "Autospeak Backlog");
+}
 #endif /* ENABLE_SPEECH_SUPPORT */
 
 char *opt_screenDriver;
@@ -466,6 +497,12 @@ BEGIN_COMMAND_LINE_OPTIONS(programOptions)
     .description = strtext("Release braille device when screen or window is unreadable.")
   },
 
+  { .word = "concurrent-probing",
+    .flags = OPT_Config | OPT_EnvVar,
+    .setting.flag = &opt_concurrentProbing,
+    .description = strtext("Probe multiple braille devices concurrently during autodetection.")
+  },
+
   { .word = "text-table",
     .letter = 't',
     .bootParameter = 3,
@@ -536,6 +573,13 @@ BEGIN_COMMAND_LINE_OPTIONS(programOptions)
     .description = strtext("Minimum screen content quality to autospeak (one of {%s})."),
     .strings.format = formatScreenContentQualityChoices
   },
+
+  { .word = "autospeak-backlog",
+    .flags = OPT_Config | OPT_EnvVar,
+    .argument = strtext("milliseconds"),
+    .setting.string = &opt_autospeakBacklog,
+    .description = strtext("Skip screen content changes while the estimated speech backlog exceeds this (0 means never).")
+  },
 #endif /* ENABLE_SPEECH_SUPPORT */
 
   { .word = "screen-driver",
@@ -650,6 +694,13 @@ BEGIN_COMMAND_LINE_OPTIONS(programOptions)
     .description = strtext("Path to log file.")
   },
 
+  { .word = "packet-capture",
+    .flags = OPT_Config | OPT_EnvVar,
+    .argument = strtext("file"),
+    .setting.string = &opt_packetCapture,
+    .description = strtext("Path to binary capture file for braille device packets.")
+  },
+
   { .word = "standard-error",
     .letter = 'e',
     .setting.flag = &opt_logToStandardError,
@@ -877,6 +928,7 @@ changeLogCategories (const char *operand) {
 
 static void
 exitLog (void *data) {
+  closePacketCapture();
   closeSystemLog();
   closeLogFile();
 }
@@ -956,12 +1008,18 @@ brlttyPrepare (int argc, char *argv[]) {
     logProperty(opt_logLevel, "logLevel", "Log Level");
   }
 
+  if (*opt_packetCapture) {
+    openPacketCapture(opt_packetCapture, 0, 0);
+    logProperty(opt_packetCapture, "packetCapture", "Packet Capture");
+  }
+
   logProperty(getMessagesLocale(), "messagesLocale", "Messages Locale");
   logProperty(getMessagesDomain(), "messagesDomain", "Messages Domain");
   logProperty(getMessagesDirectory(), "messagesDirectory", "Messages Directory");
 
 #ifdef ENABLE_SPEECH_SUPPORT
   setAutospeakThreshold();
+  setAutospeakBacklog();
 #endif /* ENABLE_SPEECH_SUPPORT */
 
   establishPrivileges();
@@ -1745,15 +1803,49 @@ typedef struct {
   const char *driverType;
   const char *const *requestedDrivers;
   const char *const *autodetectableDrivers;
+  const char *excludedDriver;
   const char * (*getDefaultDriver) (void);
   int (*haveDriver) (const char *code);
   int (*initializeDriver) (const char *code, int verify);
+
+  struct {
+    int (*tryDriver) (const char *code, int wait, void *data);
+    int (*isCancelled) (void *data);
+    void *data;
+  } probe;
 } DriverActivationData;
 
+static int
+isAutodetectRequested (const char *const *drivers) {
+  return drivers[0] && !drivers[1] && (strcmp(drivers[0], optionOperand_autodetect) == 0);
+}
+
+static int
+tryDriver (const DriverActivationData *data, const char *code, int verify, int wait) {
+  TimeValue started;
+  getMonotonicTime(&started);
+
+  logMessage(LOG_DEBUG, "checking for %s driver: %s", data->driverType, code);
+
+  int found = data->probe.tryDriver?
+              data->probe.tryDriver(code, wait, data->probe.data):
+              data->initializeDriver(code, verify);
+
+  if (found < 0) {
+    logMessage(LOG_DEBUG, "%s driver busy: %s", data->driverType, code);
+  } else {
+    logMessage(LOG_DEBUG, "%s driver %s: %s after %ldms",
+               data->driverType, code, (found? "found": "not found"),
+               getMonotonicElapsed(&started));
+  }
+
+  return found;
+}
+
 static int
 activateDriver (const DriverActivationData *data, int verify) {
   int oneDriver = data->requestedDrivers[0] && !data->requestedDrivers[1];
-  int autodetect = oneDriver && (strcmp(data->requestedDrivers[0], optionOperand_autodetect) == 0);
+  int autodetect = isAutodetectRequested(data->requestedDrivers);
   const char *const defaultDrivers[] = {data->getDefaultDriver(), NULL};
   const char *const *driver;
 
@@ -1774,15 +1866,36 @@ activateDriver (const DriverActivationData *data, int verify) {
     autodetect = 0;
   }
 
+  unsigned int driverCount = 0;
+  while (driver[driverCount]) driverCount += 1;
+
+  const char *deferredDrivers[driverCount + 1];
+  unsigned int deferredCount = 0;
+
   while (*driver) {
+    if (data->probe.isCancelled && data->probe.isCancelled(data->probe.data)) {
+      logMessage(LOG_DEBUG, "%s driver search cancelled", data->driverType);
+      return 0;
+    }
+
     if (!autodetect || data->haveDriver(*driver)) {
-      logMessage(LOG_DEBUG, "checking for %s driver: %s", data->driverType, *driver);
-      if (data->initializeDriver(*driver, verify)) return 1;
+      if (data->excludedDriver && (strcmp(*driver, data->excludedDriver) == 0)) {
+        logMessage(LOG_DEBUG, "%s driver already checked: %s", data->driverType, *driver);
+      } else {
+        int found = tryDriver(data, *driver, verify, 0);
+
+        if (found > 0) return 1;
+        if (found < 0) deferredDrivers[deferredCount++] = *driver;
+      }
     }
 
     ++driver;
   }
 
+  for (unsigned int index=0; index<deferredCount; index+=1) {
+    if (tryDriver(data, deferredDrivers[index], verify, 1) > 0) return 1;
+  }
+
   logMessage(LOG_DEBUG, "%s driver not found", data->driverType);
   return 0;
 }
@@ -1803,10 +1916,16 @@ forgetDevices (void) {
   bthForgetDevices();
 }
 
+static BrailleProbeCancelledTester *brailleProbeCancelledTester = NULL;
+static void *brailleProbeCancelledData = NULL;
+
 static void
 initializeBrailleDisplay (void) {
   constructBrailleDisplay(&brl);
   brl.bufferResized = &brailleWindowReconfigured;
+
+  brl.probe.isCancelled = brailleProbeCancelledTester;
+  brl.probe.data = brailleProbeCancelledData;
 }
 
 static LockDescriptor *
@@ -1988,70 +2107,179 @@ initializeBrailleDriver (const char *code, int verify) {
   return 0;
 }
 
-static int
-activateBrailleDriver (int verify) {
-  int oneDevice = brailleDevices[0] && !brailleDevices[1];
-  const char *const *device = (const char *const *)brailleDevices;
+static void
+cacheBrailleDriver (void) {
+  setCachedDeviceDriver(brailleDevice, braille->definition.code, brailleParameters);
+}
 
-  if (!oneDevice) verify = 0;
+static GioTypeIdentifier
+getBrailleDeviceType (const char **device) {
+  const GioPublicProperties *properties = gioGetPublicProperties(device);
+  if (properties) return properties->type.identifier;
+  return GIO_TYPE_UNSPECIFIED;
+}
 
-  while (*device) {
-    const char *const *autodetectableDrivers = NULL;
+static const char *const *
+getAutodetectableBrailleDrivers (const char *device) {
+  const char *const *drivers = NULL;
+  const char *dev = device;
+  const GioPublicProperties *properties = gioGetPublicProperties(&dev);
 
-    brailleDevice = *device;
-    logMessage(LOG_DEBUG, "checking braille device: %s", brailleDevice);
+  if (properties) {
+    logMessage(LOG_DEBUG, "braille device type: %s", properties->type.name);
 
-    {
-      const char *dev = brailleDevice;
-      const GioPublicProperties *properties = gioGetPublicProperties(&dev);
+    switch (properties->type.identifier) {
+      case GIO_TYPE_SERIAL: {
+        drivers = autodetectableBrailleDrivers_serial;
+        break;
+      }
 
-      if (properties) {
-        logMessage(LOG_DEBUG, "braille device type: %s", properties->type.name);
+      case GIO_TYPE_USB: {
+        drivers = autodetectableBrailleDrivers_USB;
+        break;
+      }
 
-        switch (properties->type.identifier) {
-          case GIO_TYPE_SERIAL: {
-            autodetectableDrivers = autodetectableBrailleDrivers_serial;
-            break;
-          }
+      case GIO_TYPE_BLUETOOTH: {
+        TimeValue lookupStarted;
+        getMonotonicTime(&lookupStarted);
 
-          case GIO_TYPE_USB: {
-            autodetectableDrivers = autodetectableBrailleDrivers_USB;
-            break;
-          }
+        if (!(drivers = bthGetDriverCodes(dev, BLUETOOTH_DEVICE_NAME_OBTAIN_TIMEOUT))) {
+          drivers = autodetectableBrailleDrivers_Bluetooth;
+        }
 
-          case GIO_TYPE_BLUETOOTH: {
-            if (!(autodetectableDrivers = bthGetDriverCodes(dev, BLUETOOTH_DEVICE_NAME_OBTAIN_TIMEOUT))) {
-              autodetectableDrivers = autodetectableBrailleDrivers_Bluetooth;
-            }
+        logMessage(LOG_DEBUG, "bluetooth driver codes obtained after %ldms",
+                   getMonotonicElapsed(&lookupStarted));
 
-            break;
-          }
+        break;
+      }
 
-          default:
-            break;
-        }
+      default:
+        break;
+    }
+  } else {
+    logMessage(LOG_DEBUG, "unrecognized braille device type");
+  }
+
+  if (!drivers) {
+    static const char *noDrivers[] = {NULL};
+    drivers = noDrivers;
+  }
+
+  return drivers;
+}
+
+typedef struct BrailleDeviceEntryStruct BrailleDeviceEntry;
+
+struct BrailleDeviceEntryStruct {
+  BrailleDeviceEntry *next;
+  const char *device;
+  char cachedDriver[0X10];
+  unsigned char cachedDriverFailed:1;
+};
+
+static void
+initializeBrailleDeviceEntry (BrailleDeviceEntry *entry, const char *device, int autodetect) {
+  entry->next = NULL;
+  entry->device = device;
+  entry->cachedDriver[0] = 0;
+  entry->cachedDriverFailed = 0;
+
+  if (autodetect) {
+    const char *code = getCachedDeviceDriver(device, brailleParameters);
+
+    if (code) {
+      if (haveBrailleDriver(code)) {
+        snprintf(entry->cachedDriver, sizeof(entry->cachedDriver), "%s", code);
       } else {
-        logMessage(LOG_DEBUG, "unrecognized braille device type");
+        entry->cachedDriverFailed = 1;
       }
     }
+  }
+}
 
-    if (!autodetectableDrivers) {
-      static const char *noDrivers[] = {NULL};
-      autodetectableDrivers = noDrivers;
+static void
+finishBrailleDeviceEntry (const BrailleDeviceEntry *entry) {
+  if (entry->cachedDriverFailed) removeCachedDeviceDriver(entry->device);
+}
+
+static int
+checkBrailleDevice (
+  BrailleDeviceEntry *entry, int verify, int autodetect,
+  int (*tryDriver) (const char *code, int wait, void *data),
+  int (*isCancelled) (void *data),
+  void *data
+) {
+  TimeValue started;
+  getMonotonicTime(&started);
+  logMessage(LOG_DEBUG, "checking braille device: %s", entry->device);
+
+  if (*entry->cachedDriver) {
+    const char *code = entry->cachedDriver;
+    logMessage(LOG_DEBUG, "checking for cached braille driver: %s", code);
+
+    if (tryDriver? (tryDriver(code, 1, data) > 0): initializeBrailleDriver(code, 0)) {
+      logMessage(LOG_INFO, "cached braille driver found: %s after %ldms",
+                 code, getMonotonicElapsed(&started));
+      return 1;
     }
 
-    {
-      const DriverActivationData data = {
-        .driverType = "braille",
-        .requestedDrivers = (const char *const *)brailleDrivers,
-        .autodetectableDrivers = autodetectableDrivers,
-        .getDefaultDriver = getDefaultBrailleDriver,
-        .haveDriver = haveBrailleDriver,
-        .initializeDriver = initializeBrailleDriver
-      };
-      if (activateDriver(&data, verify)) return 1;
+    if (isCancelled && isCancelled(data)) return 0;
+    entry->cachedDriverFailed = 1;
+
+    logMessage(LOG_DEBUG, "cached braille driver not found: %s after %ldms",
+               code, getMonotonicElapsed(&started));
+  }
+
+  {
+    const DriverActivationData activation = {
+      .driverType = "braille",
+      .requestedDrivers = (const char *const *)brailleDrivers,
+      .autodetectableDrivers = getAutodetectableBrailleDrivers(entry->device),
+      .excludedDriver = *entry->cachedDriver? entry->cachedDriver: NULL,
+      .getDefaultDriver = getDefaultBrailleDriver,
+      .haveDriver = haveBrailleDriver,
+      .initializeDriver = initializeBrailleDriver,
+
+      .probe = {
+        .tryDriver = tryDriver,
+        .isCancelled = isCancelled,
+        .data = data
+      }
+    };
+
+    if (activateDriver(&activation, verify)) {
+      if (autodetect) {
+        logMessage(LOG_INFO, "braille driver autodetected: %s after %ldms",
+                   entry->device, getMonotonicElapsed(&started));
+      }
+
+      return 1;
     }
+  }
 
+  if (autodetect) {
+    logMessage(LOG_DEBUG, "braille driver autodetection failed: %s after %ldms",
+               entry->device, getMonotonicElapsed(&started));
+  }
+
+  return 0;
+}
+
+static int
+activateBrailleDevices (int verify, int autodetect) {
+  const char *const *device = (const char *const *)brailleDevices;
+
+  while (*device) {
+    BrailleDeviceEntry entry;
+    initializeBrailleDeviceEntry(&entry, *device, autodetect);
+    brailleDevice = entry.device;
+
+    if (checkBrailleDevice(&entry, verify, autodetect, NULL, NULL, NULL)) {
+      if (autodetect) cacheBrailleDriver();
+      return 1;
+    }
+
+    finishBrailleDeviceEntry(&entry);
     device += 1;
   }
 
@@ -2059,6 +2287,427 @@ activateBrailleDriver (int verify) {
   return 0;
 }
 
+#ifdef GOT_PTHREADS
+/* Concurrent probing: serial ports each get their own thread, and Bluetooth
+ * devices share one (the Bluetooth device list isn't thread-safe). Everything
+ * else, notably USB (whose I/O completion relies on signals which the probe
+ * threads block), is checked on the calling thread. A driver is only ever
+ * active on one thread at a time because drivers keep their state in statics.
+ * Probes check for cancellation between their I/O steps, so the others stop
+ * as soon as one has found its display. Probe threads release the display as
+ * soon as it has answered - the winning driver is then constructed again on
+ * the calling thread so that its async I/O is bound to the main event loop,
+ * but it takes over the connection (and the loaded driver, to which
+ * the connection's options refer) which the winning probe kept.
+ */
+
+typedef struct BrailleProbeGroupStruct BrailleProbeGroup;
+
+typedef struct {
+  pthread_mutex_t mutex;
+  pthread_cond_t condition;
+
+  BrailleProbeGroup *groups;
+  unsigned int groupCount;
+  unsigned int running;
+
+  BrailleProbeGroup *winner;
+  unsigned char cancelled:1;
+} BrailleProbeState;
+
+struct BrailleProbeGroupStruct {
+  BrailleProbeState *state;
+  BrailleDeviceEntry *first;
+  BrailleDeviceEntry *last;
+  BrailleDeviceEntry *current;
+
+  const char *activeDriver;
+  BrailleDeviceEntry *foundEntry;
+  char foundDriver[0X10];
+  void *foundObject;
+
+  pthread_t thread;
+  unsigned char started:1;
+};
+
+static BrailleProbeGroup *
+addBrailleProbeGroup (BrailleProbeState *state) {
+  BrailleProbeGroup *group = &state->groups[state->groupCount++];
+
+  group->state = state;
+  group->first = group->last = group->current = NULL;
+
+  group->activeDriver = NULL;
+  group->foundEntry = NULL;
+  group->foundDriver[0] = 0;
+  group->foundObject = NULL;
+
+  group->started = 0;
+  return group;
+}
+
+static void
+addBrailleProbeEntry (BrailleProbeGroup *group, BrailleDeviceEntry *entry) {
+  if (group->last) {
+    group->last->next = entry;
+  } else {
+    group->first = entry;
+  }
+
+  group->last = entry;
+}
+
+static int
+isBrailleProbeCancelled (void *data) {
+  BrailleProbeGroup *group = data;
+  BrailleProbeState *state = group->state;
+
+  lockMutex(&state->mutex);
+  int cancelled = state->cancelled;
+  unlockMutex(&state->mutex);
+
+  return cancelled;
+}
+
+static int
+isBrailleProbeDriverActive (const BrailleProbeState *state, const char *code) {
+  const BrailleProbeGroup *group = state->groups;
+  const BrailleProbeGroup *end = group + state->groupCount;
+
+  while (group < end) {
+    if (group->activeDriver && (strcmp(group->activeDriver, code) == 0)) return 1;
+    group += 1;
+  }
+
+  return 0;
+}
+
+static int
+acquireBrailleProbeDriver (BrailleProbeGroup *group, const char *code, int wait) {
+  BrailleProbeState *state = group->state;
+  int acquired = 0;
+
+  if (strcmp(code, optionOperand_none) == 0) return 0;
+  lockMutex(&state->mutex);
+
+  while (!state->cancelled) {
+    if (!isBrailleProbeDriverActive(state, code)) {
+      group->activeDriver = code;
+      acquired = 1;
+      break;
+    }
+
+    if (!wait) {
+      acquired = -1;
+      break;
+    }
+
+    logMessage(LOG_DEBUG, "waiting for braille driver: %s", code);
+    pthread_cond_wait(&state->condition, &state->mutex);
+  }
+
+  unlockMutex(&state->mutex);
+  return acquired;
+}
+
+static int
+claimBrailleProbeWin (BrailleProbeGroup *group, int constructed) {
+  BrailleProbeState *state = group->state;
+  lockMutex(&state->mutex);
+
+  int won = constructed || !state->winner;
+
+  if (won) {
+    state->winner = group;
+    state->cancelled = 1;
+
+    group->foundEntry = group->current;
+    snprintf(group->foundDriver, sizeof(group->foundDriver), "%s", group->activeDriver);
+    pthread_cond_broadcast(&state->condition);
+  }
+
+  unlockMutex(&state->mutex);
+  return won;
+}
+
+static void
+releaseBrailleProbeDriver (BrailleProbeGroup *group) {
+  BrailleProbeState *state = group->state;
+  lockMutex(&state->mutex);
+
+  group->activeDriver = NULL;
+  pthread_cond_broadcast(&state->condition);
+  unlockMutex(&state->mutex);
+}
+
+static int
+probeBrailleDriver (const char *code, int wait, void *data) {
+  BrailleProbeGroup *group = data;
+  const char *device = group->current->device;
+  int found = acquireBrailleProbeDriver(group, code, wait);
+
+  if (found <= 0) return found;
+  found = 0;
+
+  {
+    void *object = NULL;
+    const BrailleDriver *driver = loadBrailleDriver(code, &object, opt_driversDirectory);
+
+    if (driver) {
+      char **parameters = getParameters(driver->parameters,
+                                        driver->definition.code,
+                                        brailleParameters);
+
+      if (parameters) {
+        BrailleDisplay display;
+        constructBrailleDisplay(&display);
+
+        display.probe.isCancelled = isBrailleProbeCancelled;
+        display.probe.data = group;
+
+        logMessage(LOG_DEBUG, "probing braille driver: %s -> %s", code, device);
+
+        if (driver->construct(&display, parameters, device)) {
+          found = 1;
+
+          if (claimBrailleProbeWin(group, 0)) {
+            display.probe.isCancelled = NULL;
+            display.probe.keepResource = device;
+
+            /* the kept connection refers to the driver's data */
+            group->foundObject = object;
+            object = NULL;
+          }
+
+          driver->destruct(&display);
+        }
+
+        destructBrailleDisplay(&display);
+        deallocateStrings(parameters);
+      }
+
+      unloadDriverObject(&object);
+    } else {
+      logMessage(LOG_ERR, "%s: %s", gettext("braille driver not loadable"), code);
+    }
+  }
+
+  releaseBrailleProbeDriver(group);
+  return found;
+}
+
+static int
+constructBrailleProbeDriver (const char *code, int wait, void *data) {
+  BrailleProbeGroup *group = data;
+  int found = acquireBrailleProbeDriver(group, code, wait);
+
+  if (found <= 0) return found;
+  brailleDevice = group->current->device;
+
+  brailleProbeCancelledTester = isBrailleProbeCancelled;
+  brailleProbeCancelledData = group;
+  found = initializeBrailleDriver(code, 0);
+  brailleProbeCancelledTester = NULL;
+  brailleProbeCancelledData = NULL;
+
+  /* the display is ours now, so it mustn't see the cancellation */
+  brl.probe.isCancelled = NULL;
+  brl.probe.data = NULL;
+
+  if (found) claimBrailleProbeWin(group, 1);
+  releaseBrailleProbeDriver(group);
+  return found;
+}
+
+static void
+runBrailleProbeGroup (BrailleProbeGroup *group, int (*tryDriver) (const char *code, int wait, void *data)) {
+  BrailleDeviceEntry *entry = group->first;
+
+  while (entry) {
+    if (isBrailleProbeCancelled(group)) break;
+    group->current = entry;
+
+    if (checkBrailleDevice(entry, 0, 1, tryDriver, isBrailleProbeCancelled, group)) break;
+    entry = entry->next;
+  }
+}
+
+THREAD_FUNCTION(runBrailleProbeThread) {
+  BrailleProbeGroup *group = argument;
+  BrailleProbeState *state = group->state;
+
+  runBrailleProbeGroup(group, probeBrailleDriver);
+
+  lockMutex(&state->mutex);
+  state->running -= 1;
+  pthread_cond_broadcast(&state->condition);
+  unlockMutex(&state->mutex);
+
+  return NULL;
+}
+
+static int
+activateBrailleDevicesConcurrently (void) {
+  unsigned int count = 0;
+  while (brailleDevices[count]) count += 1;
+
+  BrailleDeviceEntry entries[count];
+  BrailleProbeGroup groups[count + 1];
+
+  BrailleProbeState state = {
+    .groups = groups,
+    .groupCount = 0,
+    .running = 0,
+
+    .winner = NULL,
+    .cancelled = 0
+  };
+
+  BrailleProbeGroup *localGroup = addBrailleProbeGroup(&state);
+  BrailleProbeGroup *bluetoothGroup = NULL;
+
+  for (unsigned int index=0; index<count; index+=1) {
+    BrailleDeviceEntry *entry = &entries[index];
+    const char *device = brailleDevices[index];
+    BrailleProbeGroup *group;
+
+    initializeBrailleDeviceEntry(entry, device, 1);
+
+    switch (getBrailleDeviceType(&device)) {
+      case GIO_TYPE_SERIAL:
+        group = addBrailleProbeGroup(&state);
+        break;
+
+      case GIO_TYPE_BLUETOOTH:
+        if (!bluetoothGroup) bluetoothGroup = addBrailleProbeGroup(&state);
+        group = bluetoothGroup;
+        break;
+
+      default:
+        group = localGroup;
+        break;
+    }
+
+    addBrailleProbeEntry(group, entry);
+  }
+
+  if (state.groupCount == 1) {
+    logMessage(LOG_DEBUG, "no braille devices to probe concurrently");
+
+    for (unsigned int index=0; index<count; index+=1) {
+      finishBrailleDeviceEntry(&entries[index]);
+    }
+
+    return activateBrailleDevices(0, 1);
+  }
+
+  TimeValue started;
+  getMonotonicTime(&started);
+
+  pthread_mutex_init(&state.mutex, NULL);
+  pthread_cond_init(&state.condition, NULL);
+
+  logMessage(LOG_DEBUG, "probing braille devices concurrently: %u threads",
+             state.groupCount - 1);
+
+  for (unsigned int index=1; index<state.groupCount; index+=1) {
+    BrailleProbeGroup *group = &groups[index];
+    char name[0X20];
+
+    snprintf(name, sizeof(name), "brl-probe-%u", index);
+    lockMutex(&state.mutex);
+
+    if (createThread(name, &group->thread, NULL, runBrailleProbeThread, group) == 0) {
+      group->started = 1;
+      state.running += 1;
+    } else {
+      logMessage(LOG_WARNING, "braille probe thread not created: %s", group->first->device);
+    }
+
+    unlockMutex(&state.mutex);
+  }
+
+  runBrailleProbeGroup(localGroup, constructBrailleProbeDriver);
+
+  for (unsigned int index=1; index<state.groupCount; index+=1) {
+    BrailleProbeGroup *group = &groups[index];
+    if (!group->started) runBrailleProbeGroup(group, probeBrailleDriver);
+  }
+
+  lockMutex(&state.mutex);
+
+  while (!state.winner && state.running) {
+    pthread_cond_wait(&state.condition, &state.mutex);
+  }
+
+  state.cancelled = 1;
+  pthread_cond_broadcast(&state.condition);
+  unlockMutex(&state.mutex);
+
+  for (unsigned int index=1; index<state.groupCount; index+=1) {
+    BrailleProbeGroup *group = &groups[index];
+    if (group->started) pthread_join(group->thread, NULL);
+  }
+
+  pthread_cond_destroy(&state.condition);
+  pthread_mutex_destroy(&state.mutex);
+
+  BrailleProbeGroup *winner = state.winner;
+  int found = 0;
+
+  if (winner == localGroup) {
+    found = 1;
+  } else if (winner) {
+    brailleDevice = winner->foundEntry->device;
+    logMessage(LOG_DEBUG, "committing to braille driver: %s -> %s",
+               winner->foundDriver, brailleDevice);
+
+    found = initializeBrailleDriver(winner->foundDriver, 0);
+  }
+
+  discardKeptBrailleResource();
+  if (winner) unloadDriverObject(&winner->foundObject);
+
+  logMessage(LOG_INFO, "concurrent braille device probing: %s after %ldms",
+             (found? brailleDevice: "not found"), getMonotonicElapsed(&started));
+
+  for (unsigned int index=0; index<count; index+=1) {
+    const BrailleDeviceEntry *entry = &entries[index];
+
+    if (found && (entry == winner->foundEntry)) {
+      cacheBrailleDriver();
+    } else {
+      finishBrailleDeviceEntry(entry);
+    }
+  }
+
+  if (!found) brailleDevice = NULL;
+  return found;
+}
+#endif /* GOT_PTHREADS */
+
+static int
+activateBrailleDriver (int verify) {
+  int oneDevice = brailleDevices[0] && !brailleDevices[1];
+
+  int autodetect = isAutodetectRequested((const char *const *)brailleDrivers) &&
+                   !getDefaultBrailleDriver();
+
+  if (!oneDevice) {
+    verify = 0;
+
+    if (autodetect && opt_concurrentProbing) {
+#ifdef GOT_PTHREADS
+      return activateBrailleDevicesConcurrently();
+#else /* GOT_PTHREADS */
+      logMessage(LOG_DEBUG, "concurrent braille device probing not supported");
+#endif /* GOT_PTHREADS */
+    }
+  }
+
+  return activateBrailleDevices(verify, autodetect);
+}
+
 static void
 deactivateBrailleDriver (void) {
   if (brailleDriver) {
@@ -2071,6 +2720,7 @@ deactivateBrailleDriver (void) {
 
   unloadDriverObject(&brailleObject);
   stopAllBlinkDescriptors();
+  resetBrailleWindow();
 
   if (brailleDriverParameters) {
     deallocateStrings(brailleDriverParameters);
@@ -36,6 +36,7 @@
 #include "embed.h"
 #include "log.h"
 #include "alert.h"
+#include "tune.h"
 #include "strfmt.h"
 
 #include "cmd_queue.h"
@@ -67,6 +68,9 @@
 #include "unicode.h"
 #include "scr.h"
 #include "update.h"
+#include "update_profile.h"
+#include "io_usb.h"
+#include "brl_latency.h"
 #include "ses.h"
 #include "brl.h"
 #include "brl_utils.h"
@@ -78,6 +82,7 @@
 
 #ifdef ENABLE_SPEECH_SUPPORT
 #include "spk.h"
+#include "spk_cache.h"
 #endif /* ENABLE_SPEECH_SUPPORT */
 
 BrailleDisplay brl;                        /* For the Braille routines */
@@ -1356,6 +1361,29 @@ static time_t programTerminationRequestTime;
 static int programTerminationRequestSignal;
 static volatile sig_atomic_t programTerminationRequestCount;
 
+static volatile sig_atomic_t performanceStatisticsRequested;
+
+static void
+handlePerformanceStatisticsRequest (const void *data) {
+  logBrailleLatencyStatistics();
+  resetBrailleLatencyStatistics();
+
+  logUpdateProfile();
+  resetUpdateProfile();
+
+  usbLogInputStatistics();
+  usbResetInputStatistics();
+
+  logTuneLatencyStatistics();
+
+#ifdef ENABLE_SPEECH_SUPPORT
+  logSpeechQueueStatistics();
+  logSpeechLatencyStatistics();
+  logSpeechHandoffStatistics();
+  logAllSpeechCacheStatistics();
+#endif /* ENABLE_SPEECH_SUPPORT */
+}
+
 typedef struct {
   UnmonitoredConditionHandler *handler;
   const void *data;
@@ -1386,6 +1414,12 @@ ASYNC_CONDITION_TESTER(checkUnmonitoredConditions) {
     return 1;
   }
 
+  if (performanceStatisticsRequested) {
+    performanceStatisticsRequested = 0;
+    ucd->handler = handlePerformanceStatisticsRequest;
+    return 1;
+  }
+
   {
     static RoutingStatus status;
 
@@ -1571,6 +1605,12 @@ ASYNC_SIGNAL_HANDLER(handleProgramTerminationRequest) {
 ASYNC_SIGNAL_HANDLER(handleChildDeath) {
 }
 #endif /* SIGCHLD */
+
+#ifdef SIGUSR1
+ASYNC_SIGNAL_HANDLER(handlePerformanceStatisticsSignal) {
+  performanceStatisticsRequested = 1;
+}
+#endif /* SIGUSR1 */
 #endif /* ASYNC_CAN_HANDLE_SIGNALS */
 
 ProgramExitStatus
@@ -1589,6 +1629,7 @@ brlttyConstruct (int argc, char *argv[]) {
   programTerminationRequestTime = time(NULL);
   programTerminationRequestSignal = 0;
   programTerminationRequestCount = 0;
+  performanceStatisticsRequested = 0;
 
 #ifdef ASYNC_CAN_BLOCK_SIGNALS
   asyncBlockObtainableSignals();
@@ -1613,6 +1654,10 @@ brlttyConstruct (int argc, char *argv[]) {
 #ifdef SIGCHLD
   asyncHandleSignal(SIGCHLD, handleChildDeath, NULL);
 #endif /* SIGCHLD */
+
+#ifdef SIGUSR1
+  asyncHandleSignal(SIGUSR1, handlePerformanceStatisticsSignal, NULL);
+#endif /* SIGUSR1 */
 #endif /* ASYNC_CAN_HANDLE_SIGNALS */
 
   interruptEnabledCount = 0;
@@ -192,6 +192,7 @@ extern int haveSpeechSynthesizer (void);
 
 extern int isAutospeakActive (void);
 extern unsigned int autospeakMinimumScreenContentQuality;
+extern unsigned int autospeakMaximumBacklog;
 
 extern void sayScreenCharacters (const ScreenCharacter *characters, size_t count, SayOptions options);
 extern void speakCharacters (const ScreenCharacter *characters, size_t count, int spell, int interrupt);
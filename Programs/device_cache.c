@@ -0,0 +1,278 @@
+/*
+ * BRLTTY - A background process providing access to the console screen (when in
+ *          text mode) for a blind person using a refreshable braille display.
+ *
+ * Copyright (C) 1995-2026 by The BRLTTY Developers.
+ *
+ * BRLTTY comes with ABSOLUTELY NO WARRANTY.
+ *
+ * This is free software, placed under the terms of the
+ * GNU Lesser General Public License, as published by the Free Software
+ * Foundation; either version 2.1 of the License, or (at your option) any
+ * later version. Please see the file LICENSE-LGPL for details.
+ *
+ * Web Page: http://brltty.app/
+ *
+ * This software is maintained by Dave Mielke <dave@mielke.cc>.
+ */
+
+
+#include "prologue.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+
+#include "log.h"
+#include "device_cache.h"
+#include "file.h"
+
+/* Remembers which driver last answered on each configured device
+ * specification so that autodetection can try it before probing the others.
+ * An entry is only used while the driver parameters it was found with are
+ * still the configured ones.
+ * Each line of the file is: device <tab> driver <tab> driver parameters
+ */
+
+#define DEVICE_CACHE_FILE "device-drivers.cache"
+
+typedef struct {
+  char *device;
+  char *driver;
+  char *parameters;
+} DeviceCacheEntry;
+
+static struct {
+  unsigned char loaded:1;
+
+  DeviceCacheEntry *array;
+  unsigned int size;
+  unsigned int count;
+} deviceCache = {
+  .loaded = 0
+};
+
+static void
+deallocateDeviceCacheEntry (DeviceCacheEntry *entry) {
+  if (entry->device) free(entry->device);
+  if (entry->driver) free(entry->driver);
+  if (entry->parameters) free(entry->parameters);
+}
+
+static DeviceCacheEntry *
+findDeviceCacheEntry (const char *device) {
+  DeviceCacheEntry *entry = deviceCache.array;
+  const DeviceCacheEntry *end = entry + deviceCache.count;
+
+  while (entry < end) {
+    if (strcmp(entry->device, device) == 0) return entry;
+    entry += 1;
+  }
+
+  return NULL;
+}
+
+static int
+addDeviceCacheEntry (const char *device, const char *driver, const char *parameters) {
+  if (deviceCache.count == deviceCache.size) {
+    unsigned int newSize = deviceCache.size? deviceCache.size<<1: 4;
+    DeviceCacheEntry *newArray = realloc(deviceCache.array, ARRAY_SIZE(newArray, newSize));
+
+    if (!newArray) {
+      logMallocError();
+      return 0;
+    }
+
+    deviceCache.array = newArray;
+    deviceCache.size = newSize;
+  }
+
+  {
+    DeviceCacheEntry *entry = &deviceCache.array[deviceCache.count];
+
+    entry->device = strdup(device);
+    entry->driver = strdup(driver);
+    entry->parameters = strdup(parameters);
+
+    if (entry->device && entry->driver && entry->parameters) {
+      deviceCache.count += 1;
+      return 1;
+    }
+
+    logMallocError();
+    deallocateDeviceCacheEntry(entry);
+  }
+
+  return 0;
+}
+
+static int
+processDeviceCacheLine (const LineHandlerParameters *parameters) {
+  char *line = parameters->line.text;
+  if (!*line || (*line == '#')) return 1;
+
+  {
+    static const char delimiters[] = "\t";
+
+    const char *device = strtok(line, delimiters);
+    const char *driver = strtok(NULL, delimiters);
+    const char *driverParameters = strtok(NULL, delimiters);
+
+    if (!(device && driver)) {
+      logMessage(LOG_WARNING, "malformed device cache entry: line %u",
+                 parameters->line.number);
+      return 1;
+    }
+
+    if (!driverParameters) driverParameters = "";
+    if (!findDeviceCacheEntry(device)) addDeviceCacheEntry(device, driver, driverParameters);
+  }
+
+  return 1;
+}
+
+static void
+loadDeviceCache (void) {
+  if (!deviceCache.loaded) {
+    char *path = makeUpdatablePath(DEVICE_CACHE_FILE);
+
+    deviceCache.loaded = 1;
+
+    if (path) {
+      if (testFilePath(path)) {
+        FILE *file = openFile(path, "r", 1);
+
+        if (file) {
+          logMessage(LOG_DEBUG, "loading device cache: %s", path);
+          processLines(file, processDeviceCacheLine, NULL);
+          fclose(file);
+        }
+      }
+
+      free(path);
+    }
+  }
+}
+
+static int
+saveDeviceCache (void) {
+  int ok = 0;
+  char *path = makeUpdatablePath(DEVICE_CACHE_FILE);
+
+  if (path) {
+    static const char suffix[] = ".new";
+    char newPath[strlen(path) + strlen(suffix) + 1];
+    snprintf(newPath, sizeof(newPath), "%s%s", path, suffix);
+
+    {
+      FILE *file = fopen(newPath, "w");
+
+      if (file) {
+        const DeviceCacheEntry *entry = deviceCache.array;
+        const DeviceCacheEntry *end = entry + deviceCache.count;
+
+        fprintf(file, "# device\tdriver\tparameters\n");
+
+        while (entry < end) {
+          fprintf(file, "%s\t%s\t%s\n", entry->device, entry->driver, entry->parameters);
+          entry += 1;
+        }
+
+        if (fflush(file) != EOF) ok = 1;
+        if (!ok) logSystemError("fflush");
+        fclose(file);
+
+        if (ok) {
+          if (rename(newPath, path) == -1) {
+            logSystemError("rename");
+            ok = 0;
+          }
+        }
+      } else {
+        logMessage(LOG_DEBUG, "cannot create device cache: %s: %s",
+                   newPath, strerror(errno));
+      }
+    }
+
+    free(path);
+  }
+
+  return ok;
+}
+
+const char *
+getCachedDeviceDriver (const char *device, const char *parameters) {
+  const DeviceCacheEntry *entry;
+
+  loadDeviceCache();
+  if (!(entry = findDeviceCacheEntry(device))) return NULL;
+  if (!parameters) parameters = "";
+
+  if (strcmp(entry->parameters, parameters) != 0) {
+    logMessage(LOG_DEBUG, "cached device driver parameters changed: %s -> %s (%s -> %s)",
+               device, entry->driver, entry->parameters, parameters);
+    return NULL;
+  }
+
+  logMessage(LOG_DEBUG, "cached device driver: %s -> %s (%s)",
+             device, entry->driver, entry->parameters);
+  return entry->driver;
+}
+
+int
+setCachedDeviceDriver (const char *device, const char *driver, const char *parameters) {
+  DeviceCacheEntry *entry;
+
+  loadDeviceCache();
+  if (!parameters) parameters = "";
+
+  if ((entry = findDeviceCacheEntry(device))) {
+    if ((strcmp(entry->driver, driver) == 0) &&
+        (strcmp(entry->parameters, parameters) == 0)) {
+      return 1;
+    }
+
+    {
+      char *newDriver = strdup(driver);
+      char *newParameters = strdup(parameters);
+
+      if (!(newDriver && newParameters)) {
+        if (newDriver) free(newDriver);
+        if (newParameters) free(newParameters);
+        logMallocError();
+        return 0;
+      }
+
+      free(entry->driver);
+      entry->driver = newDriver;
+
+      free(entry->parameters);
+      entry->parameters = newParameters;
+    }
+  } else if (!addDeviceCacheEntry(device, driver, parameters)) {
+    return 0;
+  }
+
+  logMessage(LOG_DEBUG, "caching device driver: %s -> %s (%s)",
+             device, driver, parameters);
+  return saveDeviceCache();
+}
+
+int
+removeCachedDeviceDriver (const char *device) {
+  DeviceCacheEntry *entry;
+
+  loadDeviceCache();
+  if (!(entry = findDeviceCacheEntry(device))) return 1;
+
+  logMessage(LOG_DEBUG, "invalidating cached device driver: %s -> %s",
+             device, entry->driver);
+
+  deallocateDeviceCacheEntry(entry);
+  deviceCache.count -= 1;
+
+  memmove(entry, entry+1,
+          ((deviceCache.array + deviceCache.count) - entry) * sizeof(*entry));
+
+  return saveDeviceCache();
+}
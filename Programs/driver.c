@@ -20,6 +20,7 @@
 
 #include "log.h"
 #include "driver.h"
+#include "pkt_capture.h"
 
 void
 unsupportedDeviceIdentifier (const char *identifier) {
@@ -27,15 +28,27 @@ unsupportedDeviceIdentifier (const char *identifier) {
 }
 
 void
-logOutputPacket (const void *packet, size_t size) {
+logChannelOutputPacket (unsigned char channel, const void *packet, size_t size) {
+  capturePacket(PCR_OUTPUT, channel, packet, size);
   logBytes(LOG_CATEGORY(OUTPUT_PACKETS), "sent", packet, size);
 }
 
 void
-logInputPacket (const void *packet, size_t size) {
+logChannelInputPacket (unsigned char channel, const void *packet, size_t size) {
+  capturePacket(PCR_INPUT, channel, packet, size);
   logBytes(LOG_CATEGORY(INPUT_PACKETS), NULL, packet, size);
 }
 
+void
+logOutputPacket (const void *packet, size_t size) {
+  logChannelOutputPacket(0, packet, size);
+}
+
+void
+logInputPacket (const void *packet, size_t size) {
+  logChannelInputPacket(0, packet, size);
+}
+
 void
 logInputProblem (const char *problem, const unsigned char *bytes, size_t count) {
   logBytes(LOG_WARNING, "%s", bytes, count, problem);
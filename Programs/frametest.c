@@ -0,0 +1,588 @@
+/*
+ * BRLTTY - A background process providing access to the console screen (when in
+ *          text mode) for a blind person using a refreshable braille display.
+ *
+ * Copyright (C) 1995-2026 by The BRLTTY Developers.
+ *
+ * BRLTTY comes with ABSOLUTELY NO WARRANTY.
+ *
+ * This is free software, placed under the terms of the
+ * GNU Lesser General Public License, as published by the Free Software
+ * Foundation; either version 2.1 of the License, or (at your option) any
+ * later version. Please see the file LICENSE-LGPL for details.
+ *
+ * Web Page: http://brltty.app/
+ *
+ * This software is maintained by Dave Mielke <dave@mielke.cc>.
+ */
+
+#include "prologue.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+
+#include "log.h"
+#include "cmdline.h"
+#include "cmdput.h"
+#include "parse.h"
+#include "timing.h"
+#include "io_generic.h"
+#include "brl.h"
+#include "brl_base.h"
+#include "pkt_capture.h"
+
+BrailleDisplay brl;
+char *opt_driversDirectory;
+
+static char *opt_captureFile;
+static char *opt_packetCount;
+static char *opt_seed;
+
+BEGIN_COMMAND_LINE_OPTIONS(programOptions)
+  { .word = "capture-file",
+    .letter = 'c',
+    .argument = "file",
+    .setting.string = &opt_captureFile,
+    .description = "replay the input packets in a packet capture file"
+  },
+
+  { .word = "packets",
+    .letter = 'p',
+    .argument = "integer",
+    .setting.string = &opt_packetCount,
+    .internal.setting = "20000",
+    .description = "number of packets to generate"
+  },
+
+  { .word = "seed",
+    .letter = 's',
+    .argument = "integer",
+    .setting.string = &opt_seed,
+    .internal.setting = "1",
+    .description = "seed for the generated packets"
+  },
+END_COMMAND_LINE_OPTIONS(programOptions)
+
+BEGIN_COMMAND_LINE_PARAMETERS(programParameters)
+END_COMMAND_LINE_PARAMETERS(programParameters)
+
+BEGIN_COMMAND_LINE_NOTES(programNotes)
+  "The same input stream is written, in bursts, to a pty and read by",
+  "readBraillePacket, one byte at a time with the HIMS driver's former verifier,",
+  "and by readFramedBraillePacket, with its current framing table.",
+  "The two must produce the same packets.",
+  "",
+  "Unless a packet capture file (written by brltty --packet-capture) is given,",
+  "a stream of HIMS key and routing packets, with the odd stray byte, is generated.",
+  "Each input record of a capture file is written as one burst.",
+END_COMMAND_LINE_NOTES
+
+BEGIN_COMMAND_LINE_DESCRIPTOR(programDescriptor)
+  .name = "frametest",
+  .purpose = strtext("Replay a braille input stream through the byte-at-a-time and the buffered packet readers."),
+
+  .options = &programOptions,
+  .parameters = &programParameters,
+  .notes = COMMAND_LINE_NOTES(programNotes),
+END_COMMAND_LINE_DESCRIPTOR
+
+typedef struct {
+  unsigned char *bytes;
+  size_t size;
+  size_t allocated;
+} ByteBuffer;
+
+static int
+addBytes (ByteBuffer *buffer, const void *bytes, size_t count) {
+  size_t size = buffer->size + count;
+
+  if (size > buffer->allocated) {
+    size_t allocated = MAX(size, (buffer->allocated? (buffer->allocated << 1): 0X1000));
+    unsigned char *newBytes = realloc(buffer->bytes, allocated);
+
+    if (!newBytes) {
+      logMallocError();
+      return 0;
+    }
+
+    buffer->bytes = newBytes;
+    buffer->allocated = allocated;
+  }
+
+  memcpy(&buffer->bytes[buffer->size], bytes, count);
+  buffer->size = size;
+  return 1;
+}
+
+/* the input stream, and where each of its bursts ends */
+static ByteBuffer inputStream;
+static ByteBuffer burstEnds;
+
+static int
+endBurst (void) {
+  size_t end = inputStream.size;
+  return addBytes(&burstEnds, &end, sizeof(end));
+}
+
+static int
+addPacket (const unsigned char *packet, size_t size) {
+  return addBytes(&inputStream, packet, size);
+}
+
+static int
+generateStream (unsigned int count) {
+  while (count > 0) {
+    unsigned int burst = 1 + (rand() % 8);
+
+    while (burst > 0) {
+      if (!(rand() % 100)) {
+        const unsigned char stray = 0X20 + (rand() % 0X40);
+        if (!addPacket(&stray, 1)) return 0;
+      }
+
+      if (rand() % 4) {
+        unsigned char packet[] = {0X1C, rand(), rand(), 0X1F};
+        if (!addPacket(packet, sizeof(packet))) return 0;
+      } else {
+        unsigned char packet[] = {
+          0XFA, 0X01, 0X01, rand(), 0, 0, 0, 0, 0, 0XFB
+        };
+
+        unsigned char checksum = 0;
+        for (unsigned int index=0; index<sizeof(packet); index+=1) checksum += packet[index];
+        packet[8] = checksum;
+
+        if (!addPacket(packet, sizeof(packet))) return 0;
+      }
+
+      count -= 1;
+      burst -= 1;
+      if (!count) break;
+    }
+
+    if (!endBurst()) return 0;
+  }
+
+  return 1;
+}
+
+static uint64_t
+getInteger (const unsigned char *bytes, size_t size) {
+  uint64_t value = 0;
+
+  while (size > 0) {
+    value <<= 8;
+    value |= bytes[--size];
+  }
+
+  return value;
+}
+
+static int
+skipVarint (FILE *stream) {
+  int byte;
+
+  do {
+    if ((byte = fgetc(stream)) == EOF) return 0;
+  } while (byte & 0X80);
+
+  return 1;
+}
+
+static int
+loadCapture (const char *path) {
+  int ok = 0;
+  FILE *stream = fopen(path, "rb");
+
+  if (stream) {
+    unsigned char header[PKT_CAPTURE_HEADER_SIZE];
+
+    if ((fread(header, 1, sizeof(header), stream) == sizeof(header)) &&
+        (memcmp(header, PKT_CAPTURE_MAGIC, PKT_CAPTURE_MAGIC_SIZE) == 0) &&
+        (header[PKT_CAPTURE_MAGIC_SIZE] == PKT_CAPTURE_VERSION)) {
+      ok = 1;
+
+      while (1) {
+        unsigned char prefix[4];
+        size_t count = fread(prefix, 1, sizeof(prefix), stream);
+        if (!count) break;
+
+        size_t size = getInteger(&prefix[2], 2);
+        unsigned char data[size + 1];
+
+        if ((count < sizeof(prefix)) ||
+            !skipVarint(stream) ||
+            (fread(data, 1, size, stream) < size)) {
+          logMessage(LOG_WARNING, "truncated packet capture record: %s", path);
+          break;
+        }
+
+        if (prefix[0] == PCR_INPUT) {
+          if (!addPacket(data, size) || !endBurst()) {
+            ok = 0;
+            break;
+          }
+        }
+      }
+    } else {
+      logMessage(LOG_ERR, "not a packet capture file: %s", path);
+    }
+
+    fclose(stream);
+  } else {
+    logMessage(LOG_ERR, "packet capture file open error: %s: %s", path, strerror(errno));
+  }
+
+  return ok;
+}
+
+/* the HIMS verifier as it was before the driver was converted */
+static BraillePacketVerifierResult
+verifyPacket (
+  BrailleDisplay *brl,
+  unsigned char *bytes, size_t size,
+  size_t *length, void *data
+) {
+  unsigned char byte = bytes[size-1];
+
+  if (size == 1) {
+    switch (byte) {
+      case 0X1C:
+        *length = 4;
+        break;
+
+      case 0XFA:
+        *length = 10;
+        break;
+
+      default:
+        return BRL_PVR_INVALID;
+    }
+  }
+
+  if (size == *length) {
+    switch (bytes[0]) {
+      case 0X1C:
+        if (byte != 0X1F) return BRL_PVR_INVALID;
+        break;
+
+      case 0XFA: {
+        if (byte != 0XFB) return BRL_PVR_INVALID;
+
+        int checksum = -bytes[8];
+        for (size_t i=0; i<size; i+=1) checksum += bytes[i];
+
+        if ((checksum & 0XFF) != bytes[8]) {
+          logInputProblem("incorrect input checksum", bytes, size);
+          return BRL_PVR_INVALID;
+        }
+
+        break;
+      }
+
+      default:
+        break;
+    }
+  }
+
+  return BRL_PVR_INCLUDE;
+}
+
+/* the HIMS framing table as it is now */
+static const BraillePacketFrame packetFrames[] = {
+  { .header = 0X1C,
+    .length = 4,
+    .hasTrailer = 1,
+    .trailer = 0X1F
+  },
+
+  { .header = 0XFA,
+    .length = 10,
+    .hasTrailer = 1,
+    .trailer = 0XFB,
+    .checksum = BRL_PFC_SUM,
+    .checksumPosition = 2
+  },
+};
+
+static const BraillePacketFraming packetFraming = {
+  .frames = packetFrames,
+  .frameCount = ARRAY_COUNT(packetFrames)
+};
+
+typedef size_t PacketReader (BrailleDisplay *brl, void *packet, size_t size);
+
+static size_t
+readBytewisePacket (BrailleDisplay *brl, void *packet, size_t size) {
+  return readBraillePacket(brl, NULL, packet, size, verifyPacket, NULL);
+}
+
+static size_t
+readBufferedPacket (BrailleDisplay *brl, void *packet, size_t size) {
+  return readFramedBraillePacket(brl, NULL, packet, size, &packetFraming, NULL);
+}
+
+typedef struct {
+  const char *name;
+  PacketReader *readPacket;
+
+  ByteBuffer packets;
+  unsigned int packetCount;
+  long int elapsed;   /* milliseconds - first read to last packet */
+  long int processor; /* microseconds - user plus system */
+} ReplayPath;
+
+static void
+writeStream (int descriptor) {
+  const size_t *end = (const size_t *)burstEnds.bytes;
+  const size_t *last = end + (burstEnds.size / sizeof(*end));
+  size_t from = 0;
+
+  while (end < last) {
+    while (from < *end) {
+      ssize_t count = write(descriptor, &inputStream.bytes[from], (*end - from));
+
+      if (count == -1) {
+        if (errno == EINTR) continue;
+        _exit(PROG_EXIT_FATAL);
+      }
+
+      from += count;
+    }
+
+    end += 1;
+  }
+
+  _exit(PROG_EXIT_SUCCESS);
+}
+
+static long int
+getProcessorTime (void) {
+  struct rusage usage;
+
+  if (getrusage(RUSAGE_SELF, &usage) == -1) {
+    logSystemError("getrusage");
+    return 0;
+  }
+
+  return ((usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * USECS_PER_SEC)
+       + usage.ru_utime.tv_usec + usage.ru_stime.tv_usec;
+}
+
+static int
+openPty (int *master, char **path) {
+  if ((*master = posix_openpt(O_RDWR | O_NOCTTY)) != -1) {
+    if ((grantpt(*master) != -1) && (unlockpt(*master) != -1)) {
+      const char *name = ptsname(*master);
+
+      if (name) {
+        if ((*path = strdup(name))) return 1;
+        logMallocError();
+      } else {
+        logSystemError("ptsname");
+      }
+    } else {
+      logSystemError("pty unlock");
+    }
+
+    close(*master);
+  } else {
+    logSystemError("posix_openpt");
+  }
+
+  return 0;
+}
+
+static int
+replayStream (ReplayPath *path) {
+  int ok = 0;
+  int master;
+  char *slave;
+
+  if (openPty(&master, &slave)) {
+    char identifier[strlen(slave) + 8];
+    snprintf(identifier, sizeof(identifier), "serial:%s", slave);
+
+    static const SerialParameters serialParameters = {
+      SERIAL_DEFAULT_PARAMETERS,
+      .baud = 115200
+    };
+
+    GioDescriptor descriptor;
+    gioInitializeDescriptor(&descriptor);
+    descriptor.serial.parameters = &serialParameters;
+
+    constructBrailleDisplay(&brl);
+
+    if ((brl.gioEndpoint = gioConnectResource(identifier, &descriptor))) {
+      pid_t writer = fork();
+
+      if (writer == 0) {
+        writeStream(master);
+      } else if (writer != -1) {
+        int writing = 1;
+        TimeValue start;
+        TimeValue end;
+        long int processor = getProcessorTime();
+
+        getMonotonicTime(&start);
+        end = start;
+        ok = 1;
+
+        while (1) {
+          unsigned char packet[0X100];
+          size_t size = path->readPacket(&brl, packet, sizeof(packet));
+
+          if (size) {
+            if (!addBytes(&path->packets, packet, size)) {
+              ok = 0;
+              break;
+            }
+
+            path->packetCount += 1;
+            getMonotonicTime(&end);
+            continue;
+          }
+
+          if (writing) {
+            int status;
+            if (waitpid(writer, &status, WNOHANG) == writer) writing = 0;
+          }
+
+          if (!awaitBrailleInput(&brl, (writing? 100: 500)) && !writing) break;
+        }
+
+        path->processor = getProcessorTime() - processor;
+        path->elapsed = millisecondsBetween(&start, &end);
+
+        if (writing) {
+          kill(writer, SIGTERM);
+          waitpid(writer, NULL, 0);
+        }
+      } else {
+        logSystemError("fork");
+      }
+
+      disconnectBrailleResource(&brl, NULL);
+    }
+
+    destructBrailleDisplay(&brl);
+    free(slave);
+    close(master);
+  }
+
+  return ok;
+}
+
+static void
+putResults (const ReplayPath *path) {
+  unsigned int count = path->packetCount;
+
+  putf("%s: %u packets, %zu bytes, %ldms elapsed, %ldus processor",
+       path->name, count, path->packets.size, path->elapsed, path->processor);
+
+  if (count) {
+    putf(" (%.2fus per packet)", (double)path->processor / count);
+  }
+
+  putf("\n");
+}
+
+int
+main (int argc, char *argv[]) {
+  PROCESS_COMMAND_LINE(programDescriptor, argc, argv);
+
+  if (opt_captureFile && *opt_captureFile) {
+    if (!loadCapture(opt_captureFile)) return PROG_EXIT_FATAL;
+  } else {
+    int count;
+    int seed;
+
+    {
+      static const int minimum = 1;
+
+      if (!validateInteger(&count, opt_packetCount, &minimum, NULL)) {
+        logMessage(LOG_ERR, "invalid packet count: %s", opt_packetCount);
+        return PROG_EXIT_SYNTAX;
+      }
+    }
+
+    if (!validateInteger(&seed, opt_seed, NULL, NULL)) {
+      logMessage(LOG_ERR, "invalid seed: %s", opt_seed);
+      return PROG_EXIT_SYNTAX;
+    }
+
+    srand(seed);
+    if (!generateStream(count)) return PROG_EXIT_FATAL;
+  }
+
+  putf("input stream: %zu bytes in %zu bursts\n",
+       inputStream.size, (burstEnds.size / sizeof(size_t)));
+
+  ReplayPath paths[] = {
+    { .name = "byte-at-a-time",
+      .readPacket = readBytewisePacket
+    },
+
+    { .name = "buffered",
+      .readPacket = readBufferedPacket
+    },
+  };
+
+  for (unsigned int index=0; index<ARRAY_COUNT(paths); index+=1) {
+    ReplayPath *path = &paths[index];
+    if (!replayStream(path)) return PROG_EXIT_FATAL;
+    putResults(path);
+  }
+
+  const ReplayPath *bytewise = &paths[0];
+  const ReplayPath *buffered = &paths[1];
+
+  if ((bytewise->packetCount != buffered->packetCount) ||
+      (bytewise->packets.size != buffered->packets.size) ||
+      (memcmp(bytewise->packets.bytes, buffered->packets.bytes, bytewise->packets.size) != 0)) {
+    putf("the two readers produced different packets\n");
+    return PROG_EXIT_FATAL;
+  }
+
+  return PROG_EXIT_SUCCESS;
+}
+
+#include "message.h"
+
+int
+message (const char *mode, const char *text, MessageOptions options) {
+  return 1;
+}
+
+int
+sayMessage (const char *text) {
+  return 1;
+}
+
+#include "scr.h"
+
+KeyTableCommandContext
+getScreenCommandContext (void) {
+  return KTB_CTX_DEFAULT;
+}
+
+#include "alert.h"
+
+void
+alert (AlertIdentifier identifier) {
+}
+
+void
+speakAlertText (const wchar_t *text) {
+}
+
+#include "api_control.h"
+
+const ApiMethods api;
@@ -45,6 +45,7 @@ gioInitializeOptions (GioOptions *options) {
   options->inputTimeout = 0;
   options->outputTimeout = 0;
   options->requestTimeout = 0;
+  options->lowLatency = 0;
 }
 
 void
@@ -52,6 +53,7 @@ gioInitializeDescriptor (GioDescriptor *descriptor) {
   descriptor->serial.parameters = NULL;
   gioInitializeOptions(&descriptor->serial.options);
   descriptor->serial.options.inputTimeout = 100;
+  descriptor->serial.options.lowLatency = 1;
 
   descriptor->usb.channelDefinitions = NULL;
   descriptor->usb.setConnectionProperties = NULL;
@@ -59,6 +61,7 @@ gioInitializeDescriptor (GioDescriptor *descriptor) {
   descriptor->usb.options.inputTimeout = 1000;
   descriptor->usb.options.outputTimeout = 1000;
   descriptor->usb.options.requestTimeout = 1000;
+  descriptor->usb.options.lowLatency = 1;
 
   descriptor->bluetooth.channelNumber = 0;
   descriptor->bluetooth.discoverChannel = 0;
@@ -453,6 +456,14 @@ gioGetMillisecondsToTransfer (GioEndpoint *endpoint, size_t bytes) {
   return endpoint->bytesPerSecond? (((bytes * 1000) / endpoint->bytesPerSecond) + 1): 0;
 }
 
+unsigned int
+gioGetOutputDelay (GioEndpoint *endpoint) {
+  GioGetOutputDelayMethod *method = endpoint->handleMethods->getOutputDelay;
+
+  if (!method) return 0;
+  return method(endpoint->handle);
+}
+
 ssize_t
 gioTellResource (
   GioEndpoint *endpoint,
@@ -37,6 +37,8 @@ typedef void *GioGetResourceObjectMethod (GioHandle *handle);
 
 typedef ssize_t GioWriteDataMethod (GioHandle *handle, const void *data, size_t size, int timeout);
 
+typedef unsigned int GioGetOutputDelayMethod (GioHandle *handle);
+
 typedef int GioAwaitInputMethod (GioHandle *handle, int timeout);
 
 typedef ssize_t GioReadDataMethod (
@@ -94,6 +96,7 @@ typedef struct {
   GioGetResourceObjectMethod *getResourceObject;
 
   GioWriteDataMethod *writeData;
+  GioGetOutputDelayMethod *getOutputDelay;
   GioAwaitInputMethod *awaitInput;
   GioReadDataMethod *readData;
   GioMonitorInputMethod *monitorInput;
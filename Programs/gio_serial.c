@@ -134,6 +134,11 @@ connectSerialResource (
     if ((handle->device = serialOpenDevice(identifier))) {
       if (serialSetParameters(handle->device, descriptor->serial.parameters)) {
         handle->parameters = *descriptor->serial.parameters;
+
+        if (descriptor->serial.options.lowLatency) {
+          serialSetLatency(handle->device, SERIAL_LATENCY_LOW);
+        }
+
         return handle;
       }
 
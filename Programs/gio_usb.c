@@ -101,6 +101,15 @@ writeUsbData (GioHandle *handle, const void *data, size_t size, int timeout) {
   return -1;
 }
 
+static unsigned int
+getUsbOutputDelay (GioHandle *handle) {
+  UsbChannel *channel = handle->channel;
+  unsigned char endpoint = channel->definition->outputEndpoint;
+
+  if (!endpoint) return 0;
+  return usbGetOutputDelay(channel->device, endpoint);
+}
+
 static int
 awaitUsbInput (GioHandle *handle, int timeout) {
   UsbChannel *channel = handle->channel;
@@ -273,6 +282,7 @@ static const GioHandleMethods gioUsbMethods = {
   .getResourceObject = getUsbResourceObject,
 
   .writeData = writeUsbData,
+  .getOutputDelay = getUsbOutputDelay,
   .awaitInput = awaitUsbInput,
   .readData = readUsbData,
   .monitorInput = monitorUsbInput,
@@ -347,6 +357,12 @@ connectUsbResource (
 
       if (!properties->inputFilter ||
           usbAddInputFilter(channel->device, properties->inputFilter)) {
+        if (descriptor->usb.options.lowLatency) {
+          if (usbGetSerialOperations(channel->device)) {
+            usbSetSerialLatency(channel->device, SERIAL_LATENCY_LOW);
+          }
+        }
+
         return handle;
       }
 
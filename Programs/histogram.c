@@ -0,0 +1,109 @@
+/*
+ * BRLTTY - A background process providing access to the console screen (when in
+ *          text mode) for a blind person using a refreshable braille display.
+ *
+ * Copyright (C) 1995-2026 by The BRLTTY Developers.
+ *
+ * BRLTTY comes with ABSOLUTELY NO WARRANTY.
+ *
+ * This is free software, placed under the terms of the
+ * GNU Lesser General Public License, as published by the Free Software
+ * Foundation; either version 2.1 of the License, or (at your option) any
+ * later version. Please see the file LICENSE-LGPL for details.
+ *
+ * Web Page: http://brltty.app/
+ *
+ * This software is maintained by Dave Mielke <dave@mielke.cc>.
+ */
+
+
+#include "prologue.h"
+
+#include <string.h>
+
+#include "histogram.h"
+#include "strfmt.h"
+
+void
+resetHistogram (Histogram *histogram) {
+  memset(histogram, 0, sizeof(*histogram));
+}
+
+static unsigned int
+getBucketIndex (uint32_t value) {
+  if (value < HISTOGRAM_SUB_BUCKETS) return value;
+
+  unsigned int msb = 31;
+  while (!(value & (UINT32_C(1) << msb))) msb -= 1;
+
+  unsigned int shift = msb - HISTOGRAM_SUB_BUCKET_BITS;
+  unsigned int sub = (value >> shift) & (HISTOGRAM_SUB_BUCKETS - 1);
+  return ((shift + 1) << HISTOGRAM_SUB_BUCKET_BITS) + sub;
+}
+
+static uint64_t
+getBucketLimit (unsigned int index) {
+  if (index < HISTOGRAM_SUB_BUCKETS) return index;
+
+  unsigned int shift = (index >> HISTOGRAM_SUB_BUCKET_BITS) - 1;
+  unsigned int sub = index & (HISTOGRAM_SUB_BUCKETS - 1);
+  uint64_t base = HISTOGRAM_SUB_BUCKETS + sub;
+  return ((base + 1) << shift) - 1;
+}
+
+void
+addHistogramValue (Histogram *histogram, uint32_t value) {
+  histogram->buckets[getBucketIndex(value)] += 1;
+
+  if (!histogram->count++) {
+    histogram->minimum = histogram->maximum = value;
+  } else if (value < histogram->minimum) {
+    histogram->minimum = value;
+  } else if (value > histogram->maximum) {
+    histogram->maximum = value;
+  }
+
+  histogram->sum += value;
+}
+
+uint32_t
+getHistogramMean (const Histogram *histogram) {
+  if (!histogram->count) return 0;
+  return histogram->sum / histogram->count;
+}
+
+uint32_t
+getHistogramPercentile (const Histogram *histogram, unsigned int percent) {
+  if (!histogram->count) return 0;
+  if (percent >= 100) return histogram->maximum;
+
+  uint64_t threshold = ((histogram->count * percent) + 99) / 100;
+  if (!threshold) threshold = 1;
+  uint64_t count = 0;
+
+  for (unsigned int index=0; index<HISTOGRAM_BUCKET_COUNT; index+=1) {
+    if ((count += histogram->buckets[index]) >= threshold) {
+      uint64_t limit = getBucketLimit(index);
+      if (limit > histogram->maximum) limit = histogram->maximum;
+      if (limit < histogram->minimum) limit = histogram->minimum;
+      return limit;
+    }
+  }
+
+  return histogram->maximum;
+}
+
+STR_BEGIN_FORMATTER(formatHistogram, const Histogram *histogram)
+  STR_PRINTF("n=%"PRIu64, histogram->count);
+
+  if (histogram->count) {
+    STR_PRINTF(
+      " min=%"PRIu32" mean=%"PRIu32" p50=%"PRIu32" p90=%"PRIu32" p99=%"PRIu32" max=%"PRIu32,
+      histogram->minimum, getHistogramMean(histogram),
+      getHistogramPercentile(histogram, 50),
+      getHistogramPercentile(histogram, 90),
+      getHistogramPercentile(histogram, 99),
+      histogram->maximum
+    );
+  }
+STR_END_FORMATTER
@@ -167,6 +167,12 @@ static const LogCategoryEntry logCategoryTable[LOG_CATEGORY_COUNT] = {
     .title = strtext("Screen Driver Events"),
     .prefix = "screen driver"
   },
+
+  [LOG_CATEGORY_INDEX(PERFORMANCE)] = {
+    .name = "perf",
+    .title = strtext("Performance Statistics"),
+    .prefix = "performance"
+  },
 };
 
 unsigned char categoryLogLevel = LOG_WARNING;
@@ -47,6 +47,7 @@
 #include "midi.h"
 #include "options.h"
 #include "core.h"
+#include "pkt_capture.h"
 
 #define PREFS_MENU_ITEM_VARIABLE(name) prefsMenuItemVariable_##name
 #define PREFS_MENU_ITEM_GETTER_DECLARE(name) \
@@ -515,6 +516,18 @@ testKeyboardTable (void) {
   return !!keyboardTable;
 }
 
+static unsigned char capturePackets;
+
+static int
+testCapturePackets (void) {
+  return opt_packetCapture && *opt_packetCapture;
+}
+
+static int
+changedCapturePackets (const MenuItem *item UNUSED, unsigned char setting) {
+  return setting? resumePacketCapture(): suspendPacketCapture();
+}
+
 static MenuItem *
 newProfileMenuItem (Menu *menu, const ProfileDescriptor *profile) {
   MenuString name = {.label = profile->category};
@@ -1758,6 +1771,11 @@ makePreferencesMenu (void) {
       ITEM(newStringOptionMenuItem(optionsSubmenu, &itemName, &opt_logFile));
     }
 
+    {
+      NAME(strtext("Packet Capture"));
+      ITEM(newStringOptionMenuItem(optionsSubmenu, &itemName, &opt_packetCapture));
+    }
+
     {
       NAME(strtext("Log to Standard Error"));
       ITEM(newFlagOptionMenuItem(optionsSubmenu, &itemName, &opt_logToStandardError));
@@ -1841,6 +1859,14 @@ makePreferencesMenu (void) {
       ITEM(newEnumeratedMenuItem(logSettingsSubmenu, &categoryLogLevel, &itemName, logLevelNames));
     }
 
+    {
+      NAME(strtext("Capture Packets"));
+      capturePackets = isCapturingPackets();
+      ITEM(newBooleanMenuItem(logSettingsSubmenu, &capturePackets, &itemName));
+      TEST(CapturePackets);
+      CHANGED(CapturePackets);
+    }
+
     {
       SUBMENU(logCategoriesSubmenu, logSettingsSubmenu, strtext("Log Categories"));
       setAdvancedSubmenu(logCategoriesSubmenu);
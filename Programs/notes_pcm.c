@@ -21,14 +21,52 @@
 #include <string.h>
 #include <errno.h>
 
+#include "parameters.h"
 #include "prefs.h"
 #include "log.h"
+#include "timing.h"
 #include "pcm.h"
 #include "notes.h"
 #include "options.h"
 
 char *opt_pcmDevice = "";
 
+/* A rendered tone: its frames are already in the device's amplitude format
+ * and interleaved for all of its channels. A tone always starts at the same
+ * phase, so its frames only depend on these three values.
+ */
+typedef struct {
+  uint32_t stepsPerSample;
+  int32_t sampleCount;
+  int32_t maximumAmplitude;
+
+  size_t size;
+  unsigned char bytes[];
+} PcmToneEntry;
+
+/* A rendered tune: exactly what its tones would have written, including
+ * the silence which pads the final block, so that it can be written to
+ * the device all at once. It's only valid for the format and volume it
+ * was rendered for.
+ */
+typedef struct {
+  int sampleRate;
+  int channelCount;
+  PcmAmplitudeFormat amplitudeFormat;
+  int blockSize;
+  unsigned char volume;
+
+  ToneElement *tones;
+  size_t toneCount;
+
+  unsigned char *bytes;
+  size_t size;
+} PcmTuneEntry;
+
+static PcmTuneEntry *pcmTuneCache[PCM_TUNE_CACHE_SIZE];
+static PcmTuneReport pcmTuneReport;
+static unsigned char havePcmTuneReport = 0;
+
 struct NoteDeviceStruct {
   PcmDevice *pcm;
 
@@ -41,31 +79,85 @@ struct NoteDeviceStruct {
   int blockUsed;
 
   PcmSampleMaker makeSample;
+  PcmSampleSize sampleSize;
+  unsigned int frameSize;
+
+  unsigned char *silenceAddress;
+
+  struct {
+    PcmToneEntry *entries[PCM_TONE_CACHE_SIZE];
+    unsigned int next;
+  } toneCache;
+
+  struct {
+    unsigned char *bytes;
+    size_t size;
+    size_t allocated;
+    unsigned active:1;
+  } capture;
 };
 
+static int
+pcmCaptureBytes (NoteDevice *device) {
+  size_t size = device->capture.size + device->blockUsed;
+
+  if (size > device->capture.allocated) {
+    size_t allocated = MAX(size, (device->capture.allocated * 2));
+    unsigned char *bytes = realloc(device->capture.bytes, allocated);
+
+    if (!bytes) {
+      logMallocError();
+      return 0;
+    }
+
+    device->capture.bytes = bytes;
+    device->capture.allocated = allocated;
+  }
+
+  memcpy(&device->capture.bytes[device->capture.size],
+         device->blockAddress, device->blockUsed);
+  device->capture.size = size;
+  return 1;
+}
+
 static int
 pcmFlushBytes (NoteDevice *device) {
-  int ok = writePcmData(device->pcm, device->blockAddress, device->blockUsed);
+  int ok = device->capture.active?
+           pcmCaptureBytes(device):
+           writePcmData(device->pcm, device->blockAddress, device->blockUsed);
+
   if (ok) device->blockUsed = 0;
   return ok;
 }
 
 static int
-pcmWriteSample (NoteDevice *device, int16_t amplitude) {
-  PcmSample *sample = (PcmSample *)&device->blockAddress[device->blockUsed];
-  PcmSampleSize size = device->makeSample(sample, amplitude);
-  device->blockUsed += size;
-
-  for (int channel=1; channel<device->channelCount; channel+=1) {
-    for (int byte=0; byte<size; byte+=1) {
-      device->blockAddress[device->blockUsed++] = sample->bytes[byte];
+pcmWriteBytes (NoteDevice *device, const unsigned char *bytes, size_t count) {
+  while (count > 0) {
+    size_t size = MIN(count, (device->blockSize - device->blockUsed));
+
+    memcpy(&device->blockAddress[device->blockUsed], bytes, size);
+    device->blockUsed += size;
+    bytes += size;
+    count -= size;
+
+    if (device->blockUsed == device->blockSize) {
+      if (!pcmFlushBytes(device)) {
+        return 0;
+      }
     }
   }
 
-  if (device->blockUsed == device->blockSize) {
-    if (!pcmFlushBytes(device)) {
-      return 0;
-    }
+  return 1;
+}
+
+static int
+pcmWriteSilence (NoteDevice *device, size_t count) {
+  count *= device->frameSize;
+
+  while (count > 0) {
+    size_t size = MIN(count, device->blockSize);
+    if (!pcmWriteBytes(device, device->silenceAddress, size)) return 0;
+    count -= size;
   }
 
   return 1;
@@ -73,13 +165,126 @@ pcmWriteSample (NoteDevice *device, int16_t amplitude) {
 
 static int
 pcmFlushBlock (NoteDevice *device) {
-  while (device->blockUsed)
-    if (!pcmWriteSample(device, 0))
+  if (device->blockUsed) {
+    if (!pcmWriteBytes(device, device->silenceAddress,
+                       (device->blockSize - device->blockUsed))) {
       return 0;
+    }
+  }
 
   return 1;
 }
 
+static void
+pcmMakeFrame (NoteDevice *device, unsigned char *frame, int16_t amplitude) {
+  PcmSample sample;
+  device->makeSample(&sample, amplitude);
+
+  for (int channel=0; channel<device->channelCount; channel+=1) {
+    memcpy(frame, sample.bytes, device->sampleSize);
+    frame += device->sampleSize;
+  }
+}
+
+static void
+pcmRenderTone (
+  NoteDevice *device, unsigned char *frames, int32_t count,
+  int32_t *currentValue, uint32_t stepsPerSample, int32_t maximumAmplitude
+) {
+  /* See pcmTone for how the triangle waveform is laid out. */
+  const uint8_t magnitudeWidth = 32 - 2;
+  const uint32_t zeroValue = UINT32_C(1) << magnitudeWidth;
+
+  while (count > 0) {
+    /* Convert the current 32-bit unsigned linear value to a 31-bit
+     * triangular amplitude by inverting its low-order 31 bits if its
+     * high-order (sign) bit is set.
+     */
+    int32_t amplitude = *currentValue ^ (*currentValue >> 31);
+
+    /* Convert the 31-bit amplitude from unsigned to signed. */
+    amplitude -= zeroValue;
+
+    /* Convert the amplitude's magnitude from 30 bits to 16 bits. */
+    amplitude >>= magnitudeWidth - 16;
+
+    /* Adjust the 17-bit signed amplitude (sign bit + 16-bit value) by
+     * the currently set volume (15-bit value):
+     * (16-bit value) * (15-bit value) + (sign bit) = 32-bit signed value
+     */
+    amplitude *= maximumAmplitude;
+
+    /* Convert the signed amplitude from 32 bits to 16 bits. */
+    amplitude >>= 16;
+
+    pcmMakeFrame(device, frames, amplitude);
+    frames += device->frameSize;
+
+    *currentValue += stepsPerSample;
+    count -= 1;
+  }
+}
+
+static const PcmToneEntry *
+pcmGetTone (
+  NoteDevice *device, int32_t sampleCount,
+  int32_t startValue, uint32_t stepsPerSample, int32_t maximumAmplitude
+) {
+  for (unsigned int index=0; index<ARRAY_COUNT(device->toneCache.entries); index+=1) {
+    const PcmToneEntry *tone = device->toneCache.entries[index];
+    if (!tone) break;
+
+    if (tone->stepsPerSample != stepsPerSample) continue;
+    if (tone->sampleCount != sampleCount) continue;
+    if (tone->maximumAmplitude != maximumAmplitude) continue;
+    return tone;
+  }
+
+  size_t size = sampleCount * device->frameSize;
+  if (size > PCM_TONE_CACHE_LIMIT) return NULL;
+
+  PcmToneEntry *tone;
+
+  if (!(tone = malloc(sizeof(*tone) + size))) {
+    logMallocError();
+    return NULL;
+  }
+
+  tone->stepsPerSample = stepsPerSample;
+  tone->sampleCount = sampleCount;
+  tone->maximumAmplitude = maximumAmplitude;
+  tone->size = size;
+
+  int32_t currentValue = startValue;
+  pcmRenderTone(device, tone->bytes, sampleCount,
+                &currentValue, stepsPerSample, maximumAmplitude);
+
+  {
+    PcmToneEntry **entry = &device->toneCache.entries[device->toneCache.next];
+    if (*entry) free(*entry);
+    *entry = tone;
+
+    device->toneCache.next += 1;
+    device->toneCache.next %= ARRAY_COUNT(device->toneCache.entries);
+  }
+
+  return tone;
+}
+
+static void
+pcmClearToneCache (NoteDevice *device) {
+  for (unsigned int index=0; index<ARRAY_COUNT(device->toneCache.entries); index+=1) {
+    PcmToneEntry **entry = &device->toneCache.entries[index];
+
+    if (*entry) {
+      free(*entry);
+      *entry = NULL;
+    }
+  }
+
+  device->toneCache.next = 0;
+}
+
 static NoteDevice *
 pcmConstruct (int errorLevel) {
   NoteDevice *device;
@@ -97,15 +302,26 @@ pcmConstruct (int errorLevel) {
       device->makeSample = getPcmSampleMaker(device->amplitudeFormat);
 
       PcmSample sample;
-      PcmSampleSize sampleSize = device->makeSample(&sample, 0);
-      sampleSize *= device->channelCount;
+      device->sampleSize = device->makeSample(&sample, 0);
+      device->frameSize = device->sampleSize * device->channelCount;
+      unsigned int sampleSize = device->frameSize;
 
       if (sampleSize && device->blockSize &&
           !(device->blockSize % sampleSize)) {
         if ((device->blockAddress = malloc(device->blockSize))) {
-          logMessage(LOG_DEBUG, "PCM enabled: BlkSz:%d Rate:%d ChnCt:%d Fmt:%d",
-                     device->blockSize, device->sampleRate, device->channelCount, device->amplitudeFormat);
-          return device;
+          if ((device->silenceAddress = malloc(device->blockSize))) {
+            for (int offset=0; offset<device->blockSize; offset+=sampleSize) {
+              pcmMakeFrame(device, &device->silenceAddress[offset], 0);
+            }
+
+            logMessage(LOG_DEBUG, "PCM enabled: BlkSz:%d Rate:%d ChnCt:%d Fmt:%d",
+                       device->blockSize, device->sampleRate, device->channelCount, device->amplitudeFormat);
+            return device;
+          } else {
+            logMallocError();
+          }
+
+          free(device->blockAddress);
         } else {
           logMallocError();
         }
@@ -128,9 +344,15 @@ pcmConstruct (int errorLevel) {
   return NULL;
 }
 
+static void pcmClearTuneCache (void);
+
 static void
 pcmDestruct (NoteDevice *device) {
   pcmFlushBlock(device);
+  pcmClearToneCache(device);
+  pcmClearTuneCache();
+  free(device->capture.bytes);
+  free(device->silenceAddress);
   free(device->blockAddress);
   closePcmDevice(device->pcm);
   free(device);
@@ -211,41 +433,40 @@ pcmTone (NoteDevice *device, unsigned int duration, NoteFrequency frequency) {
      */
     sampleCount += (uint32_t)(sampleCount * -stepsPerSample) / stepsPerSample;
 
+    /* Alert tunes reuse a small set of tones, so whole tones are rendered
+     * once into the device's format and then copied into the PCM blocks.
+     * A single period can't be reused because, in general, a period isn't
+     * a whole number of samples.
+     */
+    const PcmToneEntry *tone = pcmGetTone(device, sampleCount,
+                                          currentValue, stepsPerSample,
+                                          maximumAmplitude);
+
+    if (tone) return pcmWriteBytes(device, tone->bytes, tone->size);
+
+    /* too long to be cached - render it directly into the PCM blocks */
     while (sampleCount > 0) {
-      /* Convert the current 32-bit unsigned linear value to a 31-bit
-       * triangular amplitude by inverting its low-order 31 bits if its
-       * high-order (sign) bit is set.
-       */
-      int32_t amplitude = currentValue ^ (currentValue >> 31);
-
-      /* Convert the 31-bit amplitude from unsigned to signed. */
-      amplitude -= zeroValue;
-
-      /* Convert the amplitude's magnitude from 30 bits to 16 bits. */
-      amplitude >>= magnitudeWidth - 16;
-
-      /* Adjust the 17-bit signed amplitude (sign bit + 16-bit value) by
-       * the currently set volume (15-bit value):
-       * (16-bit value) * (15-bit value) + (sign bit) = 32-bit signed value
-       */
-      amplitude *= maximumAmplitude;
-
-      /* Convert the signed amplitude from 32 bits to 16 bits. */
-      amplitude >>= 16;
-
-      if (!pcmWriteSample(device, amplitude)) break;
-      currentValue += stepsPerSample;
-      sampleCount -= 1;
-    }
-  } else {
-    /* generate silence */
-    while (sampleCount > 0) {
-      if (!pcmWriteSample(device, 0)) break;
-      sampleCount -= 1;
+      int32_t count = (device->blockSize - device->blockUsed) / device->frameSize;
+      count = MIN(count, sampleCount);
+
+      pcmRenderTone(device, &device->blockAddress[device->blockUsed], count,
+                    &currentValue, stepsPerSample, maximumAmplitude);
+
+      device->blockUsed += count * device->frameSize;
+      sampleCount -= count;
+
+      if (device->blockUsed == device->blockSize) {
+        if (!pcmFlushBytes(device)) {
+          return 0;
+        }
+      }
     }
+
+    return 1;
   }
 
-  return (sampleCount > 0) ? 0 : 1;
+  /* generate silence */
+  return pcmWriteSilence(device, sampleCount);
 }
 
 static int
@@ -260,11 +481,213 @@ pcmFlush (NoteDevice *device) {
   return ok;
 }
 
+static void
+pcmCancel (NoteDevice *device) {
+  device->blockUsed = 0;
+  cancelPcmOutput(device->pcm);
+}
+
+static int
+testPcmTune (
+  const PcmTuneEntry *tune, NoteDevice *device, unsigned char volume,
+  const ToneElement *tones, size_t toneCount
+) {
+  if (tune->sampleRate != device->sampleRate) return 0;
+  if (tune->channelCount != device->channelCount) return 0;
+  if (tune->amplitudeFormat != device->amplitudeFormat) return 0;
+  if (tune->blockSize != device->blockSize) return 0;
+  if (tune->volume != volume) return 0;
+
+  if (tune->toneCount != toneCount) return 0;
+
+  for (size_t index=0; index<toneCount; index+=1) {
+    const ToneElement *tone = &tune->tones[index];
+    if (tone->duration != tones[index].duration) return 0;
+    if (tone->frequency != tones[index].frequency) return 0;
+  }
+
+  return 1;
+}
+
+static void
+pcmDeallocateTune (PcmTuneEntry *tune) {
+  free(tune->bytes);
+  free(tune->tones);
+  free(tune);
+}
+
+static PcmTuneEntry *
+pcmFindTune (
+  NoteDevice *device, unsigned char volume,
+  const ToneElement *tones, size_t toneCount
+) {
+  for (unsigned int index=0; index<ARRAY_COUNT(pcmTuneCache); index+=1) {
+    PcmTuneEntry *tune = pcmTuneCache[index];
+    if (!tune) break;
+
+    if (testPcmTune(tune, device, volume, tones, toneCount)) {
+      /* move it to the front so that the least recently used one is last */
+      memmove(&pcmTuneCache[1], &pcmTuneCache[0], (index * sizeof(pcmTuneCache[0])));
+      pcmTuneCache[0] = tune;
+      return tune;
+    }
+  }
+
+  return NULL;
+}
+
+static void
+pcmClearTuneCache (void) {
+  for (unsigned int index=0; index<ARRAY_COUNT(pcmTuneCache); index+=1) {
+    PcmTuneEntry **tune = &pcmTuneCache[index];
+
+    if (*tune) {
+      pcmDeallocateTune(*tune);
+      *tune = NULL;
+    }
+  }
+}
+
+static void
+pcmAddTune (PcmTuneEntry *tune) {
+  PcmTuneEntry **last = &pcmTuneCache[ARRAY_COUNT(pcmTuneCache) - 1];
+  if (*last) pcmDeallocateTune(*last);
+
+  memmove(&pcmTuneCache[1], &pcmTuneCache[0], (last - pcmTuneCache) * sizeof(*last));
+  pcmTuneCache[0] = tune;
+}
+
+static PcmTuneEntry *
+pcmRenderTune (
+  NoteDevice *device, unsigned char volume,
+  const ToneElement *tones, size_t toneCount
+) {
+  PcmTuneEntry *tune;
+
+  if ((tune = malloc(sizeof(*tune)))) {
+    memset(tune, 0, sizeof(*tune));
+
+    tune->sampleRate = device->sampleRate;
+    tune->channelCount = device->channelCount;
+    tune->amplitudeFormat = device->amplitudeFormat;
+    tune->blockSize = device->blockSize;
+    tune->volume = volume;
+    tune->toneCount = toneCount;
+
+    if ((tune->tones = malloc(toneCount * sizeof(*tones)))) {
+      memcpy(tune->tones, tones, (toneCount * sizeof(*tones)));
+
+      /* let the tones write their blocks into memory instead of to the device */
+      int ok = 1;
+      device->capture.size = 0;
+      device->capture.active = 1;
+
+      for (const ToneElement *tone=tones; tone->duration; tone+=1) {
+        if (!pcmTone(device, tone->duration, tone->frequency)) {
+          ok = 0;
+          break;
+        }
+      }
+
+      if (ok) ok = pcmFlushBlock(device);
+      device->capture.active = 0;
+
+      if (ok) {
+        if ((tune->bytes = malloc(device->capture.size))) {
+          memcpy(tune->bytes, device->capture.bytes, device->capture.size);
+          tune->size = device->capture.size;
+          return tune;
+        } else {
+          logMallocError();
+        }
+      }
+
+      device->blockUsed = 0;
+    } else {
+      logMallocError();
+    }
+
+    pcmDeallocateTune(tune);
+  } else {
+    logMallocError();
+  }
+
+  return NULL;
+}
+
+static int
+pcmTones (
+  NoteDevice *device, const ToneElement *tones,
+  NoteTonesProgress *progress, void *data
+) {
+  /* any partially filled block would have to be written first */
+  if (device->blockUsed) return -1;
+
+  size_t toneCount = 0;
+  size_t sampleCount = 0;
+
+  for (const ToneElement *tone=tones; tone->duration; tone+=1) {
+    toneCount += 1;
+    sampleCount += device->sampleRate * tone->duration / 1000;
+  }
+
+  /* a long tune (e.g. a song) is streamed rather than rendered first */
+  if ((sampleCount * device->frameSize) > PCM_TUNE_CACHE_LIMIT) return -1;
+
+  const unsigned char volume = MIN(100, prefs.pcmVolume);
+  PcmTuneEntry *tune = pcmFindTune(device, volume, tones, toneCount);
+  unsigned long int renderTime = 0;
+
+  if (!tune) {
+    TimeValue start;
+    TimeValue end;
+
+    getMonotonicTime(&start);
+    tune = pcmRenderTune(device, volume, tones, toneCount);
+    getMonotonicTime(&end);
+
+    if (!tune) return 0;
+    renderTime = microsecondsBetween(&start, &end);
+    pcmAddTune(tune);
+  }
+
+  pcmTuneReport.bufferSize = tune->size;
+  pcmTuneReport.renderTime = renderTime;
+  havePcmTuneReport = 1;
+
+  /* write it a block at a time so that it can still be superseded */
+  const unsigned char *bytes = tune->bytes;
+  size_t count = tune->size;
+
+  while (count > 0) {
+    size_t size = MIN(count, device->blockSize);
+
+    if (!writePcmData(device->pcm, bytes, size)) return 0;
+    bytes += size;
+    count -= size;
+
+    if (!progress(data)) return 0;
+  }
+
+  return 1;
+}
+
+int
+getPcmTuneReport (PcmTuneReport *report) {
+  if (!havePcmTuneReport) return 0;
+  havePcmTuneReport = 0;
+
+  *report = pcmTuneReport;
+  return 1;
+}
+
 const NoteMethods pcmNoteMethods = {
   .construct = pcmConstruct,
   .destruct = pcmDestruct,
 
   .tone = pcmTone,
   .note = pcmNote,
-  .flush = pcmFlush
+  .flush = pcmFlush,
+  .cancel = pcmCancel,
+  .tones = pcmTones
 };
@@ -63,6 +63,7 @@ extern char *opt_pcmDevice;
 extern char *opt_midiDevice;
 
 extern char *opt_logFile;
+extern char *opt_packetCapture;
 extern int opt_logToStandardError;
 
 extern char *opt_pidFile;
@@ -34,6 +34,8 @@ extern "C" {
 
 #define BRAILLE_MESSAGE_ACKNOWLEDGEMENT_TIMEOUT 1000
 #define BRAILLE_MESSAGE_UNACKNOWLEDGEED_LIMIT 5
+#define BRAILLE_MESSAGE_WINDOW_SIZE 1
+#define BRAILLE_PROBE_CANCEL_CHECK_INTERVAL 50
 
 #define SPEECH_DRIVER_START_RETRY_INTERVAL 5000
 #define SPEECH_DRIVER_START_AUTOSPEAK_DELAY 4000
@@ -42,6 +44,15 @@ extern "C" {
 #define SPEECH_DRIVER_THREAD_STOP_TIMEOUT 5000
 
 #define SPEECH_RESPONSE_WAIT_TIMEOUT 5000
+#define SPEECH_UTTERANCE_TRACKING_LIMIT 0X10
+#define SPEECH_THROUGHPUT_MINIMUM_DURATION 200
+
+#define SPEECH_REQUEST_RING_SIZE 4 /* must be a power of two */
+#define SPEECH_REQUEST_SIGNAL_ATTEMPTS 3
+#define SPEECH_MESSAGE_RING_SIZE 0X40 /* must be a power of two */
+#define SPEECH_MESSAGE_STALL_TIMEOUT 1000
+#define SPEECH_REQUEST_POOL_SIZE 4
+#define SPEECH_REQUEST_SLOT_SIZE 0X200
 
 #define SCREEN_DRIVER_START_RETRY_INTERVAL 5000
 #define SCREEN_FREEZE_REMINDER_INTERVAL 30000
@@ -53,6 +64,8 @@ extern "C" {
 #define PID_FILE_CREATE_RETRY_INTERVAL 5000
 
 #define UPDATE_SCHEDULE_DELAY 5
+#define UPDATE_WINDOW_REWRITE_INTERVAL 5000
+#define UPDATE_FRAME_INTERVAL 40
 
 #define ROUTING_PROCESS_NICENESS 10
 #define ROUTING_POLL_INTERVAL 1
@@ -61,6 +74,15 @@ extern "C" {
 #define TUNE_DEVICE_CLOSE_DELAY 2000
 #define TUNE_TOGGLE_REPEAT_DELAY 100
 
+#define PCM_TONE_CACHE_SIZE 8
+#define PCM_TONE_CACHE_LIMIT 0X10000
+#define PCM_TUNE_CACHE_SIZE 0X10
+#define PCM_TUNE_CACHE_LIMIT 0X40000
+
+#define PCM_ALSA_BUFFER_TIME 100000
+#define PCM_ALSA_PERIOD_COUNT 4
+#define PCM_ALSA_WRITE_TIMEOUT 1000
+
 #define MESSAGE_HOLD_TIMEOUT 4000
 
 #define LEARN_MODE_TIMEOUT 10000
@@ -75,10 +97,18 @@ extern "C" {
 
 #define SERIAL_DEVICE_RESTART_DELAY 500
 
+#define USB_SERIAL_FTDI_LATENCY_DEFAULT 16
+#define USB_SERIAL_FTDI_LATENCY_LOW 1
+
 #define USB_INPUT_AWAIT_RETRY_INTERVAL_MINIMUM 10
 #define USB_INPUT_READ_INITIAL_TIMEOUT_DEFAULT 20
 #define USB_INPUT_INTERRUPT_DELAY_MAXIMUM 16
+#define USB_INPUT_INTERRUPT_REQUESTS_MINIMUM 2
 #define USB_INPUT_INTERRUPT_REQUESTS_MAXIMUM 8
+#define USB_INPUT_REQUEST_WINDOW 40
+#define USB_INPUT_IDLE_INTERVAL 1000
+#define USB_OUTPUT_AWAIT_RETRY_INTERVAL 1
+#define USB_OUTPUT_DRAIN_TIMEOUT 1000
 
 #define BLUETOOTH_DEVICE_NAME_OBTAIN_TIMEOUT 5000
 #define BLUETOOTH_CHANNEL_BUSY_RETRY_TIMEOUT 2000
@@ -89,6 +119,7 @@ extern "C" {
 #define LINUX_USB_INPUT_PIPE_DISABLE 0
 #define LINUX_USB_INPUT_USE_SIGNAL_MONITOR 0
 #define LINUX_USB_INPUT_TREAT_INTERRUPT_AS_BULK 0
+#define LINUX_USB_INPUT_REAP_LIMIT 16
 #define LINUX_BLUETOOTH_NAME_OBTAIN_ASYNCHRONOUS 1
 #define LINUX_BLUETOOTH_CHANNEL_DISCOVER_ASYNCHRONOUS 1
 #define LINUX_BLUETOOTH_CHANNEL_CONNECT_ASYNCHRONOUS 1
@@ -22,6 +22,7 @@
 #include <alsa/asoundlib.h>
 
 #include "log.h"
+#include "parameters.h"
 #include "timing.h"
 #include "pcm.h"
 
@@ -134,17 +135,15 @@ openPcmDevice (int errorLevel, const char *device) {
 
     if (!*device) device = "default";
     if ((result = snd_pcm_open(&pcm->handle, device, SND_PCM_STREAM_PLAYBACK, SND_PCM_NONBLOCK)) >= 0) {
-      snd_pcm_nonblock(pcm->handle, 0);
-
       if ((result = snd_pcm_hw_params_malloc(&pcm->hardwareParameters)) >= 0) {
         if ((result = snd_pcm_hw_params_any(pcm->handle, pcm->hardwareParameters)) >= 0) {
           if ((result = snd_pcm_hw_params_set_access(pcm->handle, pcm->hardwareParameters, SND_PCM_ACCESS_RW_INTERLEAVED)) >= 0) {
             if (configurePcmSampleFormat(pcm, errorLevel)) {
               if (configurePcmSampleRate(pcm, errorLevel)) {
                 if (configurePcmChannelCount(pcm, errorLevel)) {
-                  pcm->bufferTime = 500000;
+                  pcm->bufferTime = PCM_ALSA_BUFFER_TIME;
                   if ((result = snd_pcm_hw_params_set_buffer_time_near(pcm->handle, pcm->hardwareParameters, &pcm->bufferTime, NULL)) >= 0) {
-                    pcm->periodTime = pcm->bufferTime / 8;
+                    pcm->periodTime = pcm->bufferTime / PCM_ALSA_PERIOD_COUNT;
                     if ((result = snd_pcm_hw_params_set_period_time_near(pcm->handle, pcm->hardwareParameters, &pcm->periodTime, NULL)) >= 0) {
                       if ((result = snd_pcm_hw_params(pcm->handle, pcm->hardwareParameters)) >= 0) {
                         logMessage(LOG_DEBUG, "ALSA PCM: Chan=%u Rate=%u BufTim=%u PerTim=%u", pcm->channelCount, pcm->sampleRate, pcm->bufferTime, pcm->periodTime);
@@ -212,6 +211,17 @@ writePcmData (PcmDevice *pcm, const unsigned char *buffer, int count) {
       buffer += result * frameSize;
     } else {
       switch (result) {
+        case 0:
+        case -EAGAIN:
+          /* the buffer is full - wait (but not forever) for room */
+          if ((result = snd_pcm_wait(pcm->handle, PCM_ALSA_WRITE_TIMEOUT)) == 0) {
+            logMessage(LOG_WARNING, "ALSA PCM write timeout");
+            return 0;
+          }
+
+          /* an xrun or suspend is reported by the next write */
+          continue;
+
         case -EPIPE:
           if ((result = snd_pcm_prepare(pcm->handle)) < 0) {
             logPcmError(LOG_WARNING, "underrun recovery - prepare", result);
@@ -231,6 +241,10 @@ writePcmData (PcmDevice *pcm, const unsigned char *buffer, int count) {
           }
           continue;
 #endif /* ESTRPIPE != EPIPE */
+
+        default:
+          logPcmError(LOG_WARNING, "write", result);
+          return 0;
       }
     }
   }
@@ -341,11 +355,18 @@ pushPcmOutput (PcmDevice *pcm) {
 void
 awaitPcmOutput (PcmDevice *pcm) {
   int result;
+
+  /* draining is only synchronous in blocking mode */
+  snd_pcm_nonblock(pcm->handle, 0);
   if ((result = snd_pcm_drain(pcm->handle)) < 0) logPcmError(LOG_WARNING, "drain", result);
+  snd_pcm_nonblock(pcm->handle, 1);
 }
 
 void
 cancelPcmOutput (PcmDevice *pcm) {
   int result;
   if ((result = snd_pcm_drop(pcm->handle)) < 0) logPcmError(LOG_WARNING, "drop", result);
+
+  /* leave the device ready for the next write */
+  if ((result = snd_pcm_prepare(pcm->handle)) < 0) logPcmError(LOG_WARNING, "prepare", result);
 }
@@ -0,0 +1,459 @@
+/*
+ * BRLTTY - A background process providing access to the console screen (when in
+ *          text mode) for a blind person using a refreshable braille display.
+ *
+ * Copyright (C) 1995-2026 by The BRLTTY Developers.
+ *
+ * BRLTTY comes with ABSOLUTELY NO WARRANTY.
+ *
+ * This is free software, placed under the terms of the
+ * GNU Lesser General Public License, as published by the Free Software
+ * Foundation; either version 2.1 of the License, or (at your option) any
+ * later version. Please see the file LICENSE-LGPL for details.
+ *
+ * Web Page: http://brltty.app/
+ *
+ * This software is maintained by Dave Mielke <dave@mielke.cc>.
+ */
+
+#include "prologue.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+
+#include "log.h"
+#include "pkt_capture.h"
+#include "timing.h"
+#include "lock.h"
+
+typedef struct {
+  const void *object;
+  char *identifier;
+} PacketCaptureChannel;
+
+static struct {
+  FILE *stream;
+  char *path;
+
+  size_t fileSize;
+  unsigned int fileCount;
+  size_t bytesWritten;
+
+  TimeValue previousTime;
+
+  PacketCaptureChannel channels[0XFF];
+  unsigned int channelCount;
+} pcs = {
+  .stream = NULL
+};
+
+static LockDescriptor *
+getPacketCaptureLock (void) {
+  static LockDescriptor *lock = NULL;
+
+  return getLockDescriptor(&lock, "packet-capture");
+}
+
+static int
+lockPacketCapture (void) {
+  LockDescriptor *lock = getPacketCaptureLock();
+  if (!lock) return 0;
+
+  obtainExclusiveLock(lock);
+  return 1;
+}
+
+static void
+unlockPacketCapture (void) {
+  LockDescriptor *lock = getPacketCaptureLock();
+  if (lock) releaseLock(lock);
+}
+
+static unsigned char *
+putInteger (unsigned char *target, uint64_t value, size_t size) {
+  while (size--) {
+    *target++ = value & UINT8_MAX;
+    value >>= 8;
+  }
+
+  return target;
+}
+
+static unsigned char *
+putVarint (unsigned char *target, uint64_t value) {
+  while (value > 0X7F) {
+    *target++ = (value & 0X7F) | 0X80;
+    value >>= 7;
+  }
+
+  *target++ = value;
+  return target;
+}
+
+static int
+writeCaptureBytes (const void *bytes, size_t count) {
+  if (fwrite(bytes, 1, count, pcs.stream) != count) {
+    logSystemError("packet capture write");
+    return 0;
+  }
+
+  pcs.bytesWritten += count;
+  return 1;
+}
+
+static int
+writeCaptureRecord (
+  PacketCaptureRecordType type, unsigned char channel,
+  const TimeValue *now, const void *data, size_t size
+) {
+  if (size > UINT16_MAX) size = UINT16_MAX;
+
+  int64_t delay = (now->seconds - pcs.previousTime.seconds) * USECS_PER_SEC;
+  delay += (now->nanoseconds - pcs.previousTime.nanoseconds) / NSECS_PER_USEC;
+  if (delay < 0) delay = 0;
+  pcs.previousTime = *now;
+
+  unsigned char header[4 + 10];
+  unsigned char *byte = header;
+
+  *byte++ = type;
+  *byte++ = channel;
+  byte = putInteger(byte, size, 2);
+  byte = putVarint(byte, delay);
+
+  if (!writeCaptureBytes(header, byte - header)) return 0;
+  if (!writeCaptureBytes(data, size)) return 0;
+  return 1;
+}
+
+static int
+writeChannelRecord (unsigned int index, const TimeValue *now) {
+  const char *identifier = pcs.channels[index].identifier;
+  if (!identifier) identifier = "";
+
+  return writeCaptureRecord(PCR_CHANNEL, index+1, now, identifier, strlen(identifier));
+}
+
+static int
+startCaptureFile (const TimeValue *now, int append) {
+  if (!(pcs.stream = fopen(pcs.path, (append? "ab": "wb")))) {
+    logMessage(LOG_WARNING, "packet capture file open error: %s: %s",
+               pcs.path, strerror(errno));
+    return 0;
+  }
+
+  if (append) {
+    long int size = (fseek(pcs.stream, 0, SEEK_END) != -1)? ftell(pcs.stream): -1;
+
+    if (size > 0) {
+      /* the records carry on from the last one that was written */
+      pcs.bytesWritten = size;
+      goto channels;
+    }
+  }
+
+  pcs.bytesWritten = 0;
+  pcs.previousTime = *now;
+
+  {
+    unsigned char header[PKT_CAPTURE_HEADER_SIZE];
+    unsigned char *byte = header;
+
+    byte = mempcpy(byte, PKT_CAPTURE_MAGIC, PKT_CAPTURE_MAGIC_SIZE);
+    byte = putInteger(byte, PKT_CAPTURE_VERSION, 1);
+    byte = putInteger(byte, 0, 3);
+    byte = putInteger(byte, now->seconds, 8);
+    byte = putInteger(byte, now->nanoseconds, 4);
+
+    if (!writeCaptureBytes(header, byte - header)) goto failed;
+  }
+
+channels:
+  for (unsigned int index=0; index<pcs.channelCount; index+=1) {
+    if (pcs.channels[index].object) {
+      if (!writeChannelRecord(index, now)) goto failed;
+    }
+  }
+
+  return 1;
+
+failed:
+  fclose(pcs.stream);
+  pcs.stream = NULL;
+  return 0;
+}
+
+static char *
+makeRotatedPath (unsigned int number) {
+  char buffer[strlen(pcs.path) + 0X10];
+  snprintf(buffer, sizeof(buffer), "%s.%u", pcs.path, number);
+
+  char *path = strdup(buffer);
+  if (!path) logMallocError();
+  return path;
+}
+
+static int
+renameCaptureFile (const char *from, unsigned int number) {
+  int ok = 0;
+  char *to = makeRotatedPath(number);
+
+  if (to) {
+    if (rename(from, to) != -1) {
+      ok = 1;
+    } else if (errno != ENOENT) {
+      logMessage(LOG_WARNING, "packet capture file rename error: %s -> %s: %s",
+                 from, to, strerror(errno));
+    }
+
+    free(to);
+  }
+
+  return ok;
+}
+
+static void
+closeCaptureFile (void) {
+  if (fflush(pcs.stream) == EOF) logSystemError("packet capture flush");
+  fclose(pcs.stream);
+  pcs.stream = NULL;
+}
+
+static void
+shiftCaptureFiles (void) {
+  if (pcs.fileCount > 1) {
+    unsigned int number = pcs.fileCount - 1;
+
+    while (--number) {
+      char *from = makeRotatedPath(number);
+
+      if (from) {
+        renameCaptureFile(from, number+1);
+        free(from);
+      }
+    }
+
+    renameCaptureFile(pcs.path, 1);
+  }
+}
+
+static int
+rotateCaptureFiles (const TimeValue *now) {
+  closeCaptureFile();
+  shiftCaptureFiles();
+  return startCaptureFile(now, 0);
+}
+
+static void
+clearChannels (void) {
+  while (pcs.channelCount > 0) {
+    PacketCaptureChannel *pcc = &pcs.channels[--pcs.channelCount];
+
+    if (pcc->identifier) {
+      free(pcc->identifier);
+      pcc->identifier = NULL;
+    }
+
+    pcc->object = NULL;
+  }
+}
+
+static void
+closeCapture (void) {
+  if (pcs.stream) closeCaptureFile();
+
+  if (pcs.path) {
+    free(pcs.path);
+    pcs.path = NULL;
+  }
+
+  clearChannels();
+}
+
+void
+closePacketCapture (void) {
+  if (lockPacketCapture()) {
+    closeCapture();
+    unlockPacketCapture();
+  }
+}
+
+int
+openPacketCapture (const char *path, size_t fileSize, unsigned int fileCount) {
+  int ok = 0;
+
+  if (lockPacketCapture()) {
+    closeCapture();
+
+    if ((pcs.path = strdup(path))) {
+      pcs.fileSize = fileSize? fileSize: PKT_CAPTURE_DEFAULT_FILE_SIZE;
+      pcs.fileCount = fileCount? fileCount: PKT_CAPTURE_DEFAULT_FILE_COUNT;
+
+      TimeValue now;
+      getCurrentTime(&now);
+
+      if (startCaptureFile(&now, 0)) {
+        logMessage(LOG_DEBUG, "packet capture started: %s", pcs.path);
+        ok = 1;
+      } else {
+        free(pcs.path);
+        pcs.path = NULL;
+      }
+    } else {
+      logMallocError();
+    }
+
+    unlockPacketCapture();
+  }
+
+  return ok;
+}
+
+int
+isCapturingPackets (void) {
+  return !!pcs.stream;
+}
+
+int
+suspendPacketCapture (void) {
+  int ok = 0;
+
+  if (lockPacketCapture()) {
+    if (pcs.stream) {
+      closeCaptureFile();
+      logMessage(LOG_DEBUG, "packet capture suspended: %s", pcs.path);
+      ok = 1;
+    }
+
+    unlockPacketCapture();
+  }
+
+  return ok;
+}
+
+int
+resumePacketCapture (void) {
+  int ok = 0;
+
+  if (lockPacketCapture()) {
+    if (pcs.stream) {
+      ok = 1;
+    } else if (pcs.path) {
+      TimeValue now;
+      getCurrentTime(&now);
+
+      /* keep what was captured before it was suspended - it's rotated
+       * out of the way if there's room for it, or else added to
+       */
+      int append = pcs.fileCount == 1;
+      if (!append) shiftCaptureFiles();
+
+      if (startCaptureFile(&now, append)) {
+        logMessage(LOG_DEBUG, "packet capture resumed: %s", pcs.path);
+        ok = 1;
+      }
+    }
+
+    unlockPacketCapture();
+  }
+
+  return ok;
+}
+
+static PacketCaptureChannel *
+findChannel (const void *object) {
+  PacketCaptureChannel *pcc = pcs.channels;
+  const PacketCaptureChannel *end = pcc + pcs.channelCount;
+
+  while (pcc < end) {
+    if (pcc->object == object) return pcc;
+    pcc += 1;
+  }
+
+  return NULL;
+}
+
+unsigned char
+getPacketCaptureChannel (const void *object, PacketCaptureIdentifierMaker *makeIdentifier) {
+  unsigned char channel = 0;
+
+  if (pcs.stream && object) {
+    if (lockPacketCapture()) {
+      PacketCaptureChannel *pcc = findChannel(object);
+
+      if (!pcc) {
+        if (!(pcc = findChannel(NULL))) {
+          if (pcs.channelCount < ARRAY_COUNT(pcs.channels)) {
+            pcc = &pcs.channels[pcs.channelCount++];
+          }
+        }
+
+        if (pcc) {
+          char buffer[0X100];
+          const char *identifier = makeIdentifier(object, buffer, sizeof(buffer));
+
+          pcc->object = object;
+          if (pcc->identifier) free(pcc->identifier);
+          pcc->identifier = identifier? strdup(identifier): NULL;
+
+          if (pcs.stream) {
+            TimeValue now;
+            getCurrentTime(&now);
+            writeChannelRecord(pcc - pcs.channels, &now);
+          }
+        }
+      }
+
+      if (pcc) channel = (pcc - pcs.channels) + 1;
+      unlockPacketCapture();
+    }
+  }
+
+  return channel;
+}
+
+void
+forgetPacketCaptureChannel (const void *object) {
+  if (pcs.channelCount > 0) {
+    if (lockPacketCapture()) {
+      PacketCaptureChannel *pcc = findChannel(object);
+
+      if (pcc) {
+        pcc->object = NULL;
+
+        if (pcc->identifier) {
+          free(pcc->identifier);
+          pcc->identifier = NULL;
+        }
+      }
+
+      unlockPacketCapture();
+    }
+  }
+}
+
+void
+capturePacket (
+  PacketCaptureRecordType type, unsigned char channel,
+  const void *packet, size_t size
+) {
+  if (pcs.stream) {
+    if (lockPacketCapture()) {
+      if (pcs.stream) {
+        TimeValue now;
+        getCurrentTime(&now);
+
+        if (pcs.bytesWritten >= pcs.fileSize) rotateCaptureFiles(&now);
+
+        if (pcs.stream) {
+          if (!writeCaptureRecord(type, channel, &now, packet, size)) {
+            closeCapture();
+          }
+        }
+      }
+
+      unlockPacketCapture();
+    }
+  }
+}
@@ -76,3 +76,48 @@ clearScreenCharacters (ScreenCharacter *characters, size_t count) {
   setScreenCharacterText(characters, count, defaultScreenCharacter.text);
   setScreenCharacterColor(characters, count, &defaultScreenCharacter.color);
 }
+
+void
+findShiftedMatches (
+  const ScreenCharacter *from, const ScreenCharacter *to,
+  int length, unsigned char *matches
+) {
+  /* This is the Z algorithm applied to from+to. */
+  if (length < 1) return;
+
+  int size = length * 2;
+  wchar_t text[size];
+  int prefixes[size];
+
+  for (int index=0; index<length; index+=1) {
+    text[index] = from[index].text;
+    text[length + index] = to[index].text;
+  }
+
+  int left = 0;
+  int right = 0;
+  prefixes[0] = size;
+
+  for (int index=1; index<size; index+=1) {
+    int prefix = 0;
+
+    if (index < right) {
+      prefix = MIN(right - index, prefixes[index - left]);
+    }
+
+    while (((index + prefix) < size) && (text[prefix] == text[index + prefix])) {
+      prefix += 1;
+    }
+
+    if ((index + prefix) > right) {
+      left = index;
+      right = index + prefix;
+    }
+
+    prefixes[index] = prefix;
+  }
+
+  for (int shift=0; shift<length; shift+=1) {
+    matches[shift] = prefixes[length + shift] == (length - shift);
+  }
+}
@@ -245,6 +245,26 @@ serialSetFlowControl (SerialDevice *serial, SerialFlowControl flow) {
   return 0;
 }
 
+int
+serialSetLatency (SerialDevice *serial, SerialLatency latency) {
+  static const char *const names[] = {
+    [SERIAL_LATENCY_DEFAULT] = "default",
+    [SERIAL_LATENCY_LOW] = "low"
+  };
+
+  const char *name = names[latency];
+
+  if (serialPutLatency(serial, latency)) {
+    serial->latencyChanged = latency != SERIAL_LATENCY_DEFAULT;
+    logMessage(LOG_CATEGORY(SERIAL_IO), "latency: %s", name);
+    return 1;
+  }
+
+  logMessage(LOG_CATEGORY(SERIAL_IO), "latency not adjustable: %s: %s",
+             name, strerror(errno));
+  return 0;
+}
+
 unsigned int
 serialGetCharacterSize (const SerialParameters *parameters) {
   unsigned int size = 1 /* start bit */ + parameters->dataBits;
@@ -757,6 +777,7 @@ serialCloseDevice (SerialDevice *serial) {
 #endif /* HAVE_POSIX_THREADS */
 
   serialWriteAttributes(serial, &serial->originalAttributes);
+  if (serial->latencyChanged) serialPutLatency(serial, SERIAL_LATENCY_DEFAULT);
 
   if (serial->stream) {
     fclose(serial->stream);
@@ -183,6 +183,12 @@ serialDrainOutput (SerialDevice *serial) {
   return 1;
 }
 
+int
+serialPutLatency (SerialDevice *serial, SerialLatency latency) {
+  errno = ENOSYS;
+  return 0;
+}
+
 ssize_t
 serialGetData (
   SerialDevice *serial,
@@ -43,6 +43,7 @@ struct SerialDeviceStruct {
 
   SerialLines linesState;
   SerialLines waitLines;
+  unsigned latencyChanged:1;
 
 #ifdef HAVE_POSIX_THREADS
   SerialFlowControlProc *currentFlowControlProc;
@@ -86,6 +87,7 @@ extern int serialCancelOutput (SerialDevice *serial);
 
 extern int serialPollInput (SerialDevice *serial, int timeout);
 extern int serialDrainOutput (SerialDevice *serial);
+extern int serialPutLatency (SerialDevice *serial, SerialLatency latency);
 
 extern ssize_t serialGetData (
   SerialDevice *serial,
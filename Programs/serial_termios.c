@@ -27,6 +27,10 @@
 #include "io_misc.h"
 #include "async_io.h"
 
+#ifdef HAVE_LINUX_SERIAL_H
+#include <linux/serial.h>
+#endif /* HAVE_LINUX_SERIAL_H */
+
 #include "serial_termios.h"
 #include "serial_internal.h"
 
@@ -438,6 +442,40 @@ serialDrainOutput (SerialDevice *serial) {
   return 0;
 }
 
+int
+serialPutLatency (SerialDevice *serial, SerialLatency latency) {
+#if defined(HAVE_LINUX_SERIAL_H) && defined(TIOCGSERIAL) && defined(ASYNC_LOW_LATENCY)
+  struct serial_struct info;
+
+  if (ioctl(serial->fileDescriptor, TIOCGSERIAL, &info) != -1) {
+    int flags = info.flags;
+
+    if (!serial->package.haveOriginalFlags) {
+      serial->package.originalFlags = flags;
+      serial->package.haveOriginalFlags = 1;
+    }
+
+    if (latency == SERIAL_LATENCY_LOW) {
+      info.flags |= ASYNC_LOW_LATENCY;
+    } else {
+      /* the default is whatever the device had before we changed it */
+      info.flags &= ~ASYNC_LOW_LATENCY;
+      info.flags |= serial->package.originalFlags & ASYNC_LOW_LATENCY;
+    }
+
+    if (info.flags == flags) return 1;
+    if (ioctl(serial->fileDescriptor, TIOCSSERIAL, &info) != -1) return 1;
+    logSystemError("TIOCSSERIAL");
+  } else if (errno != ENOTTY) {
+    logSystemError("TIOCGSERIAL");
+  }
+#else /* set low latency */
+  errno = ENOSYS;
+#endif /* set low latency */
+
+  return 0;
+}
+
 ssize_t
 serialGetData (
   SerialDevice *serial,
@@ -512,6 +550,7 @@ serialMonitorWaitLines (SerialDevice *serial) {
 int
 serialConnectDevice (SerialDevice *serial, const char *device) {
   serial->package.inputMonitor = NULL;
+  serial->package.haveOriginalFlags = 0;
 
   if ((serial->fileDescriptor = open(device, O_RDWR|O_NOCTTY|O_NONBLOCK)) != -1) {
     setCloseOnExec(serial->fileDescriptor, 1);
@@ -45,6 +45,9 @@ typedef int SerialLines;
 
 typedef struct {
   AsyncHandle inputMonitor;
+
+  int originalFlags; /* serial_struct flags before the latency was changed */
+  unsigned haveOriginalFlags:1;
 } SerialPackageFields;
 
 #ifdef __cplusplus
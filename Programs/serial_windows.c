@@ -307,6 +307,12 @@ serialDrainOutput (SerialDevice *serial) {
   return 0;
 }
 
+int
+serialPutLatency (SerialDevice *serial, SerialLatency latency) {
+  errno = ENOSYS;
+  return 0;
+}
+
 ssize_t
 serialGetData (
   SerialDevice *serial,
@@ -0,0 +1,288 @@
+/*
+ * BRLTTY - A background process providing access to the console screen (when in
+ *          text mode) for a blind person using a refreshable braille display.
+ *
+ * Copyright (C) 1995-2026 by The BRLTTY Developers.
+ *
+ * BRLTTY comes with ABSOLUTELY NO WARRANTY.
+ *
+ * This is free software, placed under the terms of the
+ * GNU Lesser General Public License, as published by the Free Software
+ * Foundation; either version 2.1 of the License, or (at your option) any
+ * later version. Please see the file LICENSE-LGPL for details.
+ *
+ * Web Page: http://brltty.app/
+ *
+ * This software is maintained by Dave Mielke <dave@mielke.cc>.
+ */
+
+#include "prologue.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <wctype.h>
+
+#include "log.h"
+#include "cmdline.h"
+#include "cmdput.h"
+#include "parse.h"
+#include "scr_utils.h"
+
+static int opt_quiet;
+static char *opt_count;
+static char *opt_seed;
+
+BEGIN_COMMAND_LINE_OPTIONS(programOptions)
+  { .word = "count",
+    .letter = 'c',
+    .argument = "integer",
+    .setting.string = &opt_count,
+    .internal.setting = "100000",
+    .description = "number of random row pairs to compare"
+  },
+
+  { .word = "seed",
+    .letter = 's',
+    .argument = "integer",
+    .setting.string = &opt_seed,
+    .internal.setting = "1",
+    .description = "seed for the random row pairs"
+  },
+
+  { .word = "quiet",
+    .letter = 'q',
+    .setting.flag = &opt_quiet,
+    .description = "only report mismatches"
+  },
+END_COMMAND_LINE_OPTIONS(programOptions)
+
+BEGIN_COMMAND_LINE_PARAMETERS(programParameters)
+END_COMMAND_LINE_PARAMETERS(programParameters)
+
+BEGIN_COMMAND_LINE_NOTES(programNotes)
+  "Each row pair is an old and a new screen row which share the text before",
+  "the cursor. The characters inserted or deleted after the cursor are found",
+  "both with findShiftedMatches and with the original quadratic search,",
+  "and the two results must be the same.",
+END_COMMAND_LINE_NOTES
+
+BEGIN_COMMAND_LINE_DESCRIPTOR(programDescriptor)
+  .name = "shifttest",
+  .purpose = strtext("Test the search for characters inserted or deleted after the cursor."),
+
+  .options = &programOptions,
+  .parameters = &programParameters,
+  .notes = COMMAND_LINE_NOTES(programNotes),
+END_COMMAND_LINE_DESCRIPTOR
+
+typedef enum {
+  SHIFT_NONE,
+  SHIFT_INSERTED,
+  SHIFT_DELETED
+} ShiftType;
+
+typedef struct {
+  ShiftType type;
+  int count;
+} ShiftResult;
+
+static int
+isSameText (const ScreenCharacter *characters1, const ScreenCharacter *characters2, int count) {
+  for (int index=0; index<count; index+=1) {
+    if (characters1[index].text != characters2[index].text) return 0;
+  }
+
+  return 1;
+}
+
+static int
+getTextLength (const ScreenCharacter *characters, int width, int x) {
+  int length = width;
+
+  while (length > x) {
+    if (!iswspace(characters[length-1].text)) break;
+    length -= 1;
+  }
+
+  if (length < width) length += 1;
+  return length;
+}
+
+/* the search as it was before findShiftedMatches */
+static ShiftResult
+findShiftOriginal (
+  const ScreenCharacter *oldCharacters, const ScreenCharacter *newCharacters,
+  int width, int cursor
+) {
+  int oldLength = getTextLength(oldCharacters, width, cursor);
+  int newLength = getTextLength(newCharacters, width, cursor);
+  int x = cursor;
+
+  while (1) {
+    int done = 1;
+
+    if (x < newLength) {
+      if (isSameText(newCharacters+x, oldCharacters+cursor, width-x)) {
+        return (ShiftResult){.type=SHIFT_INSERTED, .count=x-cursor};
+      }
+
+      done = 0;
+    }
+
+    if (x < oldLength) {
+      if (isSameText(newCharacters+cursor, oldCharacters+x, width-x)) {
+        return (ShiftResult){.type=SHIFT_DELETED, .count=x-cursor};
+      }
+
+      done = 0;
+    }
+
+    if (done) break;
+    x += 1;
+  }
+
+  return (ShiftResult){.type=SHIFT_NONE};
+}
+
+/* the search as it's done by autospeak */
+static ShiftResult
+findShiftCurrent (
+  const ScreenCharacter *oldCharacters, const ScreenCharacter *newCharacters,
+  int width, int cursor
+) {
+  int oldLength = getTextLength(oldCharacters, width, cursor);
+  int newLength = getTextLength(newCharacters, width, cursor);
+
+  int length = width - cursor;
+  unsigned char inserted[length];
+  unsigned char deleted[length];
+
+  findShiftedMatches(oldCharacters+cursor, newCharacters+cursor, length, inserted);
+  findShiftedMatches(newCharacters+cursor, oldCharacters+cursor, length, deleted);
+
+  for (int x=cursor; ((x < newLength) || (x < oldLength)); x+=1) {
+    int shift = x - cursor;
+
+    if ((x < newLength) && inserted[shift]) {
+      return (ShiftResult){.type=SHIFT_INSERTED, .count=shift};
+    }
+
+    if ((x < oldLength) && deleted[shift]) {
+      return (ShiftResult){.type=SHIFT_DELETED, .count=shift};
+    }
+  }
+
+  return (ShiftResult){.type=SHIFT_NONE};
+}
+
+static wchar_t
+makeCharacter (int alphabet) {
+  /* a small alphabet makes accidental repetitions likely */
+  int value = rand() % (alphabet + 1);
+  return value? (WC_C('a') + value - 1): WC_C(' ');
+}
+
+static void
+makeRowPair (ScreenCharacter *oldCharacters, ScreenCharacter *newCharacters, int width, int cursor) {
+  int alphabet = 1 + (rand() % 4);
+  if (!(rand() % 4)) alphabet = 26;
+
+  clearScreenCharacters(oldCharacters, width);
+  clearScreenCharacters(newCharacters, width);
+
+  int textLength = cursor + (rand() % (width - cursor + 1));
+  for (int x=0; x<textLength; x+=1) oldCharacters[x].text = makeCharacter(alphabet);
+
+  for (int x=0; x<cursor; x+=1) newCharacters[x].text = oldCharacters[x].text;
+  int from = cursor;
+  int to = cursor;
+  int size = 1 + (rand() % 4);
+
+  switch (rand() % 4) {
+    case 0: /* insert */
+      for (int count=0; (count<size) && (to<width); count+=1) {
+        newCharacters[to++].text = makeCharacter(alphabet);
+      }
+      break;
+
+    case 1: /* delete */
+      from += size;
+      break;
+
+    case 2: /* replace */
+      from += size;
+      for (int count=0; (count<size) && (to<width); count+=1) {
+        newCharacters[to++].text = makeCharacter(alphabet);
+      }
+      break;
+
+    default: /* unchanged */
+      break;
+  }
+
+  while ((from < width) && (to < width)) newCharacters[to++].text = oldCharacters[from++].text;
+}
+
+static void
+putRow (const char *label, const ScreenCharacter *characters, int width) {
+  wchar_t text[width + 1];
+
+  for (int x=0; x<width; x+=1) text[x] = characters[x].text;
+  text[width] = 0;
+
+  putf("    %s: \"%ls\"\n", label, text);
+}
+
+int
+main (int argc, char *argv[]) {
+  PROCESS_COMMAND_LINE(programDescriptor, argc, argv);
+
+  int count;
+  int seed;
+
+  {
+    static const int minimum = 1;
+
+    if (!validateInteger(&count, opt_count, &minimum, NULL)) {
+      logMessage(LOG_ERR, "invalid count: %s", opt_count);
+      return PROG_EXIT_SYNTAX;
+    }
+  }
+
+  if (!validateInteger(&seed, opt_seed, NULL, NULL)) {
+    logMessage(LOG_ERR, "invalid seed: %s", opt_seed);
+    return PROG_EXIT_SYNTAX;
+  }
+
+  srand(seed);
+  int failures = 0;
+
+  for (int index=0; index<count; index+=1) {
+    int width = 1 + (rand() % 80);
+    int cursor = rand() % width;
+
+    ScreenCharacter oldCharacters[width];
+    ScreenCharacter newCharacters[width];
+    makeRowPair(oldCharacters, newCharacters, width, cursor);
+
+    ShiftResult original = findShiftOriginal(oldCharacters, newCharacters, width, cursor);
+    ShiftResult current = findShiftCurrent(oldCharacters, newCharacters, width, cursor);
+
+    if ((current.type != original.type) || (current.count != original.count)) {
+      failures += 1;
+
+      putf("  FAIL: pair %d (width=%d cursor=%d): original=%d/%d current=%d/%d\n",
+           index, width, cursor,
+           original.type, original.count, current.type, current.count);
+
+      putRow("old", oldCharacters, width);
+      putRow("new", newCharacters, width);
+    }
+  }
+
+  if (!opt_quiet || failures) {
+    putf("%d row pairs compared, %d mismatches\n", count, failures);
+  }
+
+  return failures? PROG_EXIT_FATAL: PROG_EXIT_SUCCESS;
+}
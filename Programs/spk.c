@@ -176,6 +176,11 @@ sayIntegerSetting (
   return sayStringSetting(spk, name, string);
 }
 
+int
+getSpeechBacklog (SpeechSynthesizer *spk) {
+  return getSpeechDriverBacklog(spk->driver.thread);
+}
+
 int
 canDrainSpeech (SpeechSynthesizer *spk) {
   return spk->drain != NULL;
@@ -189,6 +194,11 @@ drainSpeech (SpeechSynthesizer *spk) {
   return 1;
 }
 
+int
+synchronizeSpeech (SpeechSynthesizer *spk) {
+  return speechRequest_synchronize(spk->driver.thread);
+}
+
 int
 canSetSpeechVolume (SpeechSynthesizer *spk) {
   return spk->setVolume != NULL;
@@ -25,6 +25,11 @@
 #include "parse.h"
 
 #ifdef ENABLE_SPEECH_SUPPORT
+int
+tellSpeechStarted (SpeechSynthesizer *spk) {
+  return speechMessage_speechStarted(spk->driver.thread);
+}
+
 int
 tellSpeechFinished (SpeechSynthesizer *spk) {
   return speechMessage_speechFinished(spk->driver.thread);
@@ -36,6 +41,11 @@ tellSpeechLocation (SpeechSynthesizer *spk, int index) {
   return speechMessage_speechLocation(spk->driver.thread, index);
 }
 
+unsigned int
+getSpeechMuteCount (SpeechSynthesizer *spk) {
+  return getSpeechDriverMuteCount(spk->driver.thread);
+}
+
 static unsigned int
 getIntegerSetting (unsigned char setting, unsigned char internal, unsigned int external) {
   return rescaleInteger(setting, internal, external);
@@ -0,0 +1,313 @@
+/*
+ * BRLTTY - A background process providing access to the console screen (when in
+ *          text mode) for a blind person using a refreshable braille display.
+ *
+ * Copyright (C) 1995-2026 by The BRLTTY Developers.
+ *
+ * BRLTTY comes with ABSOLUTELY NO WARRANTY.
+ *
+ * This is free software, placed under the terms of the
+ * GNU Lesser General Public License, as published by the Free Software
+ * Foundation; either version 2.1 of the License, or (at your option) any
+ * later version. Please see the file LICENSE-LGPL for details.
+ *
+ * Web Page: http://brltty.app/
+ *
+ * This software is maintained by Dave Mielke <dave@mielke.cc>.
+ */
+
+
+#include "prologue.h"
+
+#include <string.h>
+#include <stdlib.h>
+
+#include "log.h"
+#include "strfmt.h"
+#include "spk_cache.h"
+#include "queue.h"
+#include "lock.h"
+#include "timing.h"
+#include "histogram.h"
+
+typedef struct {
+  char *key;
+  size_t count;
+  int16_t samples[];
+} SpeechCacheEntry;
+
+struct SpeechCacheStruct {
+  LockDescriptor *lock;
+  Queue *entries;
+  size_t maximumSize;
+  size_t currentSize;
+
+  struct {
+    unsigned long int hits;
+    unsigned long int misses;
+    unsigned long int evictions;
+
+    Histogram cachedFirstSample;
+    Histogram uncachedFirstSample;
+  } statistics;
+};
+
+static Queue *speechCaches = NULL;
+
+static LockDescriptor *
+getSpeechCachesLock (void) {
+  static LockDescriptor *lock = NULL;
+  return getLockDescriptor(&lock, "speech-caches");
+}
+
+static void
+addSpeechCache (SpeechCache *cache) {
+  LockDescriptor *lock = getSpeechCachesLock();
+
+  if (lock) {
+    obtainExclusiveLock(lock);
+    if (!speechCaches) speechCaches = newQueue(NULL, NULL);
+    if (speechCaches) enqueueItem(speechCaches, cache);
+    releaseLock(lock);
+  }
+}
+
+static void
+removeSpeechCache (SpeechCache *cache) {
+  LockDescriptor *lock = getSpeechCachesLock();
+
+  if (lock) {
+    obtainExclusiveLock(lock);
+    if (speechCaches) deleteItem(speechCaches, cache);
+    releaseLock(lock);
+  }
+}
+
+static size_t
+getSpeechCacheEntrySize (const SpeechCacheEntry *entry) {
+  return sizeof(*entry) + (entry->count * sizeof(entry->samples[0]));
+}
+
+static void
+deallocateSpeechCacheEntry (void *item, void *data) {
+  SpeechCacheEntry *entry = item;
+  SpeechCache *cache = data;
+
+  cache->currentSize -= getSpeechCacheEntrySize(entry);
+  free(entry->key);
+  free(entry);
+}
+
+static int
+testSpeechCacheEntry (const void *item, void *data) {
+  const SpeechCacheEntry *entry = item;
+  const char *key = data;
+  return strcmp(entry->key, key) == 0;
+}
+
+static Element *
+findSpeechCacheEntry (SpeechCache *cache, const char *key) {
+  return findElement(cache->entries, testSpeechCacheEntry, (void *)key);
+}
+
+SpeechCache *
+newSpeechCache (size_t maximumSize) {
+  SpeechCache *cache;
+
+  if ((cache = malloc(sizeof(*cache)))) {
+    memset(cache, 0, sizeof(*cache));
+    cache->maximumSize = maximumSize;
+    cache->currentSize = 0;
+
+    resetHistogram(&cache->statistics.cachedFirstSample);
+    resetHistogram(&cache->statistics.uncachedFirstSample);
+
+    if ((cache->lock = newLockDescriptor())) {
+      if ((cache->entries = newQueue(deallocateSpeechCacheEntry, NULL))) {
+        setQueueData(cache->entries, cache);
+        addSpeechCache(cache);
+        return cache;
+      }
+
+      freeLockDescriptor(cache->lock);
+    }
+
+    free(cache);
+  } else {
+    logMallocError();
+  }
+
+  return NULL;
+}
+
+void
+destroySpeechCache (SpeechCache *cache) {
+  removeSpeechCache(cache);
+  logSpeechCacheStatistics(cache);
+  destroyQueue(cache->entries);
+  freeLockDescriptor(cache->lock);
+  free(cache);
+}
+
+int
+getSpeechCacheAudio (
+  SpeechCache *cache, const char *key,
+  int16_t **samples, size_t *count
+) {
+  int found = 0;
+  obtainExclusiveLock(cache->lock);
+
+  {
+    Element *element = findSpeechCacheEntry(cache, key);
+
+    if (element) {
+      const SpeechCacheEntry *entry = getElementItem(element);
+      size_t size = entry->count * sizeof(entry->samples[0]);
+
+      if ((*samples = malloc(size))) {
+        memcpy(*samples, entry->samples, size);
+        *count = entry->count;
+
+        requeueElement(element);
+        cache->statistics.hits += 1;
+        found = 1;
+      } else {
+        logMallocError();
+      }
+    } else {
+      cache->statistics.misses += 1;
+    }
+  }
+
+  releaseLock(cache->lock);
+  return found;
+}
+
+int
+putSpeechCacheAudio (
+  SpeechCache *cache, const char *key,
+  const int16_t *samples, size_t count
+) {
+  int ok = 0;
+  SpeechCacheEntry *entry;
+  size_t size = sizeof(*entry) + (count * sizeof(entry->samples[0]));
+
+  if (size > cache->maximumSize) return 0;
+
+  if ((entry = malloc(size))) {
+    entry->count = count;
+    memcpy(entry->samples, samples, (count * sizeof(entry->samples[0])));
+
+    if ((entry->key = strdup(key))) {
+      obtainExclusiveLock(cache->lock);
+
+      {
+        Element *element = findSpeechCacheEntry(cache, key);
+        if (element) deleteElement(element);
+      }
+
+      while (cache->currentSize + size > cache->maximumSize) {
+        Element *element = getQueueHead(cache->entries);
+        if (!element) break;
+
+        deleteElement(element);
+        cache->statistics.evictions += 1;
+      }
+
+      if (enqueueItem(cache->entries, entry)) {
+        cache->currentSize += size;
+        ok = 1;
+      }
+
+      releaseLock(cache->lock);
+      if (ok) return 1;
+
+      free(entry->key);
+    } else {
+      logMallocError();
+    }
+
+    free(entry);
+  } else {
+    logMallocError();
+  }
+
+  return 0;
+}
+
+int
+isSpeechCached (SpeechCache *cache, const char *key) {
+  obtainSharedLock(cache->lock);
+  int cached = !!findSpeechCacheEntry(cache, key);
+  releaseLock(cache->lock);
+  return cached;
+}
+
+void
+addSpeechCacheFirstSample (SpeechCache *cache, int cached, const TimeValue *start) {
+  TimeValue now;
+  getMonotonicTime(&now);
+
+  int64_t microseconds = microsecondsBetween(start, &now);
+  if (microseconds < 0) microseconds = 0;
+  if (microseconds > UINT32_MAX) microseconds = UINT32_MAX;
+
+  obtainExclusiveLock(cache->lock);
+  addHistogramValue(
+    (cached? &cache->statistics.cachedFirstSample: &cache->statistics.uncachedFirstSample),
+    microseconds
+  );
+  releaseLock(cache->lock);
+}
+
+size_t
+formatSpeechCacheStatistics (SpeechCache *cache, char *buffer, size_t size) {
+  size_t length;
+  obtainSharedLock(cache->lock);
+
+  STR_BEGIN(buffer, size);
+  STR_PRINTF(
+    "speech cache: entries=%d size=%zu hits=%lu misses=%lu evictions=%lu",
+    getQueueSize(cache->entries), cache->currentSize,
+    cache->statistics.hits, cache->statistics.misses,
+    cache->statistics.evictions
+  );
+
+  STR_PRINTF(" first sample cached (microseconds)[");
+  STR_FORMAT(formatHistogram, &cache->statistics.cachedFirstSample);
+  STR_PRINTF("]");
+
+  STR_PRINTF(" uncached[");
+  STR_FORMAT(formatHistogram, &cache->statistics.uncachedFirstSample);
+  STR_PRINTF("]");
+
+  length = STR_LENGTH;
+  STR_END;
+
+  releaseLock(cache->lock);
+  return length;
+}
+
+void
+logSpeechCacheStatistics (SpeechCache *cache) {
+  char statistics[0X300];
+  formatSpeechCacheStatistics(cache, statistics, sizeof(statistics));
+  logMessage(LOG_CATEGORY(PERFORMANCE), "%s", statistics);
+}
+
+static int
+logSpeechCacheItem (void *item, void *data) {
+  logSpeechCacheStatistics(item);
+  return 0;
+}
+
+void
+logAllSpeechCacheStatistics (void) {
+  LockDescriptor *lock = getSpeechCachesLock();
+
+  if (lock) {
+    obtainSharedLock(lock);
+    if (speechCaches) processQueue(speechCaches, logSpeechCacheItem, NULL);
+    releaseLock(lock);
+  }
+}
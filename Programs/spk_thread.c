@@ -31,6 +31,8 @@
 #include "async_event.h"
 #include "thread.h"
 #include "queue.h"
+#include "timing.h"
+#include "histogram.h"
 
 #ifdef ENABLE_SPEECH_SUPPORT
 typedef enum {
@@ -78,33 +80,19 @@ typedef enum {
   RSP_INTEGER
 } SpeechResponseType;
 
-struct SpeechDriverThreadStruct {
-  ThreadState threadState;
-  Queue *requestQueue;
-
-  SpeechSynthesizer *speechSynthesizer;
-  char **driverParameters;
-
-#ifdef GOT_PTHREADS
-  pthread_t threadIdentifier;
-  AsyncEvent *requestEvent;
-  AsyncEvent *messageEvent;
-  unsigned isBeingDestroyed:1;
-#endif /* GOT_PTHREADS */
-
-  struct {
-    SpeechResponseType type;
-
-    union {
-      int INTEGER;
-    } value;
-  } response;
-};
+typedef struct {
+  TimeValue requested;
+  TimeValue start;
+  size_t count;
+  size_t location;
+  unsigned started:1;
+} SpeechUtterance;
 
 typedef enum {
   REQ_SAY_TEXT,
   REQ_MUTE_SPEECH,
   REQ_DRAIN_SPEECH,
+  REQ_SYNCHRONIZE,
 
   REQ_SET_VOLUME,
   REQ_SET_RATE,
@@ -116,6 +104,7 @@ static const char *const speechRequestNames[] = {
   [REQ_SAY_TEXT] = "say text",
   [REQ_MUTE_SPEECH] = "mute speech",
   [REQ_DRAIN_SPEECH] = "drain speech",
+  [REQ_SYNCHRONIZE] = "synchronize",
 
   [REQ_SET_VOLUME] = "set volume",
   [REQ_SET_RATE] = "set rate",
@@ -125,6 +114,10 @@ static const char *const speechRequestNames[] = {
 
 typedef struct {
   SpeechRequestType type;
+  TimeValue enqueued;
+  TimeValue sent;
+  TimeValue received;
+  unsigned isPooled:1;
 
   union {
     struct {
@@ -166,18 +159,21 @@ typedef struct {
 
 typedef enum {
   MSG_REQUEST_FINISHED,
+  MSG_SPEECH_STARTED,
   MSG_SPEECH_FINISHED,
   MSG_SPEECH_LOCATION
 } SpeechMessageType;
 
 static const char *const speechMessageNames[] = {
   [MSG_REQUEST_FINISHED] = "request finished",
+  [MSG_SPEECH_STARTED] = "speech started",
   [MSG_SPEECH_FINISHED] = "speech finished",
   [MSG_SPEECH_LOCATION] = "speech location"
 };
 
 typedef struct {
   SpeechMessageType type;
+  TimeValue sent;
 
   union {
     struct {
@@ -188,10 +184,74 @@ typedef struct {
       int location;
     } speechLocation;
   } arguments;
-
-  unsigned char data[0];
 } SpeechMessage;
 
+/* The indices of a single-producer/single-consumer ring. Each is only
+ * advanced by its own side, and the size of the ring must be a power of two
+ * so that they can simply wrap. A ring with more than one producer must have
+ * them take turns (see the message ring's lock).
+ */
+typedef struct {
+  volatile unsigned int head; /* advanced by the consumer */
+  volatile unsigned int tail; /* advanced by the producer */
+} SpeechRing;
+
+struct SpeechDriverThreadStruct {
+  ThreadState threadState;
+  Queue *requestQueue;
+
+  SpeechSynthesizer *speechSynthesizer;
+  char **driverParameters;
+
+#ifdef GOT_PTHREADS
+  pthread_t threadIdentifier;
+  AsyncEvent *requestEvent;
+  AsyncEvent *messageEvent;
+  unsigned isBeingDestroyed:1;
+
+  struct {
+    SpeechRing ring;
+    SpeechRequest *entries[SPEECH_REQUEST_RING_SIZE];
+    unsigned unsignalled:1;
+  } requests;
+
+  struct {
+    SpeechRing ring;
+    SpeechMessage entries[SPEECH_MESSAGE_RING_SIZE];
+
+    // Messages are also sent from threads which some drivers' libraries
+    // use for their callbacks (e.g. Speech Dispatcher's event thread).
+    pthread_mutex_t lock;
+  } messages;
+#endif /* GOT_PTHREADS */
+
+  SpeechRequest *currentRequest;
+
+  struct {
+    SpeechRequest *entries[SPEECH_REQUEST_POOL_SIZE];
+    unsigned int count;
+  } requestPool;
+
+  struct {
+    SpeechResponseType type;
+
+    union {
+      int INTEGER;
+    } value;
+  } response;
+
+  struct {
+    SpeechUtterance entries[SPEECH_UTTERANCE_TRACKING_LIMIT];
+    unsigned int first;
+    unsigned int count;
+  } utterances;
+
+  unsigned int charactersPerSecond; /* 0 until it can be estimated */
+
+  /* advanced on the main thread, read by the driver while it's busy */
+  volatile unsigned int muteCount;
+};
+
 static const char *
 getActionName (unsigned int action, const char *const *names, size_t count) {
   return (action < count)? names[action]: NULL;
@@ -235,7 +295,7 @@ logSpeechRequest (SpeechRequest *req, const char *action) {
 }
 
 static void
-logSpeechMessage (SpeechMessage *msg, const char *action) {
+logSpeechMessage (const SpeechMessage *msg, const char *action) {
   const LogSpeechActionData lsa = {
     .action = action,
     .type = "message",
@@ -327,71 +387,491 @@ awaitSpeechResponse (SpeechDriverThread *sdt, int timeout) {
   return asyncAwaitCondition(timeout, testSpeechResponseReceived, sdt);
 }
 
-static void sendSpeechRequest (SpeechDriverThread *sdt);
+static struct {
+  unsigned long int dropped;
+  unsigned long int merged;
+
+  /* from enqueue to send - the latency report shows it too */
+  Histogram residency;
+} speechQueueStatistics;
+
+static struct {
+  unsigned long int interrupted;
+  unsigned int throughput;
+  Histogram firstAudio;
+  Histogram total;
+} speechLatencyStatistics;
+
+size_t
+formatSpeechLatencyStatistics (char *buffer, size_t size) {
+  size_t length;
+
+  STR_BEGIN(buffer, size);
+  STR_PRINTF("speech latency (milliseconds): interrupted=%lu throughput=%u/s",
+             speechLatencyStatistics.interrupted,
+             speechLatencyStatistics.throughput);
+
+  STR_PRINTF(" queue (microseconds)[");
+  STR_FORMAT(formatHistogram, &speechQueueStatistics.residency);
+  STR_PRINTF("]");
+
+  STR_PRINTF(" first audio[");
+  STR_FORMAT(formatHistogram, &speechLatencyStatistics.firstAudio);
+  STR_PRINTF("]");
+
+  STR_PRINTF(" total[");
+  STR_FORMAT(formatHistogram, &speechLatencyStatistics.total);
+  STR_PRINTF("]");
+
+  length = STR_LENGTH;
+  STR_END;
+
+  return length;
+}
+
+void
+logSpeechLatencyStatistics (void) {
+  char statistics[0X300];
+  formatSpeechLatencyStatistics(statistics, sizeof(statistics));
+  logMessage(LOG_CATEGORY(PERFORMANCE), "%s", statistics);
+}
+
+void
+resetSpeechLatencyStatistics (void) {
+  speechLatencyStatistics.interrupted = 0;
+  speechLatencyStatistics.throughput = 0;
+  resetHistogram(&speechLatencyStatistics.firstAudio);
+  resetHistogram(&speechLatencyStatistics.total);
+}
+
+static long int
+addSpeechLatency (Histogram *histogram, const TimeValue *from, const TimeValue *to) {
+  long int milliseconds = millisecondsBetween(from, to);
+  if (milliseconds < 0) milliseconds = 0;
+
+  addHistogramValue(histogram, milliseconds);
+  return milliseconds;
+}
+
+static struct {
+  unsigned long int wakeups;
+  unsigned long int messages;
+  unsigned long int stalled;
+  unsigned long int dropped;
+  unsigned long int pooled;
+  unsigned long int allocated;
+  Histogram request;
+  Histogram message;
+} speechHandoffStatistics;
+
+size_t
+formatSpeechHandoffStatistics (char *buffer, size_t size) {
+  size_t length;
+
+  STR_BEGIN(buffer, size);
+  STR_PRINTF("speech handoff: wakeups=%lu messages=%lu stalled=%lu dropped=%lu",
+             speechHandoffStatistics.wakeups,
+             speechHandoffStatistics.messages,
+             speechHandoffStatistics.stalled,
+             speechHandoffStatistics.dropped);
+
+  STR_PRINTF(" requests: pooled=%lu allocated=%lu",
+             speechHandoffStatistics.pooled,
+             speechHandoffStatistics.allocated);
+
+  STR_PRINTF(" request (microseconds)[");
+  STR_FORMAT(formatHistogram, &speechHandoffStatistics.request);
+  STR_PRINTF("]");
+
+  STR_PRINTF(" message (microseconds)[");
+  STR_FORMAT(formatHistogram, &speechHandoffStatistics.message);
+  STR_PRINTF("]");
+
+  length = STR_LENGTH;
+  STR_END;
+
+  return length;
+}
+
+void
+logSpeechHandoffStatistics (void) {
+  char statistics[0X300];
+  formatSpeechHandoffStatistics(statistics, sizeof(statistics));
+  logMessage(LOG_CATEGORY(PERFORMANCE), "%s", statistics);
+}
+
+void
+resetSpeechHandoffStatistics (void) {
+  speechHandoffStatistics.wakeups = 0;
+  speechHandoffStatistics.messages = 0;
+  speechHandoffStatistics.stalled = 0;
+  speechHandoffStatistics.dropped = 0;
+  speechHandoffStatistics.pooled = 0;
+  speechHandoffStatistics.allocated = 0;
+  resetHistogram(&speechHandoffStatistics.request);
+  resetHistogram(&speechHandoffStatistics.message);
+}
 
 static void
-handleSpeechMessage (SpeechDriverThread *sdt, SpeechMessage *msg) {
-  logSpeechMessage(msg, "handling");
+addSpeechHandoffLatency (Histogram *histogram, const TimeValue *from, const TimeValue *to) {
+  int64_t microseconds = microsecondsBetween(from, to);
+  if (microseconds < 0) microseconds = 0;
+  if (microseconds > UINT32_MAX) microseconds = UINT32_MAX;
+  addHistogramValue(histogram, microseconds);
+}
 
-  if (msg) {
-    switch (msg->type) {
-      case MSG_REQUEST_FINISHED:
-        setIntegerResponse(sdt, msg->arguments.requestFinished.result);
-        sendSpeechRequest(sdt);
-        break;
+#ifdef GOT_PTHREADS
+static int
+reserveSpeechRingEntry (const SpeechRing *ring, unsigned int size, unsigned int *index) {
+  if ((ring->tail - ring->head) == size) return 0;
+  *index = ring->tail % size;
+  return 1;
+}
 
-      case MSG_SPEECH_FINISHED: {
-        SpeechSynthesizer *spk = sdt->speechSynthesizer;
-        SetSpeechFinishedMethod *setFinished = spk->setFinished;
+static void
+publishSpeechRingEntry (SpeechRing *ring) {
+  // This is a memory write barrier to ensure that the entry
+  // will be visible before the tail is advanced past it.
+  __sync_synchronize();
+  ring->tail += 1;
+}
 
-        if (setFinished) setFinished(spk);
-        break;
+static int
+getSpeechRingEntry (const SpeechRing *ring, unsigned int size, unsigned int *index) {
+  if (ring->head == ring->tail) return 0;
+
+  // This is a memory read barrier to ensure that the entry
+  // isn't read before the tail which was advanced past it.
+  __sync_synchronize();
+
+  *index = ring->head % size;
+  return 1;
+}
+
+static void
+releaseSpeechRingEntry (SpeechRing *ring) {
+  // This is a memory barrier to ensure that the entry has been
+  // completely read before the producer is allowed to reuse it.
+  __sync_synchronize();
+  ring->head += 1;
+}
+#endif /* GOT_PTHREADS */
+
+static SpeechUtterance *
+getSpeechUtterance (SpeechDriverThread *sdt, unsigned int index) {
+  index += sdt->utterances.first;
+  index %= ARRAY_COUNT(sdt->utterances.entries);
+  return &sdt->utterances.entries[index];
+}
+
+static void
+removeSpeechUtterance (SpeechDriverThread *sdt) {
+  sdt->utterances.first += 1;
+  sdt->utterances.first %= ARRAY_COUNT(sdt->utterances.entries);
+  sdt->utterances.count -= 1;
+}
+
+static void
+abandonSpeechUtterances (SpeechDriverThread *sdt) {
+  speechLatencyStatistics.interrupted += sdt->utterances.count;
+  sdt->utterances.first = 0;
+  sdt->utterances.count = 0;
+}
+
+static void
+beginSpeechUtterance (SpeechDriverThread *sdt, const SpeechRequest *req) {
+  if (req->arguments.sayText.options & SAY_OPT_MUTE_FIRST) {
+    abandonSpeechUtterances(sdt);
+  } else if (sdt->utterances.count == ARRAY_COUNT(sdt->utterances.entries)) {
+    // the driver isn't telling us when its utterances finish
+    removeSpeechUtterance(sdt);
+    speechLatencyStatistics.interrupted += 1;
+  }
+
+  SpeechUtterance *utterance = getSpeechUtterance(sdt, sdt->utterances.count++);
+  utterance->requested = req->enqueued;
+  utterance->count = req->arguments.sayText.count;
+  utterance->location = 0;
+  utterance->started = 0;
+
+  // provisional - for drivers which don't report when speech starts
+  getMonotonicTime(&utterance->start);
+}
+
+static void updateSpeechThroughput (
+  SpeechDriverThread *sdt, const SpeechUtterance *utterance, const TimeValue *end
+);
+
+static void
+startSpeechUtterance (SpeechDriverThread *sdt, const SpeechMessage *msg) {
+  while (sdt->utterances.count > 0) {
+    SpeechUtterance *utterance = getSpeechUtterance(sdt, 0);
+    if (!utterance->started) break;
+
+    // the driver doesn't report when speech finishes so an earlier
+    // utterance must have ended when this one began
+    updateSpeechThroughput(sdt, utterance, &msg->sent);
+    removeSpeechUtterance(sdt);
+  }
+
+  for (unsigned int index=0; index<sdt->utterances.count; index+=1) {
+    SpeechUtterance *utterance = getSpeechUtterance(sdt, index);
+
+    if (!utterance->started) {
+      utterance->started = 1;
+      utterance->start = msg->sent;
+
+      long int milliseconds = addSpeechLatency(
+        &speechLatencyStatistics.firstAudio, &utterance->requested, &msg->sent
+      );
+
+      logMessage(LOG_CATEGORY(SPEECH_EVENTS),
+                 "first audio after %ldms", milliseconds);
+      break;
+    }
+  }
+}
+
+static void
+updateSpeechThroughput (
+  SpeechDriverThread *sdt, const SpeechUtterance *utterance, const TimeValue *end
+) {
+  long int milliseconds = millisecondsBetween(&utterance->start, end);
+
+  // very short utterances are dominated by overhead rather than speaking
+  if (milliseconds < SPEECH_THROUGHPUT_MINIMUM_DURATION) return;
+  if (!utterance->count) return;
+
+  unsigned int rate = (utterance->count * 1000) / milliseconds;
+  if (!rate) rate = 1;
+
+  if (sdt->charactersPerSecond) {
+    // an exponential moving average which gives the newest sample a quarter
+    int difference = (int)rate - (int)sdt->charactersPerSecond;
+    rate = sdt->charactersPerSecond + (difference / 4);
+  }
+
+  sdt->charactersPerSecond = rate;
+  speechLatencyStatistics.throughput = rate;
+}
+
+static void
+finishSpeechUtterance (SpeechDriverThread *sdt, const SpeechMessage *msg) {
+  if (sdt->utterances.count > 0) {
+    SpeechUtterance *utterance = getSpeechUtterance(sdt, 0);
+
+    long int milliseconds = addSpeechLatency(
+      &speechLatencyStatistics.total, &utterance->requested, &msg->sent
+    );
+
+    logMessage(LOG_CATEGORY(SPEECH_EVENTS),
+               "utterance finished after %ldms", milliseconds);
+
+    updateSpeechThroughput(sdt, utterance, &msg->sent);
+    removeSpeechUtterance(sdt);
+
+    if (sdt->utterances.count > 0) {
+      utterance = getSpeechUtterance(sdt, 0);
+
+      // the next utterance can't have begun before this one finished
+      if (!utterance->started && (compareTimeValues(&msg->sent, &utterance->start) > 0)) {
+        utterance->start = msg->sent;
       }
+    }
+  }
+}
 
-      case MSG_SPEECH_LOCATION: {
-        SpeechSynthesizer *spk = sdt->speechSynthesizer;
-        SetSpeechLocationMethod *setLocation = spk->setLocation;
+static void
+locateSpeechUtterance (SpeechDriverThread *sdt, const SpeechMessage *msg) {
+  if (sdt->utterances.count > 0) {
+    SpeechUtterance *utterance = getSpeechUtterance(sdt, 0);
+    if (utterance->started) utterance->location = msg->arguments.speechLocation.location;
+  }
+}
 
-        if (setLocation) setLocation(spk, msg->arguments.speechLocation.location);
-        break;
+static size_t
+getSpeechUtteranceProgress (SpeechDriverThread *sdt, const SpeechUtterance *utterance) {
+  size_t progress = utterance->location;
+  unsigned int rate = sdt->charactersPerSecond;
+
+  if (rate) {
+    TimeValue now;
+    getMonotonicTime(&now);
+
+    long int milliseconds = millisecondsBetween(&utterance->start, &now);
+
+    if (milliseconds > 0) {
+      size_t spoken = ((unsigned long int)milliseconds * rate) / 1000;
+      if (spoken > progress) progress = spoken;
+    }
+  }
+
+  return MIN(progress, utterance->count);
+}
+
+static unsigned int
+getQueuedSpeechCharacters (SpeechDriverThread *sdt) {
+  unsigned int characters = 0;
+
+  for (unsigned int index=0; index<sdt->utterances.count; index+=1) {
+    const SpeechUtterance *utterance = getSpeechUtterance(sdt, index);
+    characters += utterance->count;
+
+    if (utterance->started) {
+      // only the utterance being spoken can have made progress
+      characters -= getSpeechUtteranceProgress(sdt, utterance);
+    }
+  }
+
+  {
+    unsigned int count = getQueueSize(sdt->requestQueue);
+
+    for (unsigned int index=0; index<count; index+=1) {
+      const SpeechRequest *req = getElementItem(getQueueElement(sdt->requestQueue, index));
+      if (!req) break;
+
+      switch (req->type) {
+        case REQ_MUTE_SPEECH:
+          characters = 0;
+          break;
+
+        case REQ_SAY_TEXT:
+          if (req->arguments.sayText.options & SAY_OPT_MUTE_FIRST) characters = 0;
+          characters += req->arguments.sayText.count;
+          break;
+
+        default:
+          break;
       }
+    }
+  }
 
-      default:
-        logMessage(LOG_CATEGORY(SPEECH_EVENTS), "unimplemented message: %u", msg->type);
-        break;
+  return characters;
+}
+
+int
+getSpeechDriverBacklog (SpeechDriverThread *sdt) {
+  if (!testThreadValidity(sdt)) return -1;
+
+  unsigned int rate = sdt->charactersPerSecond;
+  if (!rate) return -1;
+
+  return (getQueuedSpeechCharacters(sdt) * 1000) / rate;
+}
+
+unsigned int
+getSpeechDriverMuteCount (SpeechDriverThread *sdt) {
+  __sync_synchronize();
+  return sdt->muteCount;
+}
+
+static void sendSpeechRequest (SpeechDriverThread *sdt);
+static void releaseSpeechRequest (SpeechDriverThread *sdt, SpeechRequest *req);
+
+static void
+finishSpeechRequest (SpeechDriverThread *sdt) {
+  SpeechRequest *req = sdt->currentRequest;
+
+  if (req) {
+    sdt->currentRequest = NULL;
+
+#ifdef GOT_PTHREADS
+    addSpeechHandoffLatency(&speechHandoffStatistics.request, &req->sent, &req->received);
+#endif /* GOT_PTHREADS */
+
+    releaseSpeechRequest(sdt, req);
+  }
+}
+
+static void
+handleSpeechMessage (SpeechDriverThread *sdt, const SpeechMessage *msg) {
+  logSpeechMessage(msg, "handling");
+
+  switch (msg->type) {
+    case MSG_REQUEST_FINISHED:
+      finishSpeechRequest(sdt);
+      setIntegerResponse(sdt, msg->arguments.requestFinished.result);
+      sendSpeechRequest(sdt);
+      break;
+
+    case MSG_SPEECH_STARTED:
+      startSpeechUtterance(sdt, msg);
+      break;
+
+    case MSG_SPEECH_FINISHED: {
+      SpeechSynthesizer *spk = sdt->speechSynthesizer;
+      SetSpeechFinishedMethod *setFinished = spk->setFinished;
+
+      finishSpeechUtterance(sdt, msg);
+
+      if (setFinished) setFinished(spk);
+      break;
+    }
+
+    case MSG_SPEECH_LOCATION: {
+      SpeechSynthesizer *spk = sdt->speechSynthesizer;
+      SetSpeechLocationMethod *setLocation = spk->setLocation;
+
+      locateSpeechUtterance(sdt, msg);
+      if (setLocation) setLocation(spk, msg->arguments.speechLocation.location);
+      break;
     }
 
-    free(msg);
+    default:
+      logMessage(LOG_CATEGORY(SPEECH_EVENTS), "unimplemented message: %u", msg->type);
+      break;
   }
 }
 
 static int
-sendSpeechMessage (SpeechDriverThread *sdt, SpeechMessage *msg) {
+sendSpeechMessage (SpeechDriverThread *sdt, const SpeechMessage *msg) {
   logSpeechMessage(msg, "sending");
 
 #ifdef GOT_PTHREADS
-  return asyncSignalEvent(sdt->messageEvent, msg);
+  SpeechRing *ring = &sdt->messages.ring;
+  unsigned int index;
+
+  pthread_mutex_lock(&sdt->messages.lock);
+
+  if (!reserveSpeechRingEntry(ring, ARRAY_COUNT(sdt->messages.entries), &index)) {
+    // The main thread hasn't kept up so wait for it rather than lose
+    // a message. This is the only place where the driver thread blocks.
+    // Give up if the main thread is stopping, or, unless the main thread
+    // is waiting for it, if the message has waited for too long.
+    speechHandoffStatistics.stalled += 1;
+
+    TimePeriod period;
+    startTimePeriod(&period, SPEECH_MESSAGE_STALL_TIMEOUT);
+
+    do {
+      if (sdt->isBeingDestroyed ||
+          ((msg->type != MSG_REQUEST_FINISHED) && afterTimePeriod(&period, NULL))) {
+        speechHandoffStatistics.dropped += 1;
+        pthread_mutex_unlock(&sdt->messages.lock);
+        logMessage(LOG_CATEGORY(SPEECH_EVENTS), "message ring full - message dropped");
+        return 0;
+      }
+
+      approximateDelay(1);
+    } while (!reserveSpeechRingEntry(ring, ARRAY_COUNT(sdt->messages.entries), &index));
+  }
+
+  sdt->messages.entries[index] = *msg;
+  publishSpeechRingEntry(ring);
+  pthread_mutex_unlock(&sdt->messages.lock);
+
+  return asyncSignalEvent(sdt->messageEvent, NULL);
 #else /* GOT_PTHREADS */
   handleSpeechMessage(sdt, msg);
   return 1;
 #endif /* GOT_PTHREADS */
 }
 
-static SpeechMessage *
-newSpeechMessage (SpeechMessageType type, SpeechDatum *data) {
-  SpeechMessage *msg;
-  size_t size = sizeof(*msg) + getSpeechDataSize(data);
-
-  if ((msg = malloc(size))) {
-    memset(msg, 0, sizeof(*msg));
-    msg->type = type;
-    moveSpeechData(msg->data, data);
-    return msg;
-  } else {
-    logMallocError();
-  }
-
-  return NULL;
+static void
+initializeSpeechMessage (SpeechMessage *msg, SpeechMessageType type) {
+  memset(msg, 0, sizeof(*msg));
+  msg->type = type;
+  getMonotonicTime(&msg->sent);
 }
 
 static int
@@ -399,31 +879,31 @@ speechMessage_requestFinished (
   SpeechDriverThread *sdt,
   int result
 ) {
-  SpeechMessage *msg;
+  SpeechMessage msg;
 
-  if ((msg = newSpeechMessage(MSG_REQUEST_FINISHED, NULL))) {
-    msg->arguments.requestFinished.result = result;
-    if (sendSpeechMessage(sdt, msg)) return 1;
+  initializeSpeechMessage(&msg, MSG_REQUEST_FINISHED);
+  msg.arguments.requestFinished.result = result;
+  return sendSpeechMessage(sdt, &msg);
+}
 
-    free(msg);
-  }
+int
+speechMessage_speechStarted (
+  SpeechDriverThread *sdt
+) {
+  SpeechMessage msg;
 
-  return 0;
+  initializeSpeechMessage(&msg, MSG_SPEECH_STARTED);
+  return sendSpeechMessage(sdt, &msg);
 }
 
 int
 speechMessage_speechFinished (
   SpeechDriverThread *sdt
 ) {
-  SpeechMessage *msg;
+  SpeechMessage msg;
 
-  if ((msg = newSpeechMessage(MSG_SPEECH_FINISHED, NULL))) {
-    if (sendSpeechMessage(sdt, msg)) return 1;
-
-    free(msg);
-  }
-
-  return 0;
+  initializeSpeechMessage(&msg, MSG_SPEECH_FINISHED);
+  return sendSpeechMessage(sdt, &msg);
 }
 
 int
@@ -431,16 +911,11 @@ speechMessage_speechLocation (
   SpeechDriverThread *sdt,
   int location
 ) {
-  SpeechMessage *msg;
-
-  if ((msg = newSpeechMessage(MSG_SPEECH_LOCATION, NULL))) {
-    msg->arguments.speechLocation.location = location;
-    if (sendSpeechMessage(sdt, msg)) return 1;
-
-    free(msg);
-  }
+  SpeechMessage msg;
 
-  return 0;
+  initializeSpeechMessage(&msg, MSG_SPEECH_LOCATION);
+  msg.arguments.speechLocation.location = location;
+  return sendSpeechMessage(sdt, &msg);
 }
 
 static int
@@ -455,6 +930,10 @@ handleSpeechRequest (SpeechDriverThread *sdt, SpeechRequest *req) {
   logSpeechRequest(req, "handling");
 
   if (req) {
+    // The main thread owns the request again as soon as it has been
+    // responded to, so it mustn't be referenced after that.
+    getMonotonicTime(&req->received);
+
     switch (req->type) {
       case REQ_SAY_TEXT: {
         SayOptions options = req->arguments.sayText.options;
@@ -512,6 +991,11 @@ handleSpeechRequest (SpeechDriverThread *sdt, SpeechRequest *req) {
         break;
       }
 
+      case REQ_SYNCHRONIZE: {
+        sendIntegerResponse(sdt, 1);
+        break;
+      }
+
       case REQ_SET_VOLUME: {
         spk->setVolume(spk, req->arguments.setVolume.setting);
 
@@ -545,8 +1029,6 @@ handleSpeechRequest (SpeechDriverThread *sdt, SpeechRequest *req) {
         sendIntegerResponse(sdt, 0);
         break;
     }
-
-    free(req);
   } else {
     setThreadState(sdt, THD_STOPPING);
     sendIntegerResponse(sdt, 1);
@@ -575,33 +1057,173 @@ findSpeechRequestElement (SpeechDriverThread *sdt, SpeechRequestType type) {
   return findElement(sdt->requestQueue, testSpeechRequest, &tsr);
 }
 
+size_t
+formatSpeechQueueStatistics (char *buffer, size_t size) {
+  size_t length;
+
+  STR_BEGIN(buffer, size);
+  STR_PRINTF("speech queue: dropped=%lu merged=%lu",
+             speechQueueStatistics.dropped, speechQueueStatistics.merged);
+
+  STR_PRINTF(" residency (microseconds)[");
+  STR_FORMAT(formatHistogram, &speechQueueStatistics.residency);
+  STR_PRINTF("]");
+
+  length = STR_LENGTH;
+  STR_END;
+
+  return length;
+}
+
+void
+logSpeechQueueStatistics (void) {
+  char statistics[0X200];
+  formatSpeechQueueStatistics(statistics, sizeof(statistics));
+  logMessage(LOG_CATEGORY(PERFORMANCE), "%s", statistics);
+}
+
+void
+resetSpeechQueueStatistics (void) {
+  speechQueueStatistics.dropped = 0;
+  speechQueueStatistics.merged = 0;
+  resetHistogram(&speechQueueStatistics.residency);
+}
+
+static void
+addSpeechQueueResidency (const SpeechRequest *req) {
+  TimeValue now;
+  getMonotonicTime(&now);
+
+  int64_t microseconds = microsecondsBetween(&req->enqueued, &now);
+  if (microseconds < 0) microseconds = 0;
+  if (microseconds > UINT32_MAX) microseconds = UINT32_MAX;
+  addHistogramValue(&speechQueueStatistics.residency, microseconds);
+}
+
 static void
 removeSpeechRequests (SpeechDriverThread *sdt, SpeechRequestType type) {
   Element *element;
 
-  while ((element = findSpeechRequestElement(sdt, type))) deleteElement(element);
+  while ((element = findSpeechRequestElement(sdt, type))) {
+    logSpeechRequest(getElementItem(element), "dropping");
+    deleteElement(element);
+    speechQueueStatistics.dropped += 1;
+  }
 }
 
 static void
 muteSpeechRequestQueue (SpeechDriverThread *sdt) {
   removeSpeechRequests(sdt, REQ_SAY_TEXT);
   removeSpeechRequests(sdt, REQ_MUTE_SPEECH);
+
+  sdt->muteCount += 1;
+  __sync_synchronize();
 }
 
+static int
+coalesceSpeechRequest (SpeechDriverThread *sdt, const SpeechRequest *req) {
+  if (!testThreadValidity(sdt)) return 0;
+  unsigned int count = getQueueSize(sdt->requestQueue);
+
+  for (unsigned int index=0; index<count; index+=1) {
+    SpeechRequest *pending = getElementItem(getStackElement(sdt->requestQueue, index));
+    if (!pending) break;
+
+    if (pending->type == req->type) {
+      pending->arguments = req->arguments;
+      logSpeechRequest(pending, "coalescing");
+      speechQueueStatistics.merged += 1;
+      return 1;
+    }
+
+    switch (pending->type) {
+      case REQ_SET_VOLUME:
+      case REQ_SET_RATE:
+      case REQ_SET_PITCH:
+      case REQ_SET_PUNCTUATION:
+        continue;
+
+      default:
+        break;
+    }
+
+    break;
+  }
+
+  return 0;
+}
+
+#ifdef GOT_PTHREADS
+static int
+signalSpeechRequest (SpeechDriverThread *sdt) {
+  unsigned int attempts = 0;
+
+  while (!asyncSignalEvent(sdt->requestEvent, NULL)) {
+    if (++attempts == SPEECH_REQUEST_SIGNAL_ATTEMPTS) {
+      // It can't be taken back since the driver thread may already have it.
+      // Signal it again when the next request is enqueued.
+      logMessage(LOG_WARNING, "speech request not signalled");
+      sdt->requests.unsignalled = 1;
+      return 0;
+    }
+
+    approximateDelay(1);
+  }
+
+  sdt->requests.unsignalled = 0;
+  return 1;
+}
+#endif /* GOT_PTHREADS */
+
 static void
 sendSpeechRequest (SpeechDriverThread *sdt) {
   while (getQueueSize(sdt->requestQueue) > 0) {
     SpeechRequest *req = dequeueItem(sdt->requestQueue);
 
     logSpeechRequest(req, "sending");
+
+    if (req) {
+      addSpeechQueueResidency(req);
+
+      switch (req->type) {
+        case REQ_SAY_TEXT:
+          beginSpeechUtterance(sdt, req);
+          break;
+
+        case REQ_MUTE_SPEECH:
+          abandonSpeechUtterances(sdt);
+          break;
+
+        default:
+          break;
+      }
+    }
     setResponsePending(sdt);
+    sdt->currentRequest = req;
 
 #ifdef GOT_PTHREADS
-    if (!asyncSignalEvent(sdt->requestEvent, req)) {
-      if (req) free(req);
-      setIntegerResponse(sdt, 0);
-      continue;
+    {
+      SpeechRing *ring = &sdt->requests.ring;
+      unsigned int index;
+
+      if (reserveSpeechRingEntry(ring, ARRAY_COUNT(sdt->requests.entries), &index)) {
+        if (req) getMonotonicTime(&req->sent);
+        sdt->requests.entries[index] = req;
+        publishSpeechRingEntry(ring);
+
+        // once published, the request belongs to the driver thread and is
+        // released when its response arrives
+        signalSpeechRequest(sdt);
+        break;
+      } else {
+        logMessage(LOG_CATEGORY(SPEECH_EVENTS), "request ring full");
+      }
     }
+
+    sdt->currentRequest = NULL;
+    releaseSpeechRequest(sdt, req);
+    setIntegerResponse(sdt, 0);
+    continue;
 #else /* GOT_PTHREADS */
     handleSpeechRequest(sdt, req);
 #endif /* GOT_PTHREADS */
@@ -614,6 +1236,7 @@ static int
 enqueueSpeechRequest (SpeechDriverThread *sdt, SpeechRequest *req) {
   if (testThreadValidity(sdt)) {
     logSpeechRequest(req, "enqueuing");
+    if (req) getMonotonicTime(&req->enqueued);
 
     if (enqueueItem(sdt->requestQueue, req)) {
       if (sdt->response.type != RSP_PENDING) {
@@ -622,6 +1245,10 @@ enqueueSpeechRequest (SpeechDriverThread *sdt, SpeechRequest *req) {
         }
       }
 
+#ifdef GOT_PTHREADS
+      if (sdt->requests.unsignalled) signalSpeechRequest(sdt);
+#endif /* GOT_PTHREADS */
+
       return 1;
     }
   }
@@ -630,20 +1257,50 @@ enqueueSpeechRequest (SpeechDriverThread *sdt, SpeechRequest *req) {
 }
 
 static SpeechRequest *
-newSpeechRequest (SpeechRequestType type, SpeechDatum *data) {
+newSpeechRequest (SpeechDriverThread *sdt, SpeechRequestType type, SpeechDatum *data) {
   SpeechRequest *req;
   size_t size = sizeof(*req) + getSpeechDataSize(data);
 
-  if ((req = malloc(size))) {
-    memset(req, 0, sizeof(*req));
-    req->type = type;
-    moveSpeechData(req->data, data);
-    return req;
+  // Most requests (including the saying of a typical line) fit within a
+  // pooled slot, so they don't need to be allocated each time.
+  int isPooled = size <= SPEECH_REQUEST_SLOT_SIZE;
+
+  if (isPooled && sdt && sdt->requestPool.count) {
+    req = sdt->requestPool.entries[--sdt->requestPool.count];
+    speechHandoffStatistics.pooled += 1;
+  } else if ((req = malloc(isPooled? SPEECH_REQUEST_SLOT_SIZE: size))) {
+    speechHandoffStatistics.allocated += 1;
   } else {
     logMallocError();
+    return NULL;
   }
 
-  return NULL;
+  memset(req, 0, sizeof(*req));
+  req->type = type;
+  req->isPooled = isPooled;
+  moveSpeechData(req->data, data);
+  return req;
+}
+
+static void
+releaseSpeechRequest (SpeechDriverThread *sdt, SpeechRequest *req) {
+  if (req) {
+    if (req->isPooled) {
+      if (sdt->requestPool.count < ARRAY_COUNT(sdt->requestPool.entries)) {
+        sdt->requestPool.entries[sdt->requestPool.count++] = req;
+        return;
+      }
+    }
+
+    free(req);
+  }
+}
+
+static void
+emptySpeechRequestPool (SpeechDriverThread *sdt) {
+  while (sdt->requestPool.count) {
+    free(sdt->requestPool.entries[--sdt->requestPool.count]);
+  }
 }
 
 int
@@ -660,7 +1317,7 @@ speechRequest_sayText (
     {.address=attributes, .size=count},
   END_SPEECH_DATA
 
-  if ((req = newSpeechRequest(REQ_SAY_TEXT, data))) {
+  if ((req = newSpeechRequest(sdt, REQ_SAY_TEXT, data))) {
     req->arguments.sayText.text = data[0].address;
     req->arguments.sayText.length = length;
     req->arguments.sayText.count = count;
@@ -670,7 +1327,7 @@ speechRequest_sayText (
     if (options & SAY_OPT_MUTE_FIRST) muteSpeechRequestQueue(sdt);
     if (enqueueSpeechRequest(sdt, req)) return 1;
 
-    free(req);
+    releaseSpeechRequest(sdt, req);
   }
 
   return 0;
@@ -682,11 +1339,11 @@ speechRequest_muteSpeech (
 ) {
   SpeechRequest *req;
 
-  if ((req = newSpeechRequest(REQ_MUTE_SPEECH, NULL))) {
+  if ((req = newSpeechRequest(sdt, REQ_MUTE_SPEECH, NULL))) {
     muteSpeechRequestQueue(sdt);
     if (enqueueSpeechRequest(sdt, req)) return 1;
 
-    free(req);
+    releaseSpeechRequest(sdt, req);
   }
 
   return 0;
@@ -698,13 +1355,31 @@ speechRequest_drainSpeech (
 ) {
   SpeechRequest *req;
 
-  if ((req = newSpeechRequest(REQ_DRAIN_SPEECH, NULL))) {
+  if ((req = newSpeechRequest(sdt, REQ_DRAIN_SPEECH, NULL))) {
     if (enqueueSpeechRequest(sdt, req)) {
       awaitSpeechResponse(sdt, SPEECH_RESPONSE_WAIT_TIMEOUT);
       return 1;
     }
 
-    free(req);
+    releaseSpeechRequest(sdt, req);
+  }
+
+  return 0;
+}
+
+int
+speechRequest_synchronize (
+  SpeechDriverThread *sdt
+) {
+  SpeechRequest *req;
+
+  if ((req = newSpeechRequest(sdt, REQ_SYNCHRONIZE, NULL))) {
+    if (enqueueSpeechRequest(sdt, req)) {
+      awaitSpeechResponse(sdt, SPEECH_RESPONSE_WAIT_TIMEOUT);
+      return 1;
+    }
+
+    releaseSpeechRequest(sdt, req);
   }
 
   return 0;
@@ -717,11 +1392,17 @@ speechRequest_setVolume (
 ) {
   SpeechRequest *req;
 
-  if ((req = newSpeechRequest(REQ_SET_VOLUME, NULL))) {
+  if ((req = newSpeechRequest(sdt, REQ_SET_VOLUME, NULL))) {
     req->arguments.setVolume.setting = setting;
+
+    if (coalesceSpeechRequest(sdt, req)) {
+      releaseSpeechRequest(sdt, req);
+      return 1;
+    }
+
     if (enqueueSpeechRequest(sdt, req)) return 1;
 
-    free(req);
+    releaseSpeechRequest(sdt, req);
   }
 
   return 0;
@@ -734,11 +1415,17 @@ speechRequest_setRate (
 ) {
   SpeechRequest *req;
 
-  if ((req = newSpeechRequest(REQ_SET_RATE, NULL))) {
+  if ((req = newSpeechRequest(sdt, REQ_SET_RATE, NULL))) {
     req->arguments.setRate.setting = setting;
+
+    if (coalesceSpeechRequest(sdt, req)) {
+      releaseSpeechRequest(sdt, req);
+      return 1;
+    }
+
     if (enqueueSpeechRequest(sdt, req)) return 1;
 
-    free(req);
+    releaseSpeechRequest(sdt, req);
   }
 
   return 0;
@@ -751,11 +1438,17 @@ speechRequest_setPitch (
 ) {
   SpeechRequest *req;
 
-  if ((req = newSpeechRequest(REQ_SET_PITCH, NULL))) {
+  if ((req = newSpeechRequest(sdt, REQ_SET_PITCH, NULL))) {
     req->arguments.setPitch.setting = setting;
+
+    if (coalesceSpeechRequest(sdt, req)) {
+      releaseSpeechRequest(sdt, req);
+      return 1;
+    }
+
     if (enqueueSpeechRequest(sdt, req)) return 1;
 
-    free(req);
+    releaseSpeechRequest(sdt, req);
   }
 
   return 0;
@@ -768,11 +1461,17 @@ speechRequest_setPunctuation (
 ) {
   SpeechRequest *req;
 
-  if ((req = newSpeechRequest(REQ_SET_PUNCTUATION, NULL))) {
+  if ((req = newSpeechRequest(sdt, REQ_SET_PUNCTUATION, NULL))) {
     req->arguments.setPunctuation.setting = setting;
+
+    if (coalesceSpeechRequest(sdt, req)) {
+      releaseSpeechRequest(sdt, req);
+      return 1;
+    }
+
     if (enqueueSpeechRequest(sdt, req)) return 1;
 
-    free(req);
+    releaseSpeechRequest(sdt, req);
   }
 
   return 0;
@@ -805,16 +1504,43 @@ ASYNC_CONDITION_TESTER(testSpeechDriverThreadStopping) {
 
 ASYNC_EVENT_CALLBACK(handleSpeechMessageEvent) {
   SpeechDriverThread *sdt = parameters->eventData;
-  SpeechMessage *msg = parameters->signalData;
+  SpeechRing *ring = &sdt->messages.ring;
+  unsigned int index;
 
-  handleSpeechMessage(sdt, msg);
+  speechHandoffStatistics.wakeups += 1;
+
+  while (getSpeechRingEntry(ring, ARRAY_COUNT(sdt->messages.entries), &index)) {
+    // copy it so that its entry can be reused while it's being handled
+    const SpeechMessage msg = sdt->messages.entries[index];
+    releaseSpeechRingEntry(ring);
+
+    {
+      TimeValue now;
+      getMonotonicTime(&now);
+      addSpeechHandoffLatency(&speechHandoffStatistics.message, &msg.sent, &now);
+    }
+
+    speechHandoffStatistics.messages += 1;
+    handleSpeechMessage(sdt, &msg);
+
+    if (msg.type == MSG_REQUEST_FINISHED) {
+      // Let whoever's awaiting this response see it before the next one.
+      if (ring->head != ring->tail) asyncSignalEvent(sdt->messageEvent, NULL);
+      break;
+    }
+  }
 }
 
 ASYNC_EVENT_CALLBACK(handleSpeechRequestEvent) {
   SpeechDriverThread *sdt = parameters->eventData;
-  SpeechRequest *req = parameters->signalData;
+  SpeechRing *ring = &sdt->requests.ring;
+  unsigned int index;
 
-  handleSpeechRequest(sdt, req);
+  while (getSpeechRingEntry(ring, ARRAY_COUNT(sdt->requests.entries), &index)) {
+    SpeechRequest *req = sdt->requests.entries[index];
+    releaseSpeechRingEntry(ring);
+    handleSpeechRequest(sdt, req);
+  }
 }
 
 static void
@@ -829,7 +1555,7 @@ THREAD_FUNCTION(runSpeechDriverThread) {
 
   setThreadState(sdt, THD_STARTING);
 
-  if ((sdt->requestEvent = asyncNewEvent(handleSpeechRequestEvent, sdt))) {
+  if ((sdt->requestEvent = asyncNewCoalescingEvent(handleSpeechRequestEvent, sdt))) {
     if (startSpeechDriver(sdt)) {
       setThreadReady(sdt);
       asyncWaitFor(testSpeechDriverThreadStopping, sdt);
@@ -858,9 +1584,10 @@ THREAD_FUNCTION(runSpeechDriverThread) {
 static void
 deallocateSpeechRequest (void *item, void *data) {
   SpeechRequest *req = item;
+  SpeechDriverThread *sdt = data;
 
   logSpeechRequest(req, "unqueuing");
-  free(req);
+  releaseSpeechRequest(sdt, req);
 }
 
 int
@@ -879,10 +1606,13 @@ constructSpeechDriverThread (
     sdt->driverParameters = parameters;
 
     if ((sdt->requestQueue = newQueue(deallocateSpeechRequest, NULL))) {
+      setQueueData(sdt->requestQueue, sdt);
       spk->driver.thread = sdt;
 
 #ifdef GOT_PTHREADS
-      if ((sdt->messageEvent = asyncNewEvent(handleSpeechMessageEvent, sdt))) {
+      pthread_mutex_init(&sdt->messages.lock, NULL);
+
+      if ((sdt->messageEvent = asyncNewCoalescingEvent(handleSpeechMessageEvent, sdt))) {
         pthread_t threadIdentifier;
         int createError = createThread("speech-driver",
                                        &threadIdentifier, NULL,
@@ -912,6 +1642,8 @@ constructSpeechDriverThread (
       } else {
         logMessage(LOG_CATEGORY(SPEECH_EVENTS), "response event construction failure");
       }
+
+      pthread_mutex_destroy(&sdt->messages.lock);
 #else /* GOT_PTHREADS */
       if (startSpeechDriver(sdt)) {
         setThreadReady(sdt);
@@ -921,6 +1653,7 @@ constructSpeechDriverThread (
 
       spk->driver.thread = NULL;
       destroyQueue(sdt->requestQueue);
+      emptySpeechRequestPool(sdt);
     }
 
     free(sdt);
@@ -950,6 +1683,7 @@ destroySpeechDriverThread (SpeechSynthesizer *spk) {
   }
 
   if (sdt->messageEvent) asyncDiscardEvent(sdt->messageEvent);
+  pthread_mutex_destroy(&sdt->messages.lock);
 #else /* GOT_PTHREADS */
   stopSpeechDriver(sdt);
   setThreadState(sdt, THD_FINISHED);
@@ -957,6 +1691,9 @@ destroySpeechDriverThread (SpeechSynthesizer *spk) {
 
   sdt->speechSynthesizer->driver.thread = NULL;
   destroyQueue(sdt->requestQueue);
+
+  releaseSpeechRequest(sdt, sdt->currentRequest);
+  emptySpeechRequestPool(sdt);
   free(sdt);
 }
 #endif /* ENABLE_SPEECH_SUPPORT */
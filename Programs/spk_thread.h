@@ -50,6 +50,10 @@ extern int speechRequest_drainSpeech (
   SpeechDriverThread *sdt
 );
 
+extern int speechRequest_synchronize (
+  SpeechDriverThread *sdt
+);
+
 extern int speechRequest_setVolume (
   SpeechDriverThread *sdt,
   unsigned char setting
@@ -70,6 +74,18 @@ extern int speechRequest_setPunctuation (
   SpeechPunctuation setting
 );
 
+extern int getSpeechDriverBacklog (
+  SpeechDriverThread *sdt
+);
+
+extern unsigned int getSpeechDriverMuteCount (
+  SpeechDriverThread *sdt
+);
+
+extern int speechMessage_speechStarted (
+  SpeechDriverThread *sdt
+);
+
 extern int speechMessage_speechFinished (
   SpeechDriverThread *sdt
 );
@@ -33,10 +33,12 @@
 #include "file.h"
 #include "parse.h"
 #include "async_wait.h"
+#include "timing.h"
 
 static char *opt_textString;
 static char *opt_speechVolume;
 static char *opt_speechRate;
+static char *opt_benchmarkCount;
 char *opt_pcmDevice;
 char *opt_driversDirectory;
 
@@ -62,6 +64,13 @@ BEGIN_COMMAND_LINE_OPTIONS(programOptions)
     .description = "Floating-point speech rate multiplier."
   },
 
+  { .word = "benchmark",
+    .letter = 'b',
+    .argument = "count",
+    .setting.string = &opt_benchmarkCount,
+    .description = "Measure the request/message handoff to the driver thread."
+  },
+
   { .word = "device",
     .letter = 'd',
     .argument = "device",
@@ -120,6 +129,37 @@ sayLine (const LineHandlerParameters *parameters) {
   return 1;
 }
 
+static void
+benchmark (SpeechSynthesizer *spk, int count, const char *text) {
+  TimeValue start;
+  TimeValue end;
+
+  resetSpeechHandoffStatistics();
+  getMonotonicTime(&start);
+
+  for (int index=0; index<count; index+=1) {
+    sayString(spk, text, SAY_OPT_MUTE_FIRST);
+    synchronizeSpeech(spk);
+  }
+
+  getMonotonicTime(&end);
+  muteSpeech(spk, "benchmark");
+
+  {
+    long int milliseconds = millisecondsBetween(&start, &end);
+    if (!milliseconds) milliseconds = 1;
+
+    printf("%d round trips in %ldms (%ld/s)\n",
+           count, milliseconds, ((long int)count * 1000 / milliseconds));
+  }
+
+  {
+    char statistics[0X300];
+    formatSpeechHandoffStatistics(statistics, sizeof(statistics));
+    printf("%s\n", statistics);
+  }
+}
+
 int
 main (int argc, char *argv[]) {
   PROCESS_COMMAND_LINE(programDescriptor, argc, argv);
@@ -130,6 +170,7 @@ main (int argc, char *argv[]) {
 
   int speechVolume = SPK_VOLUME_DEFAULT;
   int speechRate = SPK_RATE_DEFAULT;
+  int benchmarkCount = 0;
 
   if (opt_speechVolume && *opt_speechVolume) {
     static const int minimum = 0;
@@ -151,6 +192,15 @@ main (int argc, char *argv[]) {
     }
   }
 
+  if (opt_benchmarkCount && *opt_benchmarkCount) {
+    static const int minimum = 1;
+
+    if (!validateInteger(&benchmarkCount, opt_benchmarkCount, &minimum, NULL)) {
+      logMessage(LOG_ERR, "%s: %s", "invalid benchmark count", opt_benchmarkCount);
+      return PROG_EXIT_SYNTAX;
+    }
+  }
+
   if ((speech = loadSpeechDriver(driverCode, &driverObject, opt_driversDirectory))) {
     const char *const *parameterNames = speech->parameters;
     char **parameterSettings;
@@ -216,7 +266,10 @@ main (int argc, char *argv[]) {
       setSpeechVolume(&spk, speechVolume, 0);
       setSpeechRate(&spk, speechRate, 0);
 
-      if (opt_textString && *opt_textString) {
+      if (benchmarkCount) {
+        benchmark(&spk, benchmarkCount,
+                  ((opt_textString && *opt_textString)? opt_textString: "test"));
+      } else if (opt_textString && *opt_textString) {
         say(&spk, opt_textString);
       } else {
         processLines(stdin, sayLine, (void *)&spk);
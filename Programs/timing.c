@@ -271,6 +271,18 @@ millisecondsBetween (const TimeValue *from, const TimeValue *to) {
        + (elapsed.nanoseconds / NSECS_PER_MSEC);
 }
 
+int64_t
+microsecondsBetween (const TimeValue *from, const TimeValue *to) {
+  TimeValue elapsed = {
+    .seconds = to->seconds - from->seconds,
+    .nanoseconds = to->nanoseconds - from->nanoseconds
+  };
+
+  normalizeTimeValue(&elapsed);
+  return (elapsed.seconds * USECS_PER_SEC)
+       + (elapsed.nanoseconds / NSECS_PER_USEC);
+}
+
 long int
 millisecondsTillNextSecond (const TimeValue *reference) {
   TimeValue time = *reference;
@@ -21,8 +21,13 @@
 #include <string.h>
 
 #include "log.h"
+#include "strfmt.h"
 #include "parameters.h"
 #include "thread.h"
+#include "lock.h"
+#include "queue.h"
+#include "timing.h"
+#include "histogram.h"
 #include "async_handle.h"
 #include "async_alarm.h"
 #include "async_event.h"
@@ -44,6 +49,15 @@ flushNoteDevice (void) {
   return noteMethods->flush(noteDevice);
 }
 
+static void
+cancelNoteDevice (void) {
+  if (noteDevice) {
+    if (noteMethods->cancel) {
+      noteMethods->cancel(noteDevice);
+    }
+  }
+}
+
 static void
 closeTuneDevice (void) {
   if (tuneDeviceCloseTimer) {
@@ -100,6 +114,7 @@ typedef enum {
 
 typedef struct {
   TuneRequestType type;
+  TimeValue requested;
 
   union {
     struct {
@@ -126,6 +141,69 @@ typedef struct {
   } parameters;
 } TuneRequest;
 
+static struct {
+  unsigned long int superseded;
+  Histogram start;
+} tuneLatencyStatistics;
+
+size_t
+formatTuneLatencyStatistics (char *buffer, size_t size) {
+  size_t length;
+
+  STR_BEGIN(buffer, size);
+  STR_PRINTF("tune latency (milliseconds): superseded=%lu",
+             tuneLatencyStatistics.superseded);
+
+  STR_PRINTF(" start[");
+  STR_FORMAT(formatHistogram, &tuneLatencyStatistics.start);
+  STR_PRINTF("]");
+
+  length = STR_LENGTH;
+  STR_END;
+
+  return length;
+}
+
+void
+logTuneLatencyStatistics (void) {
+  char statistics[0X200];
+  formatTuneLatencyStatistics(statistics, sizeof(statistics));
+  logMessage(LOG_CATEGORY(PERFORMANCE), "%s", statistics);
+}
+
+void
+resetTuneLatencyStatistics (void) {
+  tuneLatencyStatistics.superseded = 0;
+  resetHistogram(&tuneLatencyStatistics.start);
+}
+
+static void
+addTuneStartLatency (long int milliseconds) {
+  if (milliseconds < 0) milliseconds = 0;
+  addHistogramValue(&tuneLatencyStatistics.start, milliseconds);
+}
+
+static void
+addTuneSuperseded (void) {
+  tuneLatencyStatistics.superseded += 1;
+}
+
+static void reportTuneStarted (const TimeValue *requested);
+static void reportTuneSuperseded (void);
+static int isTuneSuperseded (void);
+
+static int
+stopSupersededTune (TunePlayOptions options, int started) {
+  if (!(options & TPO_SUPERSEDE)) return 0;
+  if (!isTuneSuperseded()) return 0;
+
+  /* drop whatever has already been buffered so that the new tune starts now */
+  if (started) cancelNoteDevice();
+
+  reportTuneSuperseded();
+  return 1;
+}
+
 static void
 handleTuneRequest_setDevice (const NoteMethods *methods) {
   if (methods != noteMethods) {
@@ -135,21 +213,73 @@ handleTuneRequest_setDevice (const NoteMethods *methods) {
 }
 
 static void
-handleTuneRequest_playNotes (const NoteElement *tune) {
+handleTuneRequest_playNotes (
+  const NoteElement *tune, TunePlayOptions options, const TimeValue *requested
+) {
+  const NoteElement *first = tune;
+
   while (tune->duration) {
+    if (stopSupersededTune(options, (tune != first))) return;
     if (!openTuneDevice()) return;
     if (!noteMethods->note(noteDevice, tune->duration, tune->note)) return;
+    if (tune == first) reportTuneStarted(requested);
     tune += 1;
   }
 
   flushNoteDevice();
 }
 
+typedef struct {
+  const TimeValue *requested;
+  TunePlayOptions options;
+  unsigned started:1;
+} TonesProgressData;
+
+static int
+handleTonesProgress (void *data) {
+  TonesProgressData *tpd = data;
+
+  if (!tpd->started) {
+    tpd->started = 1;
+    reportTuneStarted(tpd->requested);
+  }
+
+  return !stopSupersededTune(tpd->options, 1);
+}
+
 static void
-handleTuneRequest_playTones (const ToneElement *tune) {
+handleTuneRequest_playTones (
+  const ToneElement *tune, TunePlayOptions options, const TimeValue *requested
+) {
+  const ToneElement *first = tune;
+
+  if (!tune->duration) return;
+  if (!openTuneDevice()) return;
+
+  if (noteMethods->tones) {
+    /* a device which can play the whole tune at once is asked to do so,
+     * and tells us as it goes so that the tune can still be superseded */
+    if (stopSupersededTune(options, 0)) return;
+
+    TonesProgressData tpd = {
+      .requested = requested,
+      .options = options,
+      .started = 0
+    };
+
+    int played = noteMethods->tones(noteDevice, tune, handleTonesProgress, &tpd);
+
+    if (played >= 0) {
+      if (played) flushNoteDevice();
+      return;
+    }
+  }
+
   while (tune->duration) {
+    if (stopSupersededTune(options, (tune != first))) return;
     if (!openTuneDevice()) return;
     if (!noteMethods->tone(noteDevice, tune->duration, tune->frequency)) return;
+    if (tune == first) reportTuneStarted(requested);
     tune += 1;
   }
 
@@ -179,7 +309,7 @@ handleTuneRequest (TuneRequest *req) {
         TunePlayOptions options = req->parameters.playNotes.options;
 
         currentlyPlayingNotes = tune;
-        handleTuneRequest_playNotes(tune);
+        handleTuneRequest_playNotes(tune, options, &req->requested);
         currentlyPlayingNotes = NULL;
 
         if (options & TPO_FREE) free((void *)tune);
@@ -191,7 +321,7 @@ handleTuneRequest (TuneRequest *req) {
         TunePlayOptions options = req->parameters.playTones.options;
 
         currentlyPlayingTones = tune;
-        handleTuneRequest_playTones(tune);
+        handleTuneRequest_playTones(tune, options, &req->requested);
         currentlyPlayingTones = NULL;
 
         if (options & TPO_FREE) free((void *)tune);
@@ -229,6 +359,15 @@ static pthread_t tuneThreadIdentifier;
 static AsyncEvent *tuneRequestEvent = NULL;
 static AsyncEvent *tuneMessageEvent = NULL;
 
+/* requests which have been sent to the tune thread but not yet handled */
+static Queue *pendingTuneRequests = NULL;
+
+static LockDescriptor *
+getPendingTuneRequestsLock (void) {
+  static LockDescriptor *lock = NULL;
+  return getLockDescriptor(&lock, "pending-tune-requests");
+}
+
 static void
 setTuneThreadState (TuneThreadState newState) {
   TuneThreadState oldState = tuneThreadState;
@@ -250,7 +389,9 @@ ASYNC_CONDITION_TESTER(testTuneThreadStopped) {
 }
 
 typedef enum {
-  TUNE_MSG_SET_STATE
+  TUNE_MSG_SET_STATE,
+  TUNE_MSG_TUNE_STARTED,
+  TUNE_MSG_TUNE_SUPERSEDED
 } TuneMessageType;
 
 typedef struct {
@@ -260,6 +401,10 @@ typedef struct {
     struct {
       TuneThreadState state;
     } setState;
+
+    struct {
+      long int latency;
+    } tuneStarted;
   } parameters;
 } TuneMessage;
 
@@ -269,6 +414,14 @@ handleTuneMessage (TuneMessage *msg) {
     case TUNE_MSG_SET_STATE:
       setTuneThreadState(msg->parameters.setState.state);
       break;
+
+    case TUNE_MSG_TUNE_STARTED:
+      addTuneStartLatency(msg->parameters.tuneStarted.latency);
+      break;
+
+    case TUNE_MSG_TUNE_SUPERSEDED:
+      addTuneSuperseded();
+      break;
   }
 
   free(msg);
@@ -310,6 +463,87 @@ sendTuneThreadState (TuneThreadState state) {
   }
 }
 
+static void
+sendTuneStarted (long int latency) {
+  TuneMessage *msg;
+
+  if ((msg = newTuneMessage(TUNE_MSG_TUNE_STARTED))) {
+    msg->parameters.tuneStarted.latency = latency;
+    if (!sendTuneMessage(msg)) free(msg);
+  }
+}
+
+static void
+sendTuneSuperseded (void) {
+  TuneMessage *msg;
+
+  if ((msg = newTuneMessage(TUNE_MSG_TUNE_SUPERSEDED))) {
+    if (!sendTuneMessage(msg)) free(msg);
+  }
+}
+
+static int
+testSupersedingTuneRequest (void) {
+  int found = 0;
+  LockDescriptor *lock = getPendingTuneRequestsLock();
+
+  obtainExclusiveLock(lock);
+    if (pendingTuneRequests) {
+      Element *element = getQueueHead(pendingTuneRequests);
+
+      if (element) {
+        const TuneRequest *req = getElementItem(element);
+
+        switch (req->type) {
+          case TUNE_REQ_PLAY_NOTES:
+            found = !!(req->parameters.playNotes.options & TPO_SUPERSEDE);
+            break;
+
+          case TUNE_REQ_PLAY_TONES:
+            found = !!(req->parameters.playTones.options & TPO_SUPERSEDE);
+            break;
+
+          default:
+            break;
+        }
+      }
+    }
+  releaseLock(lock);
+
+  return found;
+}
+
+static void
+addPendingTuneRequest (TuneRequest *req) {
+  LockDescriptor *lock = getPendingTuneRequestsLock();
+
+  obtainExclusiveLock(lock);
+    if (!pendingTuneRequests) pendingTuneRequests = newQueue(NULL, NULL);
+    if (pendingTuneRequests) enqueueItem(pendingTuneRequests, req);
+  releaseLock(lock);
+}
+
+static void
+removePendingTuneRequest (TuneRequest *req) {
+  LockDescriptor *lock = getPendingTuneRequestsLock();
+
+  obtainExclusiveLock(lock);
+    if (pendingTuneRequests) deleteItem(pendingTuneRequests, req);
+  releaseLock(lock);
+}
+
+static void
+destroyPendingTuneRequests (void) {
+  LockDescriptor *lock = getPendingTuneRequestsLock();
+
+  obtainExclusiveLock(lock);
+    if (pendingTuneRequests) {
+      destroyQueue(pendingTuneRequests);
+      pendingTuneRequests = NULL;
+    }
+  releaseLock(lock);
+}
+
 static void
 finishTuneRequest_stop (void) {
   setTuneThreadState(TUNE_THREAD_STOPPING);
@@ -333,6 +567,7 @@ ASYNC_EVENT_CALLBACK(handleTuneRequestEvent) {
       default:
         break;
     }
+    removePendingTuneRequest(req);
   } else {
     finish = finishTuneRequest_stop;
   }
@@ -380,11 +615,54 @@ startTuneThread (void) {
 }
 #endif /* GOT_PTHREADS */
 
+static void
+reportTuneStarted (const TimeValue *requested) {
+  TimeValue now;
+  long int latency;
+
+  getMonotonicTime(&now);
+  latency = millisecondsBetween(requested, &now);
+
+#ifdef GOT_PTHREADS
+  if (tuneThreadState >= TUNE_THREAD_RUNNING) {
+    sendTuneStarted(latency);
+    return;
+  }
+#endif /* GOT_PTHREADS */
+
+  addTuneStartLatency(latency);
+}
+
+static void
+reportTuneSuperseded (void) {
+#ifdef GOT_PTHREADS
+  if (tuneThreadState >= TUNE_THREAD_RUNNING) {
+    sendTuneSuperseded();
+    return;
+  }
+#endif /* GOT_PTHREADS */
+
+  addTuneSuperseded();
+}
+
+static int
+isTuneSuperseded (void) {
+#ifdef GOT_PTHREADS
+  return testSupersedingTuneRequest();
+#else /* GOT_PTHREADS */
+  return 0;
+#endif /* GOT_PTHREADS */
+}
+
 static int
 sendTuneRequest (TuneRequest *req) {
 #ifdef GOT_PTHREADS
   if (startTuneThread()) {
-    return asyncSignalEvent(tuneRequestEvent, req);
+    if (req) addPendingTuneRequest(req);
+    if (asyncSignalEvent(tuneRequestEvent, req)) return 1;
+
+    if (req) removePendingTuneRequest(req);
+    return 0;
   }
 #endif /* GOT_PTHREADS */
 
@@ -401,6 +679,7 @@ exitTunes (void *data) {
     asyncWaitFor(testTuneThreadStopped, NULL);
   }
 
+  destroyPendingTuneRequests();
   tuneThreadState = TUNE_THREAD_NONE;
 #endif /* GOT_PTHREADS */
 
@@ -419,6 +698,7 @@ newTuneRequest (TuneRequestType type) {
   if ((req = malloc(sizeof(*req)))) {
     memset(req, 0, sizeof(*req));
     req->type = type;
+    getMonotonicTime(&req->requested);
     return req;
   } else {
     logMallocError();
@@ -612,6 +612,11 @@ setTuneSourceName (TuneBuilder *tb, const char *name) {
   tb->source.name = name;
 }
 
+const char *
+getTuneSourceName (TuneBuilder *tb) {
+  return tb->source.name;
+}
+
 void
 setTuneSourceIndex (TuneBuilder *tb, unsigned int index) {
   tb->source.index = index;
@@ -46,6 +46,8 @@
 #include "api_control.h"
 #include "options.h"
 #include "core.h"
+#include "brl_latency.h"
+#include "update_profile.h"
 
 static void
 overlayAttributesUnderline (unsigned char *cell, unsigned char attributes) {
@@ -808,6 +810,18 @@ static int oldwiny;
 
 #ifdef ENABLE_SPEECH_SUPPORT
 static int wasAutospeaking;
+static int autospeakChangesSkipped;
+
+static int
+getAutospeakBacklogExcess (void) {
+  if (!autospeakMaximumBacklog) return 0;
+
+  int backlog = getSpeechBacklog(&spk);
+  if (backlog < 0) return 0;
+
+  backlog -= autospeakMaximumBacklog;
+  return MAX(backlog, 0);
+}
 
 void
 autospeak (AutospeakMode mode) {
@@ -833,6 +847,7 @@ autospeak (AutospeakMode mode) {
     int count = newWidth;
     const char *reason = NULL;
     int indent = 0;
+    int throttle = 0;
 
     if (mode == AUTOSPEAK_FORCE) {
       reason = "current line";
@@ -862,7 +877,6 @@ autospeak (AutospeakMode mode) {
               isSameRow(newCharacters, oldCharacters, newX, isSameText)) {
             int oldLength = oldWidth;
             int newLength = newWidth;
-            int x = newX;
 
             while (oldLength > oldX) {
               if (!iswspace(oldCharacters[oldLength-1].text)) break;
@@ -876,34 +890,30 @@ autospeak (AutospeakMode mode) {
             }
             if (newLength < newWidth) newLength += 1;
 
-            while (1) {
-              int done = 1;
-
-              if (x < newLength) {
-                if (isSameRow(newCharacters+x, oldCharacters+oldX, newWidth-x, isSameText)) {
-                  column = newX;
-                  count = prefs.autospeakInsertedCharacters? (x - newX): 0;
-                  reason = "characters inserted after cursor";
-                  goto autospeak;
-                }
+            int length = newWidth - newX;
+            unsigned char inserted[length];
+            unsigned char deleted[length];
 
-                done = 0;
-              }
+            findShiftedMatches(oldCharacters+oldX, newCharacters+newX, length, inserted);
+            findShiftedMatches(newCharacters+newX, oldCharacters+oldX, length, deleted);
 
-              if (x < oldLength) {
-                if (isSameRow(newCharacters+newX, oldCharacters+x, oldWidth-x, isSameText)) {
-                  characters = oldCharacters;
-                  column = oldX;
-                  count = prefs.autospeakDeletedCharacters? (x - oldX): 0;
-                  reason = "characters deleted after cursor";
-                  goto autospeak;
-                }
+            for (int x=newX; ((x < newLength) || (x < oldLength)); x+=1) {
+              int shift = x - newX;
 
-                done = 0;
+              if ((x < newLength) && inserted[shift]) {
+                column = newX;
+                count = prefs.autospeakInsertedCharacters? shift: 0;
+                reason = "characters inserted after cursor";
+                goto autospeak;
               }
 
-              if (done) break;
-              x += 1;
+              if ((x < oldLength) && deleted[shift]) {
+                characters = oldCharacters;
+                column = oldX;
+                count = prefs.autospeakDeletedCharacters? shift: 0;
+                reason = "characters deleted after cursor";
+                goto autospeak;
+              }
             }
           }
 
@@ -965,6 +975,7 @@ autospeak (AutospeakMode mode) {
         count -= column;
         if (!prefs.autospeakReplacedCharacters) count = 0;
         reason = "characters replaced";
+        throttle = 1;
       } else if ((newY == ses->winy) && ((newX != oldX) || (newY != oldY)) && onScreen) {
         column = newX;
         count = prefs.autospeakSelectedCharacter? 1: 0;
@@ -1000,6 +1011,9 @@ autospeak (AutospeakMode mode) {
             }
           }
         }
+      } else if (autospeakChangesSkipped) {
+        reason = "skipped changes";
+        throttle = 1;
       } else {
         count = 0;
       }
@@ -1009,6 +1023,24 @@ autospeak (AutospeakMode mode) {
     if (scr.quality >= autospeakMinimumScreenContentQuality) {
       if (mode == AUTOSPEAK_SILENT) count = 0;
 
+      if (count && throttle) {
+        int excess = getAutospeakBacklogExcess();
+
+        if (excess) {
+          logMessage(LOG_CATEGORY(SPEECH_EVENTS),
+            "autospeak skipped: %s: backlog exceeded by %dms",
+            reason, excess
+          );
+
+          /* speak the line as it is once the backlog has drained */
+          autospeakChangesSkipped = 1;
+          scheduleUpdateIn("autospeak backlog", excess);
+          count = 0;
+        }
+      }
+
+      if (count) autospeakChangesSkipped = 0;
+
       characters += column;
       int interrupt = 1;
 
@@ -1076,8 +1108,78 @@ reportBrailleWindowMoved (void) {
   report(REPORT_BRAILLE_WINDOW_MOVED, &data);
 }
 
-int
-writeBrailleWindow (BrailleDisplay *brl, const wchar_t *text, unsigned char quality) {
+static unsigned int brailleWindowWriteCount = 0;
+static int updateSuspendCount;
+
+static struct {
+  unsigned char isPending:1;
+  unsigned char isPriority:1;
+  unsigned char quality;
+  int cursor;
+  TimeValue queueTime;
+
+  TimeValue linkFreeTime;
+  TimeValue sendTime;
+  int cursorRow;
+  AsyncHandle alarm;
+
+  unsigned char *cells;
+  wchar_t *text;
+  size_t size;
+} bos = {
+  .cursorRow = -1
+};
+
+static void invalidateBrailleWindowFingerprint (void);
+
+static void
+advanceBrailleLinkTime (void) {
+  if (brl.writeDelay) {
+    TimeValue now;
+    getMonotonicTime(&now);
+
+    if (compareTimeValues(&bos.linkFreeTime, &now) < 0) bos.linkFreeTime = now;
+    adjustTimeValue(&bos.linkFreeTime, brl.writeDelay);
+    brl.writeDelay = 0;
+  }
+}
+
+static void
+discardPendingBrailleWindow (void) {
+  if (bos.alarm) {
+    asyncCancelRequest(bos.alarm);
+    bos.alarm = NULL;
+  }
+
+  if (bos.isPending) {
+    bos.isPending = 0;
+    addUpdateProfileDroppedFrame();
+    invalidateBrailleWindowFingerprint();
+  }
+}
+
+void
+resetBrailleWindow (void) {
+  discardPendingBrailleWindow();
+
+  if (bos.cells) {
+    free(bos.cells);
+    bos.cells = NULL;
+  }
+
+  if (bos.text) {
+    free(bos.text);
+    bos.text = NULL;
+  }
+
+  bos.size = 0;
+  bos.isPriority = 0;
+  bos.cursorRow = -1;
+  invalidateBrailleWindowFingerprint();
+}
+
+static int
+sendBrailleWindow (BrailleDisplay *brl, const wchar_t *text, unsigned char quality) {
   {
     const BrailleWindowUpdatedReport data = {
       .cells = &brl->buffer[textStart],
@@ -1088,12 +1190,301 @@ writeBrailleWindow (BrailleDisplay *brl, const wchar_t *text, unsigned char qual
   }
 
   brl->quality = quality;
-  return braille->writeWindow(brl, text);
+  int written = braille->writeWindow(brl, text);
+  if (written) markBrailleLatencyStage(BLS_WINDOW_WRITTEN);
+
+  getMonotonicTime(&bos.sendTime);
+  return written;
+}
+
+int
+writeBrailleWindow (BrailleDisplay *brl, const wchar_t *text, unsigned char quality) {
+  brailleWindowWriteCount += 1;
+  discardPendingBrailleWindow();
+  return sendBrailleWindow(brl, text, quality);
+}
+
+static void
+getBrailleWindowSendTime (TimeValue *time) {
+  *time = bos.linkFreeTime;
+
+  if (!bos.isPriority) {
+    TimeValue earliest = bos.sendTime;
+    adjustTimeValue(&earliest, UPDATE_FRAME_INTERVAL);
+    if (compareTimeValues(time, &earliest) < 0) *time = earliest;
+  }
+}
+
+ASYNC_ALARM_CALLBACK(handleBrailleWindowAlarm) {
+  asyncDiscardHandle(bos.alarm);
+  bos.alarm = NULL;
+
+  if (bos.isPending) {
+    bos.isPending = 0;
+
+    if (updateSuspendCount || brl.isOffline || !canBraille()) {
+      addUpdateProfileDroppedFrame();
+      invalidateBrailleWindowFingerprint();
+    } else {
+      size_t size = brl.textColumns * brl.textRows;
+
+      if (size == bos.size) {
+        api.claimDriver();
+        memcpy(brl.buffer, bos.cells, size);
+        brl.cursor = bos.cursor;
+
+        addUpdateProfileFrameDelay(microsecondsBetween(&bos.queueTime, parameters->now));
+
+        {
+          /* how long the frame actually waited for the previous write to clear the link */
+          const TimeValue *linkFree = &bos.linkFreeTime;
+          if (compareTimeValues(linkFree, parameters->now) > 0) linkFree = parameters->now;
+
+          int64_t waited = microsecondsBetween(&bos.queueTime, linkFree);
+          addUpdateProfileWriteDelay(MAX(waited, 0));
+        }
+
+        if (!sendBrailleWindow(&brl, bos.text, bos.quality)) {
+          invalidateBrailleWindowFingerprint();
+          brl.hasFailed = 1;
+        }
+
+        advanceBrailleLinkTime();
+        api.releaseDriver();
+      } else {
+        addUpdateProfileDroppedFrame();
+        invalidateBrailleWindowFingerprint();
+      }
+    }
+  }
+}
+
+static int
+queueBrailleWindow (const wchar_t *text, unsigned char quality) {
+  size_t size = brl.textColumns * brl.textRows;
+
+  if (size != bos.size) {
+    unsigned char *cells = realloc(bos.cells, size);
+    if (!cells) goto noMemory;
+    bos.cells = cells;
+
+    wchar_t *characters = realloc(bos.text, ARRAY_SIZE(characters, size));
+    if (!characters) goto noMemory;
+    bos.text = characters;
+
+    bos.size = size;
+  }
+
+  if (bos.isPending) addUpdateProfileDroppedFrame();
+  memcpy(bos.cells, brl.buffer, size);
+  wmemcpy(bos.text, text, size);
+  bos.cursor = brl.cursor;
+  bos.quality = quality;
+  getMonotonicTime(&bos.queueTime);
+  bos.isPending = 1;
+
+  {
+    TimeValue time;
+    getBrailleWindowSendTime(&time);
+
+    if (bos.alarm) {
+      asyncResetAlarmTo(bos.alarm, &time);
+    } else if (!asyncNewAbsoluteAlarm(&bos.alarm, &time, handleBrailleWindowAlarm, NULL)) {
+      bos.isPending = 0;
+      return 0;
+    }
+  }
+
+  return 1;
+
+noMemory:
+  logMallocError();
+  bos.size = 0;
+  return 0;
+}
+
+static int
+shapeBrailleWindow (const wchar_t *text, unsigned char quality) {
+  /* Cursor row changes go out as soon as the link is free.
+   * Other frames are also held to a minimum interval,
+   * and a newer frame always replaces a pending one.
+   */
+  bos.isPriority = (bos.isPending && bos.isPriority) || (scr.posy != bos.cursorRow);
+  bos.cursorRow = scr.posy;
+  advanceBrailleLinkTime();
+
+  {
+    TimeValue time;
+    getBrailleWindowSendTime(&time);
+
+    TimeValue now;
+    getMonotonicTime(&now);
+
+    if (compareTimeValues(&time, &now) > 0) {
+      if (queueBrailleWindow(text, quality)) return 1;
+    }
+  }
+
+  discardPendingBrailleWindow();
+  addUpdateProfileFrameDelay(0);
+  return sendBrailleWindow(&brl, text, quality);
+}
+
+typedef struct {
+  const void *textTable;
+  const void *attributesTable;
+
+  int screenNumber;
+  short screenColumns;
+  short screenRows;
+  short cursorColumn;
+  short cursorRow;
+  unsigned char screenQuality;
+  unsigned char hasCursor;
+
+  int windowColumn;
+  int windowRow;
+  int speechColumn;
+  int speechRow;
+  unsigned char displayMode;
+  unsigned char hideScreenCursor;
+  unsigned char hideBrailleCursor;
+  unsigned char visibleBlinks;
+
+  unsigned int textStart;
+  unsigned int textCount;
+  unsigned int statusStart;
+  unsigned int statusCount;
+  unsigned int textColumns;
+  unsigned int textRows;
+} BrailleWindowState;
+
+static struct {
+  unsigned char isValid:1;
+  unsigned int writeCount;
+  TimeValue writeTime;
+  unsigned char requiredBlinks;
+
+  BrailleWindowState state;
+  PreferenceSettings preferences;
+
+  unsigned char *content;
+  size_t contentSize;
+} bwf = {
+  .isValid = 0
+};
+
+static void
+invalidateBrailleWindowFingerprint (void) {
+  bwf.isValid = 0;
+}
+
+static void
+getBrailleWindowState (BrailleWindowState *state) {
+  memset(state, 0, sizeof(*state));
+
+  state->textTable = textTable;
+  state->attributesTable = attributesTable;
+
+  state->screenNumber = scr.number;
+  state->screenColumns = scr.cols;
+  state->screenRows = scr.rows;
+  state->cursorColumn = scr.posx;
+  state->cursorRow = scr.posy;
+  state->screenQuality = scr.quality;
+  state->hasCursor = scr.hasCursor;
+
+  state->windowColumn = ses->winx;
+  state->windowRow = ses->winy;
+  state->speechColumn = ses->spkx;
+  state->speechRow = ses->spky;
+  state->displayMode = ses->displayMode;
+  state->hideScreenCursor = ses->hideScreenCursor;
+  state->hideBrailleCursor = brl.hideCursor;
+  state->visibleBlinks = getVisibleBlinkDescriptors();
+
+  state->textStart = textStart;
+  state->textCount = textCount;
+  state->statusStart = statusStart;
+  state->statusCount = statusCount;
+  state->textColumns = brl.textColumns;
+  state->textRows = brl.textRows;
+}
+
+static int
+isSameBrailleWindowContent (
+  const ScreenCharacter *characters, size_t characterSize,
+  const unsigned char *statusCells, size_t statusSize
+) {
+  if (bwf.contentSize != (characterSize + statusSize)) return 0;
+  if (memcmp(bwf.content, characters, characterSize) != 0) return 0;
+  if (memcmp(&bwf.content[characterSize], statusCells, statusSize) != 0) return 0;
+  return 1;
+}
+
+static int
+isBrailleWindowUnchanged (
+  const ScreenCharacter *characters, size_t characterCount,
+  const unsigned char *statusCells, size_t statusCount
+) {
+  if (!bwf.isValid) return 0;
+  if (bwf.writeCount != brailleWindowWriteCount) return 0;
+  if (getMonotonicElapsed(&bwf.writeTime) >= UPDATE_WINDOW_REWRITE_INTERVAL) return 0;
+
+  {
+    BrailleWindowState state;
+    getBrailleWindowState(&state);
+    if (memcmp(&state, &bwf.state, sizeof(state)) != 0) return 0;
+  }
+
+  if (memcmp(&prefs, &bwf.preferences, sizeof(prefs)) != 0) return 0;
+
+  if (!isSameBrailleWindowContent(
+    characters, (characterCount * sizeof(*characters)),
+    statusCells, statusCount
+  )) return 0;
+
+  requireBlinkDescriptors(bwf.requiredBlinks);
+  return 1;
+}
+
+static void
+saveBrailleWindowFingerprint (
+  const ScreenCharacter *characters, size_t characterCount,
+  const unsigned char *statusCells, size_t statusCount
+) {
+  size_t characterSize = characterCount * sizeof(*characters);
+  size_t size = characterSize + statusCount;
+
+  if (size != bwf.contentSize) {
+    unsigned char *content = realloc(bwf.content, size);
+
+    if (!content) {
+      logMallocError();
+      invalidateBrailleWindowFingerprint();
+      return;
+    }
+
+    bwf.content = content;
+    bwf.contentSize = size;
+  }
+
+  memcpy(bwf.content, characters, characterSize);
+  memcpy(&bwf.content[characterSize], statusCells, statusCount);
+
+  getBrailleWindowState(&bwf.state);
+  bwf.preferences = prefs;
+  bwf.requiredBlinks = getRequiredBlinkDescriptors();
+
+  bwf.writeCount = brailleWindowWriteCount;
+  getMonotonicTime(&bwf.writeTime);
+  bwf.isValid = 1;
 }
 
 static void
 doUpdate (void) {
   logMessage(LOG_CATEGORY(UPDATE_EVENTS), "starting");
+  startUpdateProfile();
   unrequireAllBlinkDescriptors();
   refreshScreen();
   updateSessionAttributes();
@@ -1133,6 +1524,7 @@ doUpdate (void) {
     }
   }
 
+  endUpdateProfilePhase(UPP_REFRESH);
   int screenPointerHasMoved = 0;
   int trackScreenScroll = 0;
 
@@ -1179,6 +1571,7 @@ doUpdate (void) {
   }
 
   checkScreenScroll(trackScreenScroll);
+  endUpdateProfilePhase(UPP_TRACKING);
 
 #ifdef ENABLE_SPEECH_SUPPORT
   if (spk.canAutospeak) {
@@ -1191,6 +1584,7 @@ doUpdate (void) {
     }
 
     wasAutospeaking = isAutospeaking;
+    endUpdateProfilePhase(UPP_AUTOSPEAK);
   }
 #endif /* ENABLE_SPEECH_SUPPORT */
 
@@ -1216,90 +1610,118 @@ doUpdate (void) {
     oldwiny = ses->winy;
   }
 
+  UpdateProfileOutcome outcome = UPO_SKIPPED;
+
   if (!brl.isOffline && canBraille()) {
     api.claimDriver();
+    outcome = UPO_WRITTEN;
 
     if (infoMode) {
+      invalidateBrailleWindowFingerprint();
       if (!renderInfoLine()) brl.hasFailed = 1;
+      endUpdateProfilePhase(UPP_OUTPUT);
     } else {
       const unsigned int windowLength = brl.textColumns * brl.textRows;
-      memset(brl.buffer, 0, windowLength);
-
       wchar_t textBuffer[windowLength];
-      wmemset(textBuffer, WC_C(' '), windowLength);
 
       unsigned int textLength = textCount * brl.textRows;
-      isContracted = isContracting();
+      ScreenCharacter characters[textLength];
 
-      if (isContracted) {
-        while (1) {
-          int generated = generateContractedBraille(textBuffer);
-          contractedTrack = 0;
-          if (generated) break;
-        }
-      } else {
-        ScreenCharacter characters[textLength];
-        readBrailleWindow(characters, ARRAY_COUNT(characters));
-        translateBrailleWindow(characters, textBuffer);
+      const unsigned char *statusFields = prefs.statusFields;
+      unsigned int statusLength = getStatusFieldsLength(statusFields);
+      unsigned char statusCells[MAX(statusLength, 1)];
+
+      if (statusLength > 0) {
+        memset(statusCells, 0, statusLength);
+        renderStatusFields(statusFields, statusCells);
       }
 
-      if ((brl.cursor = getScreenCursorPosition(scr.posx, scr.posy)) != BRL_NO_CURSOR) {
-        if (showScreenCursor()) {
-          BlinkDescriptor *blink = &screenCursorBlinkDescriptor;
-          requireBlinkDescriptor(blink);
+      isContracted = isContracting();
+      if (!isContracted) readBrailleWindow(characters, ARRAY_COUNT(characters));
 
-          if (isBlinkVisible(blink)) {
-            brl.buffer[brl.cursor] |= mapCursorDots(getScreenCursorDots());
+      if (!isContracted && isBrailleWindowUnchanged(characters, textLength, statusCells, statusLength)) {
+        outcome = UPO_UNCHANGED;
+        endUpdateProfilePhase(UPP_WINDOW);
+      } else {
+        invalidateBrailleWindowFingerprint();
+        memset(brl.buffer, 0, windowLength);
+        wmemset(textBuffer, WC_C(' '), windowLength);
+
+        if (isContracted) {
+          while (1) {
+            int generated = generateContractedBraille(textBuffer);
+            contractedTrack = 0;
+            if (generated) break;
           }
+        } else {
+          translateBrailleWindow(characters, textBuffer);
         }
-      }
 
-      if (prefs.showSpeechCursor) {
-        int position = getScreenCursorPosition(ses->spkx, ses->spky);
+        endUpdateProfilePhase(UPP_WINDOW);
 
-        if (position != BRL_NO_CURSOR) {
-          if (position != brl.cursor) {
-            BlinkDescriptor *blink = &speechCursorBlinkDescriptor;
+        if ((brl.cursor = getScreenCursorPosition(scr.posx, scr.posy)) != BRL_NO_CURSOR) {
+          if (showScreenCursor()) {
+            BlinkDescriptor *blink = &screenCursorBlinkDescriptor;
             requireBlinkDescriptor(blink);
 
             if (isBlinkVisible(blink)) {
-              brl.buffer[position] |= mapCursorDots(getSpeechCursorDots());
+              brl.buffer[brl.cursor] |= mapCursorDots(getScreenCursorDots());
             }
           }
         }
-      }
 
-      if (statusCount > 0) {
-        const unsigned char *fields = prefs.statusFields;
-        unsigned int length = getStatusFieldsLength(fields);
+        if (prefs.showSpeechCursor) {
+          int position = getScreenCursorPosition(ses->spkx, ses->spky);
 
-        if (length > 0) {
-          unsigned char cells[length];
-          memset(cells, 0, length);
-          renderStatusFields(fields, cells);
+          if (position != BRL_NO_CURSOR) {
+            if (position != brl.cursor) {
+              BlinkDescriptor *blink = &speechCursorBlinkDescriptor;
+              requireBlinkDescriptor(blink);
 
-          fillDotsRegion(
-            textBuffer, brl.buffer, statusStart, statusCount,
-            brl.textColumns, brl.textRows, cells, length
-          );
+              if (isBlinkVisible(blink)) {
+                brl.buffer[position] |= mapCursorDots(getSpeechCursorDots());
+              }
+            }
+          }
         }
 
-        fillStatusSeparator(textBuffer, brl.buffer);
-      }
+        if (statusCount > 0) {
+          if (statusLength > 0) {
+            fillDotsRegion(
+              textBuffer, brl.buffer, statusStart, statusCount,
+              brl.textColumns, brl.textRows, statusCells, statusLength
+            );
+          }
+
+          fillStatusSeparator(textBuffer, brl.buffer);
+        }
+
+        endUpdateProfilePhase(UPP_OVERLAY);
+
+        if (writeStatusCells() && shapeBrailleWindow(textBuffer, scr.quality)) {
+          if (!isContracted) {
+            saveBrailleWindowFingerprint(characters, textLength, statusCells, statusLength);
+          }
+        } else {
+          brl.hasFailed = 1;
+        }
 
-      if (!(writeStatusCells() && writeBrailleWindow(&brl, textBuffer, scr.quality))) brl.hasFailed = 1;
+        endUpdateProfilePhase(UPP_OUTPUT);
+      }
     }
 
     api.releaseDriver();
+  } else {
+    invalidateBrailleWindowFingerprint();
   }
 
   resetAllBlinkDescriptors();
+  endUpdateProfile(outcome);
   logMessage(LOG_CATEGORY(UPDATE_EVENTS), "finished");
 }
 
 static void setUpdateAlarm (void);
 static AsyncHandle updateAlarm;
-static int updateSuspendCount;
 
 static TimeValue updateTime;
 static TimeValue earliestTime;
@@ -1348,11 +1770,23 @@ scheduleUpdate (const char *reason) {
   scheduleUpdateIn(reason, 0);
 }
 
+static void
+holdUpdates (void) {
+  if (updateAlarm) {
+    asyncCancelRequest(updateAlarm);
+    updateAlarm = NULL;
+  }
+
+  updateSuspendCount += 1;
+  logMessage(LOG_CATEGORY(UPDATE_EVENTS), "suspend: %u", updateSuspendCount);
+}
+
 ASYNC_ALARM_CALLBACK(handleUpdateAlarm) {
   asyncDiscardHandle(updateAlarm);
   updateAlarm = NULL;
 
-  suspendUpdates();
+  /* a queued window is still wanted - the update may keep or replace it */
+  holdUpdates();
   setUpdateTime((pollScreen()? SCREEN_UPDATE_POLL_INTERVAL: (SECS_PER_DAY * MSECS_PER_SEC)),
                 parameters->now, 0);
 
@@ -1367,8 +1801,8 @@ ASYNC_ALARM_CALLBACK(handleUpdateAlarm) {
     }
   }
 
-  setUpdateDelay(MAX((brl.writeDelay + 1), UPDATE_SCHEDULE_DELAY));
-  brl.writeDelay = 0;
+  advanceBrailleLinkTime();
+  setUpdateDelay(UPDATE_SCHEDULE_DELAY);
 
   resumeUpdates(0);
 }
@@ -1383,6 +1817,7 @@ setUpdateAlarm (void) {
 static ReportListenerInstance *updateBrailleDeviceOnlineListener = NULL;
 
 REPORT_LISTENER(handleUpdateBrailleDeviceOnline) {
+  invalidateBrailleWindowFingerprint();
   scheduleUpdate("braille online");
 }
 
@@ -1401,6 +1836,7 @@ beginUpdates (void) {
 
 #ifdef ENABLE_SPEECH_SUPPORT
   wasAutospeaking = 0;
+  autospeakChangesSkipped = 0;
 #endif /* ENABLE_SPEECH_SUPPORT */
 
   updateBrailleDeviceOnlineListener = registerReportListener(REPORT_BRAILLE_DEVICE_ONLINE, handleUpdateBrailleDeviceOnline, NULL);
@@ -1408,13 +1844,9 @@ beginUpdates (void) {
 
 void
 suspendUpdates (void) {
-  if (updateAlarm) {
-    asyncCancelRequest(updateAlarm);
-    updateAlarm = NULL;
-  }
-
-  updateSuspendCount += 1;
-  logMessage(LOG_CATEGORY(UPDATE_EVENTS), "suspend: %u", updateSuspendCount);
+  /* whatever suspends updates from outside will rewrite the window itself */
+  discardPendingBrailleWindow();
+  holdUpdates();
 }
 
 void
@@ -27,6 +27,7 @@ extern "C" {
 
 extern int writeBrailleWindow (BrailleDisplay *brl, const wchar_t *text, unsigned char quality);
 extern void reportBrailleWindowMoved (void);
+extern void resetBrailleWindow (void);
 
 extern void scheduleUpdate (const char *reason);
 extern void scheduleUpdateIn (const char *reason, int delay);
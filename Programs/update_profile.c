@@ -0,0 +1,326 @@
+/*
+ * BRLTTY - A background process providing access to the console screen (when in
+ *          text mode) for a blind person using a refreshable braille display.
+ *
+ * Copyright (C) 1995-2026 by The BRLTTY Developers.
+ *
+ * BRLTTY comes with ABSOLUTELY NO WARRANTY.
+ *
+ * This is free software, placed under the terms of the
+ * GNU Lesser General Public License, as published by the Free Software
+ * Foundation; either version 2.1 of the License, or (at your option) any
+ * later version. Please see the file LICENSE-LGPL for details.
+ *
+ * Web Page: http://brltty.app/
+ *
+ * This software is maintained by Dave Mielke <dave@mielke.cc>.
+ */
+
+
+#include "prologue.h"
+
+#include <string.h>
+#include <time.h>
+
+#include "log.h"
+#include "update_profile.h"
+#include "histogram.h"
+#include "strfmt.h"
+#include "timing.h"
+
+#define UPDATE_PROFILE_SUMMARY_INTERVAL (5 * SECS_PER_MIN * MSECS_PER_SEC)
+#define UPDATE_PROFILE_SLOWEST_COUNT 8
+#define UPDATE_PROFILE_SLOWEST_AGE (15 * SECS_PER_MIN * MSECS_PER_SEC)
+
+static const char *const updateProfilePhaseNames[UPP_COUNT] = {
+  [UPP_REFRESH] = "refresh",
+  [UPP_TRACKING] = "tracking",
+  [UPP_AUTOSPEAK] = "autospeak",
+  [UPP_WINDOW] = "window",
+  [UPP_OVERLAY] = "overlay",
+  [UPP_OUTPUT] = "output",
+};
+
+static const char *const updateProfileOutcomeNames[UPO_COUNT] = {
+  [UPO_SKIPPED] = "skipped",
+  [UPO_UNCHANGED] = "unchanged",
+  [UPO_WRITTEN] = "written",
+};
+
+typedef struct {
+  TimeValue started;
+  TimeValue when;
+  uint32_t total;
+  uint32_t phases[UPP_COUNT];
+} UpdateProfileCycle;
+
+static struct {
+  unsigned char active:1;
+  UpdateProfileCycle cycle;
+  TimeValue phaseTime;
+  TimeValue processorTime;
+
+  Histogram phaseHistograms[UPP_COUNT];
+  uint64_t phaseProcessorTimes[UPP_COUNT];
+  Histogram cycleHistogram;
+  Histogram writeDelayHistogram;
+  Histogram frameDelayHistogram;
+  unsigned long int droppedFrames;
+
+  unsigned long int outcomes[UPO_COUNT];
+
+  UpdateProfileCycle slowest[UPDATE_PROFILE_SLOWEST_COUNT];
+  unsigned int slowestCount;
+
+  unsigned char summaryStarted:1;
+  TimeValue summaryTime;
+} ups;
+
+static uint32_t
+toMicroseconds (int64_t microseconds) {
+  if (microseconds < 0) return 0;
+  if (microseconds > UINT32_MAX) return UINT32_MAX;
+  return microseconds;
+}
+
+static void
+getProcessorTime (TimeValue *time) {
+#if defined(HAVE_CLOCK_GETTIME) && defined(CLOCK_THREAD_CPUTIME_ID)
+  struct timespec ts;
+
+  if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) != -1) {
+    time->seconds = ts.tv_sec;
+    time->nanoseconds = ts.tv_nsec;
+    return;
+  }
+#endif /* CLOCK_THREAD_CPUTIME_ID */
+
+  {
+    clock_t ticks = clock();
+
+    time->seconds = ticks / CLOCKS_PER_SEC;
+    time->nanoseconds = (ticks % CLOCKS_PER_SEC) * (NSECS_PER_SEC / CLOCKS_PER_SEC);
+  }
+}
+
+void
+beginUpdateProfile (void) {
+  memset(&ups.cycle, 0, sizeof(ups.cycle));
+  getCurrentTime(&ups.cycle.when);
+  getMonotonicTime(&ups.cycle.started);
+  getProcessorTime(&ups.processorTime);
+
+  ups.phaseTime = ups.cycle.started;
+  ups.active = 1;
+}
+
+void
+endUpdateProfilePhase (UpdateProfilePhase phase) {
+  if (ups.active) {
+    TimeValue now;
+    TimeValue processorTime;
+
+    getMonotonicTime(&now);
+    getProcessorTime(&processorTime);
+
+    uint32_t elapsed = toMicroseconds(microsecondsBetween(&ups.phaseTime, &now));
+    addHistogramValue(&ups.phaseHistograms[phase], elapsed);
+    ups.cycle.phases[phase] += elapsed;
+
+    ups.phaseProcessorTimes[phase] += toMicroseconds(
+      microsecondsBetween(&ups.processorTime, &processorTime)
+    );
+
+    ups.phaseTime = now;
+    ups.processorTime = processorTime;
+  }
+}
+
+static int
+isExpiredCycle (const UpdateProfileCycle *cycle, const TimeValue *now) {
+  return millisecondsBetween(&cycle->started, now) > UPDATE_PROFILE_SLOWEST_AGE;
+}
+
+static void
+addSlowestCycle (const UpdateProfileCycle *cycle) {
+  UpdateProfileCycle *slot = NULL;
+
+  if (ups.slowestCount < UPDATE_PROFILE_SLOWEST_COUNT) {
+    slot = &ups.slowest[ups.slowestCount++];
+  } else {
+    int expired = 0;
+
+    for (unsigned int index=0; index<ups.slowestCount; index+=1) {
+      UpdateProfileCycle *upc = &ups.slowest[index];
+
+      if (isExpiredCycle(upc, &cycle->started)) {
+        slot = upc;
+        expired = 1;
+        break;
+      }
+
+      if (!slot || (upc->total < slot->total)) slot = upc;
+    }
+
+    if (!expired && (slot->total >= cycle->total)) return;
+  }
+
+  *slot = *cycle;
+}
+
+void
+endUpdateProfile (UpdateProfileOutcome outcome) {
+  if (ups.active) {
+    ups.active = 0;
+
+    TimeValue now;
+    getMonotonicTime(&now);
+
+    ups.cycle.total = toMicroseconds(microsecondsBetween(&ups.cycle.started, &now));
+    addHistogramValue(&ups.cycleHistogram, ups.cycle.total);
+    addSlowestCycle(&ups.cycle);
+
+    ups.outcomes[outcome] += 1;
+
+    if (!ups.summaryStarted) {
+      ups.summaryTime = now;
+      ups.summaryStarted = 1;
+    } else if (millisecondsBetween(&ups.summaryTime, &now) >= UPDATE_PROFILE_SUMMARY_INTERVAL) {
+      logUpdateProfile();
+      resetUpdateProfile();
+    }
+  }
+}
+
+void
+addUpdateProfileWriteDelay (int64_t microseconds) {
+  if (LOG_CATEGORY_FLAG(PERFORMANCE)) {
+    addHistogramValue(&ups.writeDelayHistogram, toMicroseconds(microseconds));
+  }
+}
+
+void
+addUpdateProfileFrameDelay (int64_t microseconds) {
+  if (LOG_CATEGORY_FLAG(PERFORMANCE)) {
+    addHistogramValue(&ups.frameDelayHistogram, toMicroseconds(microseconds));
+  }
+}
+
+void
+addUpdateProfileDroppedFrame (void) {
+  if (LOG_CATEGORY_FLAG(PERFORMANCE)) ups.droppedFrames += 1;
+}
+
+static int
+sortSlowestCycles (const void *element1, const void *element2) {
+  const UpdateProfileCycle *cycle1 = element1;
+  const UpdateProfileCycle *cycle2 = element2;
+
+  if (cycle1->total > cycle2->total) return -1;
+  if (cycle1->total < cycle2->total) return 1;
+  return 0;
+}
+
+static
+STR_BEGIN_FORMATTER(formatUpdateProfileCycle, const UpdateProfileCycle *cycle)
+  {
+    char buffer[0X20];
+    size_t length = formatSeconds(buffer, sizeof(buffer), "%H:%M:%S", cycle->when.seconds);
+    STR_PRINTF(" %.*s.%03u", (int)length, buffer, (unsigned int)(cycle->when.nanoseconds / NSECS_PER_MSEC));
+  }
+
+  STR_PRINTF("[total=%"PRIu32, cycle->total);
+
+  for (unsigned int phase=0; phase<UPP_COUNT; phase+=1) {
+    if (cycle->phases[phase]) {
+      STR_PRINTF(" %s=%"PRIu32, updateProfilePhaseNames[phase], cycle->phases[phase]);
+    }
+  }
+
+  STR_PRINTF("]");
+STR_END_FORMATTER
+
+size_t
+formatUpdateProfile (char *buffer, size_t size) {
+  size_t length;
+
+  STR_BEGIN(buffer, size);
+  STR_PRINTF("update profile (microseconds):");
+
+  for (unsigned int outcome=0; outcome<UPO_COUNT; outcome+=1) {
+    STR_PRINTF(" %s=%lu", updateProfileOutcomeNames[outcome], ups.outcomes[outcome]);
+  }
+
+  for (unsigned int phase=0; phase<UPP_COUNT; phase+=1) {
+    const Histogram *histogram = &ups.phaseHistograms[phase];
+
+    STR_PRINTF(" %s[", updateProfilePhaseNames[phase]);
+    STR_FORMAT(formatHistogram, histogram);
+
+    if (histogram->count) {
+      STR_PRINTF(" cpu=%"PRIu64, (ups.phaseProcessorTimes[phase] / histogram->count));
+    }
+
+    STR_PRINTF("]");
+  }
+
+  STR_PRINTF(" cycle[");
+  STR_FORMAT(formatHistogram, &ups.cycleHistogram);
+  STR_PRINTF("] write-delay[");
+  STR_FORMAT(formatHistogram, &ups.writeDelayHistogram);
+  STR_PRINTF("] frame-delay[");
+  STR_FORMAT(formatHistogram, &ups.frameDelayHistogram);
+  STR_PRINTF("] dropped=%lu", ups.droppedFrames);
+
+  {
+    TimeValue now;
+    getMonotonicTime(&now);
+
+    UpdateProfileCycle slowest[UPDATE_PROFILE_SLOWEST_COUNT];
+    unsigned int count = 0;
+
+    for (unsigned int index=0; index<ups.slowestCount; index+=1) {
+      const UpdateProfileCycle *cycle = &ups.slowest[index];
+      if (!isExpiredCycle(cycle, &now)) slowest[count++] = *cycle;
+    }
+
+    if (count) {
+      qsort(slowest, count, sizeof(slowest[0]), sortSlowestCycles);
+      STR_PRINTF(" slowest:");
+
+      for (unsigned int index=0; index<count; index+=1) {
+        STR_FORMAT(formatUpdateProfileCycle, &slowest[index]);
+      }
+    }
+  }
+
+  length = STR_LENGTH;
+  STR_END;
+
+  return length;
+}
+
+void
+logUpdateProfile (void) {
+  char profile[0X800];
+  formatUpdateProfile(profile, sizeof(profile));
+  logMessage(LOG_CATEGORY(PERFORMANCE), "%s", profile);
+}
+
+void
+resetUpdateProfile (void) {
+  /* the next summary covers what's profiled from now on */
+  for (unsigned int phase=0; phase<UPP_COUNT; phase+=1) {
+    resetHistogram(&ups.phaseHistograms[phase]);
+    ups.phaseProcessorTimes[phase] = 0;
+  }
+
+  resetHistogram(&ups.cycleHistogram);
+  resetHistogram(&ups.writeDelayHistogram);
+  resetHistogram(&ups.frameDelayHistogram);
+  ups.droppedFrames = 0;
+
+  memset(ups.outcomes, 0, sizeof(ups.outcomes));
+  ups.slowestCount = 0;
+  ups.summaryStarted = 0;
+}
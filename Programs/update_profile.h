@@ -0,0 +1,66 @@
+/*
+ * BRLTTY - A background process providing access to the console screen (when in
+ *          text mode) for a blind person using a refreshable braille display.
+ *
+ * Copyright (C) 1995-2026 by The BRLTTY Developers.
+ *
+ * BRLTTY comes with ABSOLUTELY NO WARRANTY.
+ *
+ * This is free software, placed under the terms of the
+ * GNU Lesser General Public License, as published by the Free Software
+ * Foundation; either version 2.1 of the License, or (at your option) any
+ * later version. Please see the file LICENSE-LGPL for details.
+ *
+ * Web Page: http://brltty.app/
+ *
+ * This software is maintained by Dave Mielke <dave@mielke.cc>.
+ */
+
+
+#ifndef BRLTTY_INCLUDED_UPDATE_PROFILE
+#define BRLTTY_INCLUDED_UPDATE_PROFILE
+
+#include "log.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+typedef enum {
+  UPP_REFRESH,
+  UPP_TRACKING,
+  UPP_AUTOSPEAK,
+  UPP_WINDOW,
+  UPP_OVERLAY,
+  UPP_OUTPUT,
+  UPP_COUNT /* must be last */
+} UpdateProfilePhase;
+
+typedef enum {
+  UPO_SKIPPED,
+  UPO_UNCHANGED,
+  UPO_WRITTEN,
+  UPO_COUNT /* must be last */
+} UpdateProfileOutcome;
+
+extern void beginUpdateProfile (void);
+extern void endUpdateProfilePhase (UpdateProfilePhase phase);
+extern void endUpdateProfile (UpdateProfileOutcome outcome);
+extern void addUpdateProfileWriteDelay (int64_t microseconds);
+extern void addUpdateProfileFrameDelay (int64_t microseconds);
+extern void addUpdateProfileDroppedFrame (void);
+
+static inline void
+startUpdateProfile (void) {
+  if (LOG_CATEGORY_FLAG(PERFORMANCE)) beginUpdateProfile();
+}
+
+extern size_t formatUpdateProfile (char *buffer, size_t size);
+extern void logUpdateProfile (void);
+extern void resetUpdateProfile (void);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* BRLTTY_INCLUDED_UPDATE_PROFILE */
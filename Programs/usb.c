@@ -38,6 +38,7 @@
 #include "utf8.h"
 #include "device.h"
 #include "timing.h"
+#include "histogram.h"
 #include "async_handle.h"
 #include "async_wait.h"
 #include "async_alarm.h"
@@ -47,6 +48,159 @@
 #include "usb_devices.h"
 #include "usb_serial.h"
 
+static void
+usbReapOutputRequests (UsbEndpoint *endpoint) {
+  Queue *requests = endpoint->direction.output.pending.requests;
+
+  while (getQueueSize(requests)) {
+    UsbResponse response;
+    void *request = usbReapResponse(endpoint->device,
+                                    endpoint->descriptor->bEndpointAddress,
+                                    &response, 0);
+
+    if (!request) break;
+    deleteItem(requests, request);
+    endpoint->direction.output.pending.size -= response.size;
+
+    if (response.error && !endpoint->direction.output.pending.error) {
+      endpoint->direction.output.pending.error = response.error;
+    }
+
+    free(request);
+  }
+}
+
+static int
+usbAwaitOutputSpace (UsbEndpoint *endpoint, size_t size, int timeout) {
+  TimePeriod period;
+  startTimePeriod(&period, timeout);
+
+  while (1) {
+    usbReapOutputRequests(endpoint);
+
+    {
+      int *error = &endpoint->direction.output.pending.error;
+
+      if (*error) {
+        errno = *error;
+        *error = 0;
+        return 0;
+      }
+    }
+
+    {
+      size_t pending = endpoint->direction.output.pending.size;
+
+      if (!pending) return 1;
+      if ((pending + size) <= endpoint->direction.output.pending.limit) return 1;
+    }
+
+    if (afterTimePeriod(&period, NULL)) {
+      errno = EAGAIN;
+      return 0;
+    }
+
+    /* Not asyncWait() - that could run a handler which writes to this
+     * endpoint while this write is still in progress.
+     */
+    approximateDelay(USB_OUTPUT_AWAIT_RETRY_INTERVAL);
+  }
+}
+
+static ssize_t
+usbQueueOutput (UsbEndpoint *endpoint, const void *data, size_t size, int timeout) {
+  UsbDevice *device = endpoint->device;
+
+  if (usbAwaitOutputSpace(endpoint, size, timeout)) {
+    void *request = usbSubmitRequest(device, endpoint->descriptor->bEndpointAddress,
+                                     (void *)data, size, NULL);
+
+    if (request) {
+      if (enqueueItem(endpoint->direction.output.pending.requests, request)) {
+        endpoint->direction.output.pending.size += size;
+        return size;
+      }
+
+      usbCancelRequest(device, request);
+    }
+  }
+
+  return -1;
+}
+
+typedef struct {
+  int timeout;
+  int ok;
+} UsbAwaitOrderedOutputData;
+
+static int
+usbAwaitEndpointOutput (void *item, void *data) {
+  UsbEndpoint *endpoint = item;
+  UsbAwaitOrderedOutputData *aoo = data;
+
+  if (USB_ENDPOINT_DIRECTION(endpoint->descriptor) == UsbEndpointDirection_Output) {
+    if (endpoint->direction.output.pending.requests) {
+      if (!endpoint->direction.output.pending.unordered) {
+        if (!usbAwaitOutputSpace(endpoint, endpoint->direction.output.pending.limit, aoo->timeout)) {
+          aoo->ok = 0;
+          return 1;
+        }
+      }
+    }
+  }
+
+  return 0;
+}
+
+static int
+usbAwaitOrderedOutput (UsbDevice *device, int timeout) {
+  UsbAwaitOrderedOutputData aoo = {
+    .timeout = timeout,
+    .ok = 1
+  };
+
+  if (device->endpoints) processQueue(device->endpoints, usbAwaitEndpointOutput, &aoo);
+  return aoo.ok;
+}
+
+static void
+usbBeginOutput (UsbEndpoint *endpoint, size_t limit, int unordered) {
+  if (!endpoint->direction.output.pending.requests) {
+    if ((endpoint->direction.output.pending.requests = newQueue(NULL, NULL))) {
+      endpoint->direction.output.pending.limit = limit;
+      endpoint->direction.output.pending.size = 0;
+      endpoint->direction.output.pending.error = 0;
+      endpoint->direction.output.pending.unordered = !!unordered;
+
+      logMessage(LOG_CATEGORY(USB_IO),
+        "output queue: Ept:%02X Lim:%u%s",
+        endpoint->descriptor->bEndpointAddress, (unsigned int)limit,
+        (unordered? " unordered": "")
+      );
+    }
+  }
+}
+
+static void
+usbEndOutput (UsbEndpoint *endpoint) {
+  Queue *requests = endpoint->direction.output.pending.requests;
+
+  if (requests) {
+    void *request;
+
+    usbAwaitOutputSpace(endpoint, endpoint->direction.output.pending.limit,
+                        USB_OUTPUT_DRAIN_TIMEOUT);
+
+    while ((request = dequeueItem(requests))) {
+      usbCancelRequest(endpoint->device, request);
+    }
+
+    destroyQueue(requests);
+    endpoint->direction.output.pending.requests = NULL;
+    endpoint->direction.output.pending.size = 0;
+  }
+}
+
 ssize_t
 usbControlRead (
   UsbDevice *device,
@@ -59,6 +213,7 @@ usbControlRead (
   uint16_t length,
   int timeout
 ) {
+  if (!usbAwaitOrderedOutput(device, timeout)) return -1;
   return usbControlTransfer(device, UsbControlDirection_Input, recipient, type,
                             request, value, index, buffer, length, timeout);
 }
@@ -75,6 +230,7 @@ usbControlWrite (
   uint16_t length,
   int timeout
 ) {
+  if (!usbAwaitOrderedOutput(device, timeout)) return -1;
   return usbControlTransfer(device, UsbControlDirection_Output, recipient, type,
                             request, value, index, (void *)buffer, length, timeout);
 }
@@ -685,7 +841,18 @@ usbEnqueueInput (UsbEndpoint *endpoint, const void *buffer, size_t length) {
     return 0;
   }
 
-  return writeFile(endpoint->direction.input.pipe.input, buffer, length) != -1;
+  if (writeFile(endpoint->direction.input.pipe.input, buffer, length) == -1) return 0;
+  endpoint->direction.input.pipe.written += length;
+  return 1;
+}
+
+static void
+usbResetInputStamps (UsbEndpoint *endpoint) {
+  endpoint->direction.input.pipe.written = 0;
+  endpoint->direction.input.pipe.read = 0;
+
+  endpoint->direction.input.stamps.first = 0;
+  endpoint->direction.input.stamps.count = 0;
 }
 
 void
@@ -698,6 +865,7 @@ usbDestroyInputPipe (UsbEndpoint *endpoint) {
 int
 usbMakeInputPipe (UsbEndpoint *endpoint) {
   if (usbHaveInputPipe(endpoint)) return 1;
+  usbResetInputStamps(endpoint);
 
   if (createAnonymousPipe(&endpoint->direction.input.pipe.input,
                           &endpoint->direction.input.pipe.output)) {
@@ -844,6 +1012,16 @@ usbGetEndpoint (UsbDevice *device, unsigned char endpointAddress) {
           endpoint->direction.input.pipe.output = INVALID_FILE_DESCRIPTOR;
           endpoint->direction.input.pipe.monitor = NULL;
           endpoint->direction.input.pipe.error = 0;
+          usbResetInputStamps(endpoint);
+
+          break;
+
+        case UsbEndpointDirection_Output:
+          endpoint->direction.output.pending.requests = NULL;
+          endpoint->direction.output.pending.limit = 0;
+          endpoint->direction.output.pending.size = 0;
+          endpoint->direction.output.pending.error = 0;
+          endpoint->direction.output.pending.unordered = 0;
 
           break;
       }
@@ -892,6 +1070,10 @@ usbFinishEndpoint (void *item, void *data) {
       }
       break;
 
+    case UsbEndpointDirection_Output:
+      usbEndOutput(endpoint);
+      break;
+
     default:
       break;
   }
@@ -1121,6 +1303,137 @@ usbLogInputProblem (UsbEndpoint *endpoint, const char *problem) {
              problem, endpoint->descriptor->bEndpointAddress);
 }
 
+static int
+usbGetPollInterval (UsbEndpoint *endpoint) {
+  int interval = endpoint->descriptor->bInterval;
+
+  if (interval > 0) {
+    if (getLittleEndian16(endpoint->device->descriptor.bcdUSB) >= UsbSpecificationVersion_2_0) {
+      interval = (1 << (interval - 1)) / 8;
+    }
+  }
+
+  return interval;
+}
+
+static Histogram usbInputLatency;
+
+size_t
+usbFormatInputStatistics (char *buffer, size_t size) {
+  size_t length;
+
+  STR_BEGIN(buffer, size);
+  STR_PRINTF("USB input latency (microseconds): reap-to-read[");
+  STR_FORMAT(formatHistogram, &usbInputLatency);
+  STR_PRINTF("]");
+
+  length = STR_LENGTH;
+  STR_END;
+
+  return length;
+}
+
+void
+usbLogInputStatistics (void) {
+  char statistics[0X200];
+  usbFormatInputStatistics(statistics, sizeof(statistics));
+  logMessage(LOG_CATEGORY(PERFORMANCE), "%s", statistics);
+}
+
+void
+usbResetInputStatistics (void) {
+  resetHistogram(&usbInputLatency);
+}
+
+/* Input reaches the driver through a pipe, so the reap time of each
+ * response is kept, with where it starts in the byte stream, until the
+ * driver reads its first byte.
+ */
+static void
+usbStampInput (UsbEndpoint *endpoint, uint64_t offset, const TimeValue *reaped) {
+  unsigned int *count = &endpoint->direction.input.stamps.count;
+
+  if (*count < USB_INPUT_LATENCY_STAMPS) {
+    unsigned int index = (endpoint->direction.input.stamps.first + *count) % USB_INPUT_LATENCY_STAMPS;
+
+    endpoint->direction.input.stamps.offsets[index] = offset;
+    endpoint->direction.input.stamps.times[index] = *reaped;
+    *count += 1;
+  }
+}
+
+static void
+usbAddInputLatency (UsbEndpoint *endpoint) {
+  unsigned int *first = &endpoint->direction.input.stamps.first;
+  unsigned int *count = &endpoint->direction.input.stamps.count;
+  if (!*count) return;
+
+  TimeValue now;
+  getMonotonicTime(&now);
+
+  while (*count && (endpoint->direction.input.stamps.offsets[*first] < endpoint->direction.input.pipe.read)) {
+    int64_t microseconds = microsecondsBetween(&endpoint->direction.input.stamps.times[*first], &now);
+    if (microseconds < 0) microseconds = 0;
+    if (microseconds > UINT32_MAX) microseconds = UINT32_MAX;
+    addHistogramValue(&usbInputLatency, microseconds);
+
+    *first = (*first + 1) % USB_INPUT_LATENCY_STAMPS;
+    *count -= 1;
+  }
+}
+
+static void
+usbResetInputArrivals (UsbEndpoint *endpoint) {
+  endpoint->direction.input.pending.arrivalInterval = USB_INPUT_REQUEST_WINDOW * USECS_PER_MSEC;
+  endpoint->direction.input.pending.haveArrival = 0;
+}
+
+static void
+usbNoteInputArrival (UsbEndpoint *endpoint, int starved) {
+  unsigned int *interval = &endpoint->direction.input.pending.arrivalInterval;
+  TimeValue *time = &endpoint->direction.input.pending.arrivalTime;
+
+  TimeValue now;
+  getMonotonicTime(&now);
+
+  if (endpoint->direction.input.pending.haveArrival) {
+    int64_t gap = microsecondsBetween(time, &now);
+
+    /* A gap longer than the idle interval ends a burst rather than
+     * measuring the rate within one, so it's left out. Otherwise, faster
+     * arrivals are followed quickly and slower ones gradually.
+     */
+    if (gap < (USB_INPUT_IDLE_INTERVAL * USECS_PER_MSEC)) {
+      if (gap < 0) gap = 0;
+
+      if (gap < *interval) {
+        *interval = (*interval + gap) / 2;
+      } else {
+        *interval += (MIN(gap, USB_INPUT_REQUEST_WINDOW * USECS_PER_MSEC) - *interval) / 8;
+      }
+    }
+  }
+
+  if (starved) *interval /= 2;
+
+  *time = now;
+  endpoint->direction.input.pending.haveArrival = 1;
+}
+
+static int
+usbGetInputRequestDepth (UsbEndpoint *endpoint) {
+  /* Keep enough requests pending to cover the arrivals expected within one
+   * request window, but never more than the endpoint's polling allows.
+   */
+  unsigned int interval = endpoint->direction.input.pending.arrivalInterval;
+  interval = MAX(interval, MAX(usbGetPollInterval(endpoint), 1) * USECS_PER_MSEC);
+
+  int depth = 1 + (((USB_INPUT_REQUEST_WINDOW * USECS_PER_MSEC) + interval - 1) / interval);
+  depth = MAX(depth, USB_INPUT_INTERRUPT_REQUESTS_MINIMUM);
+  depth = MIN(depth, USB_INPUT_INTERRUPT_REQUESTS_MAXIMUM);
+  return depth;
+}
+
 static void
 usbDeallocatePendingInputRequest (void *item, void *data) {
   void *request = item;
@@ -1184,16 +1497,23 @@ usbSchedulePendingInputRequest (UsbEndpoint *endpoint) {
 }
 
 int
-usbHandleInputResponse (UsbEndpoint *endpoint, const void *buffer, size_t length) {
+usbHandleInputResponse (
+  UsbEndpoint *endpoint, const void *buffer, size_t length,
+  const TimeValue *completed
+) {
   int requestsLeft = getQueueSize(endpoint->direction.input.pending.requests);
 
   if (length > 0) {
+    uint64_t offset = endpoint->direction.input.pipe.written;
+
     if (!usbEnqueueInput(endpoint, buffer, length)) {
       usbLogInputProblem(endpoint, "data not enqueued");
       return 0;
     }
 
-    usbEnsurePendingInputRequests(endpoint, requestsLeft+2);
+    if (completed) usbStampInput(endpoint, offset, completed);
+    usbNoteInputArrival(endpoint, !requestsLeft);
+    usbEnsurePendingInputRequests(endpoint, usbGetInputRequestDepth(endpoint));
     return 1;
   }
 
@@ -1215,26 +1535,14 @@ usbBeginInput (
     if (!endpoint->direction.input.pending.requests) {
       if ((endpoint->direction.input.pending.requests = newQueue(usbDeallocatePendingInputRequest, NULL))) {
         setQueueData(endpoint->direction.input.pending.requests, endpoint);
+        usbResetInputArrivals(endpoint);
       }
     }
 
     if (endpoint->direction.input.pending.requests) {
-      usbEnsurePendingInputRequests(endpoint, 0);
-    }
-  }
-}
-
-static int
-usbGetPollInterval (UsbEndpoint *endpoint) {
-  int interval = endpoint->descriptor->bInterval;
-
-  if (interval > 0) {
-    if (getLittleEndian16(endpoint->device->descriptor.bcdUSB) >= UsbSpecificationVersion_2_0) {
-      interval = (1 << (interval - 1)) / 8;
+      usbEnsurePendingInputRequests(endpoint, usbGetInputRequestDepth(endpoint));
     }
   }
-
-  return interval;
 }
 
 int
@@ -1369,7 +1677,14 @@ usbReadData (
         return -1;
       }
 
-      return readFile(endpoint->direction.input.pipe.output, buffer, length, initialTimeout, subsequentTimeout);
+      ssize_t count = readFile(endpoint->direction.input.pipe.output, buffer, length, initialTimeout, subsequentTimeout);
+
+      if (count > 0) {
+        endpoint->direction.input.pipe.read += count;
+        usbAddInputLatency(endpoint);
+      }
+
+      return count;
     }
 
     while (length > 0) {
@@ -1424,7 +1739,19 @@ usbWriteData (
 
     while (from < end) {
       size_t count = MIN((end - from), size);
-      ssize_t result = usbWriteEndpoint(device, endpointNumber, from, count, timeout);
+      ssize_t result;
+
+      if (endpoint->direction.output.pending.requests) {
+        result = usbQueueOutput(endpoint, from, count, timeout);
+
+        if ((result == -1) && (errno == ENOSYS)) {
+          /* This platform can't submit asynchronous requests. */
+          usbEndOutput(endpoint);
+          continue;
+        }
+      } else {
+        result = usbWriteEndpoint(device, endpointNumber, from, count, timeout);
+      }
 
       if (result == -1) return result;
       from += result;
@@ -1436,6 +1763,22 @@ usbWriteData (
   return -1;
 }
 
+unsigned int
+usbGetOutputDelay (UsbDevice *device, unsigned char endpointNumber) {
+  UsbEndpoint *endpoint = usbGetOutputEndpoint(device, endpointNumber);
+
+  if (endpoint) {
+    Queue *requests = endpoint->direction.output.pending.requests;
+
+    if (requests) {
+      usbReapOutputRequests(endpoint);
+      return getQueueSize(requests) * MAX(usbGetPollInterval(endpoint), 1);
+    }
+  }
+
+  return 0;
+}
+
 static int
 usbPrepareChannel (UsbChannel *channel) {
   const UsbChannelDefinition *definition = channel->definition;
@@ -1503,6 +1846,8 @@ usbPrepareChannel (UsbChannel *channel) {
 
           if (!endpoint) {
             ok = 0;
+          } else if (definition->outputQueueLimit) {
+            usbBeginOutput(endpoint, definition->outputQueueLimit, definition->unorderedOutput);
           }
         }
       }
@@ -22,6 +22,7 @@
 #include <errno.h>
 
 #include "log.h"
+#include "parameters.h"
 #include "usb_serial.h"
 #include "usb_ftdi.h"
 
@@ -155,6 +156,26 @@ usbSetDataFormat_FTDI (UsbDevice *device, unsigned int dataBits, SerialStopBits
   return usbSetAttribute_FTDI(device, 4, value, 0);
 }
 
+static int
+usbSetLatency_FTDI (UsbDevice *device, SerialLatency latency) {
+  /* The latency timer is how long the chip holds a partial packet. */
+  unsigned int milliseconds;
+
+  switch (latency) {
+    case SERIAL_LATENCY_LOW:
+      milliseconds = USB_SERIAL_FTDI_LATENCY_LOW;
+      break;
+
+    default:
+      milliseconds = USB_SERIAL_FTDI_LATENCY_DEFAULT;
+      break;
+  }
+
+  if (!usbSetAttribute_FTDI(device, 9, milliseconds, 0)) return 0;
+  logMessage(LOG_CATEGORY(SERIAL_IO), "FTDI latency timer: %ums", milliseconds);
+  return 1;
+}
+
 static int
 usbSetModemState_FTDI (UsbDevice *device, int state, int shift, const char *name) {
   if ((state < 0) || (state > 1)) {
@@ -192,6 +213,7 @@ const UsbSerialOperations usbSerialOperations_FTDI_FT8U232AM = {
   .setBaud = usbSetBaud_FTDI_FT8U232AM,
   .setDataFormat = usbSetDataFormat_FTDI,
   .setFlowControl = usbSetFlowControl_FTDI,
+  .setLatency = usbSetLatency_FTDI,
 
   .setDtrState = usbSetDtrState_FTDI,
   .setRtsState = usbSetRtsState_FTDI,
@@ -205,6 +227,7 @@ const UsbSerialOperations usbSerialOperations_FTDI_FT232BM = {
   .setBaud = usbSetBaud_FTDI_FT232BM,
   .setDataFormat = usbSetDataFormat_FTDI,
   .setFlowControl = usbSetFlowControl_FTDI,
+  .setLatency = usbSetLatency_FTDI,
 
   .setDtrState = usbSetDtrState_FTDI,
   .setRtsState = usbSetRtsState_FTDI,
@@ -22,6 +22,9 @@
 #include "usb_types.h"
 #include "queue.h"
 #include "async_io.h"
+#include "timing_types.h"
+
+#define USB_INPUT_LATENCY_STAMPS 0X20
 
 #ifdef __cplusplus
 extern "C" {
@@ -48,6 +51,10 @@ struct UsbEndpointStruct {
         Queue *requests;
         AsyncHandle alarm;
         int delay;
+
+        TimeValue arrivalTime;
+        unsigned int arrivalInterval;
+        unsigned char haveArrival:1;
       } pending;
 
       struct {
@@ -61,11 +68,27 @@ struct UsbEndpointStruct {
         FileDescriptor output;
         AsyncHandle monitor;
         int error;
+
+        uint64_t written;
+        uint64_t read;
       } pipe;
+
+      struct {
+        uint64_t offsets[USB_INPUT_LATENCY_STAMPS];
+        TimeValue times[USB_INPUT_LATENCY_STAMPS];
+        unsigned int first;
+        unsigned int count;
+      } stamps;
     } input;
 
     struct {
-      char structMayNotBeEmpty;
+      struct {
+        Queue *requests;
+        size_t limit;
+        size_t size;
+        int error;
+        unsigned char unordered:1;
+      } pending;
     } output;
   } direction;
 };
@@ -104,7 +127,10 @@ extern UsbEndpoint *usbGetOutputEndpoint (UsbDevice *device, unsigned char endpo
 extern int usbApplyInputFilters (UsbEndpoint *endpoint, void *buffer, size_t size, ssize_t *length);
 
 extern void usbLogInputProblem (UsbEndpoint *endpoint, const char *problem);
-extern int usbHandleInputResponse (UsbEndpoint *endpoint, const void *buffer, size_t length);
+extern int usbHandleInputResponse (
+  UsbEndpoint *endpoint, const void *buffer, size_t length,
+  const TimeValue *completed
+);
 
 extern int usbSetSerialOperations (UsbDevice *device);
 
@@ -67,6 +67,20 @@ struct UsbDeviceExtensionStruct {
   AsyncHandle usbfsMonitorHandle;
 };
 
+/* The reap time travels with the URB so that input latency is measured
+ * from when its request was taken from the kernel.
+ */
+typedef struct {
+  struct usbdevfs_urb urb;
+  TimeValue reapTime;
+} UsbRequestBlock;
+
+static inline const TimeValue *
+usbGetReapTime (const struct usbdevfs_urb *urb) {
+  const UsbRequestBlock *block = (const UsbRequestBlock *)urb;
+  return &block->reapTime;
+}
+
 struct UsbEndpointExtensionStruct {
   Queue *completedRequests;
 
@@ -422,6 +436,7 @@ usbReapURB (UsbDevice *device, int wait) {
               &urb) != -1) {
       if (urb) {
         UsbEndpoint *endpoint;
+        getMonotonicTime(&((UsbRequestBlock *)urb)->reapTime);
 
         if ((endpoint = usbGetEndpoint(device, urb->endpoint))) {
           UsbEndpointExtension *eptx = endpoint->extension;
@@ -579,10 +594,12 @@ usbMakeURB (
   size_t length,
   void *context
 ) {
-  struct usbdevfs_urb *urb;
+  UsbRequestBlock *block;
+
+  if ((block = malloc(sizeof(*block) + length))) {
+    struct usbdevfs_urb *urb = &block->urb;
 
-  if ((urb = malloc(sizeof(*urb) + length))) {
-    memset(urb, 0, sizeof(*urb));
+    memset(block, 0, sizeof(*block));
     urb->endpoint = endpoint->bEndpointAddress;
     urb->flags = 0;
     urb->signr = 0;
@@ -591,7 +608,7 @@ usbMakeURB (
     if (!(urb->buffer_length = length)) {
       urb->buffer = NULL;
     } else {
-      urb->buffer = urb + 1;
+      urb->buffer = block + 1;
       if (buffer) memcpy(urb->buffer, buffer, length);
     }
 
@@ -734,6 +751,63 @@ usbCancelRequest (UsbDevice *device, void *request) {
   return 0;
 }
 
+static int
+usbHandleInputURB (UsbEndpoint *endpoint, struct usbdevfs_urb *urb) {
+  if (urb->actual_length < 0) {
+    usbLogInputProblem(endpoint, "data not available");
+    return 0;
+  }
+
+  return usbHandleInputResponse(endpoint, urb->buffer, urb->actual_length, usbGetReapTime(urb));
+}
+
+static int
+usbHandleCompletedInputRequest (UsbEndpoint *endpoint, struct usbdevfs_urb *urb) {
+  ssize_t count = urb->actual_length;
+  int error = urb->status;
+
+  if (!error) {
+    if (usbApplyInputFilters(endpoint, urb->buffer, urb->buffer_length, &count)) {
+      urb->actual_length = count;
+
+      if (usbHandleInputURB(endpoint, urb)) {
+        return 1;
+      }
+    }
+  } else {
+    if (error < 0) error = -error;
+    errno = error;
+    logSystemError("USB URB status");
+  }
+
+  return 0;
+}
+
+static int
+usbDispatchCompletedInputRequests (UsbEndpoint *endpoint) {
+  UsbEndpointExtension *eptx = endpoint->extension;
+
+  /* Completed output requests are left for their writer to reap. */
+  if (USB_ENDPOINT_DIRECTION(endpoint->descriptor) != UsbEndpointDirection_Input) return 1;
+
+  while (1) {
+    struct usbdevfs_urb *urb = dequeueItem(eptx->completedRequests);
+    if (!urb) break;
+    usbLogURB(urb, "reaped");
+
+    int handled = usbHandleCompletedInputRequest(endpoint, urb);
+    int error = errno;
+    free(urb);
+
+    if (!handled) {
+      usbSetEndpointInputError(endpoint, error);
+      return 0;
+    }
+  }
+
+  return 1;
+}
+
 void *
 usbReapResponse (
   UsbDevice *device,
@@ -741,6 +815,7 @@ usbReapResponse (
   UsbResponse *response,
   int wait
 ) {
+  UsbDeviceExtension *devx = device->extension;
   UsbEndpoint *endpoint;
 
   if ((endpoint = usbGetEndpoint(device, endpointAddress))) {
@@ -748,7 +823,16 @@ usbReapResponse (
     struct usbdevfs_urb *urb;
 
     while (!(urb = dequeueItem(eptx->completedRequests))) {
-      if (!usbReapURB(device, wait)) return NULL;
+      UsbEndpoint *reaped = usbReapURB(device, wait);
+      if (!reaped) return NULL;
+
+      /* Input for a piped endpoint mustn't wait for the USBFS monitor,
+       * which won't be woken up again for a request that's already been
+       * reaped.
+       */
+      if ((reaped != endpoint) && devx->usbfsMonitorHandle) {
+        usbDispatchCompletedInputRequests(reaped);
+      }
     }
 
     usbLogURB(urb, "reaped");
@@ -960,16 +1044,6 @@ usbReadDeviceDescriptor (UsbDevice *device) {
   return 1;
 }
 
-static int
-usbHandleInputURB (UsbEndpoint *endpoint, struct usbdevfs_urb *urb) {
-  if (urb->actual_length < 0) {
-    usbLogInputProblem(endpoint, "data not available");
-    return 0;
-  }
-
-  return usbHandleInputResponse(endpoint, urb->buffer, urb->actual_length);
-}
-
 static void
 usbInitializeSignalMonitor (UsbEndpointExtension *eptx) {
   eptx->monitor.signal.handle = NULL;
@@ -1060,28 +1134,6 @@ usbStopUsbfsMonitor (UsbDeviceExtension *devx) {
   }
 }
 
-static int
-usbHandleCompletedInputRequest (UsbEndpoint *endpoint, struct usbdevfs_urb *urb) {
-  ssize_t count = urb->actual_length;
-  int error = urb->status;
-
-  if (!error) {
-    if (usbApplyInputFilters(endpoint, urb->buffer, urb->buffer_length, &count)) {
-      urb->actual_length = count;
-
-      if (usbHandleInputURB(endpoint, urb)) {
-        return 1;
-      }
-    }
-  } else {
-    if (error < 0) error = -error;
-    errno = error;
-    logSystemError("USB URB status");
-  }
-
-  return 0;
-}
-
 ASYNC_MONITOR_CALLBACK(usbHandleCompletedInputRequests) {
   UsbDevice *device = parameters->data;
   UsbEndpoint *endpoint;
@@ -1096,27 +1148,41 @@ ASYNC_MONITOR_CALLBACK(usbHandleCompletedInputRequests) {
     }
   }
 
-  while ((endpoint = usbReapURB(device, 0))) {
-    UsbEndpointExtension *eptx = endpoint->extension;
+  /* The wakeup means that at least one request has completed. Reap all of
+   * the ones which are ready (up to a limit) before dispatching any of
+   * them so that the endpoints are serviced once per wakeup.
+   */
+  UsbEndpoint *endpoints[LINUX_USB_INPUT_REAP_LIMIT];
+  unsigned int endpointCount = 0;
+  unsigned int reapCount = 0;
+  int reapError = 0;
+
+  while (reapCount < LINUX_USB_INPUT_REAP_LIMIT) {
+    if (!(endpoint = usbReapURB(device, 0))) {
+      if (errno != EAGAIN) reapError = errno;
+      break;
+    }
 
-    while (1) {
-      struct usbdevfs_urb *urb = dequeueItem(eptx->completedRequests);
-      if (!urb) break;
-      usbLogURB(urb, "reaped");
+    reapCount += 1;
 
-      int handled = usbHandleCompletedInputRequest(endpoint, urb);
-      int error = errno;
-      free(urb);
+    {
+      unsigned int index = 0;
 
-      if (!handled) {
-        usbSetEndpointInputError(endpoint, error);
-        return 0;
+      while (index < endpointCount) {
+        if (endpoints[index] == endpoint) break;
+        index += 1;
       }
+
+      if (index == endpointCount) endpoints[endpointCount++] = endpoint;
     }
   }
 
-  if (errno == EAGAIN) return 1;
-  usbSetDeviceInputError(device, errno);
+  for (unsigned int index=0; index<endpointCount; index+=1) {
+    if (!usbDispatchCompletedInputRequests(endpoints[index])) return 0;
+  }
+
+  if (!reapError) return 1;
+  usbSetDeviceInputError(device, reapError);
   return 0;
 }
 
@@ -218,3 +218,22 @@ usbSetSerialParameters (UsbDevice *device, const SerialParameters *parameters) {
 
   return ok;
 }
+
+int
+usbSetSerialLatency (UsbDevice *device, SerialLatency latency) {
+  const UsbSerialOperations *serial = usbGetSerialOperations(device);
+
+  if (!serial) {
+    usbLogSerialProblem(device, "no serial operations");
+    errno = ENOSYS;
+    return 0;
+  }
+
+  if (!serial->setLatency) {
+    logMessage(LOG_CATEGORY(SERIAL_IO), "%s: latency not adjustable", serial->name);
+    errno = ENOSYS;
+    return 0;
+  }
+
+  return serial->setLatency(device, latency);
+}